@@ -33,130 +33,7 @@
 #include "runtime.h"
 #include "index.h"
 #include "pool.h"
-
-i64_t indexr_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
-    i64_t left, right, mid, idx;
-    left = 0, right = len - 1, idx = 0;
-    vals += offset;
-    while (left <= right) {
-        mid = left + (right - left) / 2;
-        if (vals[mid] <= val) {
-            idx = mid;
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
-    }
-
-    return idx + offset;
-}
-
-i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
-    i64_t left, right, mid, idx;
-    left = 0, right = len - 1, idx = 0;
-    vals += offset;
-    while (left <= right) {
-        mid = left + (right - left) / 2;
-        if (vals[mid] < val) {
-            left = mid + 1;
-        } else {
-            idx = mid;
-            right = mid - 1;
-        }
-    }
-
-    return idx + offset;
-}
-
-#define AGGR_ITER(Index, Len, Offset, Val, Res, Incoerce, Outcoerse, Ini, Aggr, Null)                  \
-    ({                                                                                                 \
-        i64_t $i, $x, $y, $n, $o, $li, $ri, $fi, $ti, $kl, $kr, $it;                                   \
-        i64_t *group_ids, *source, *filter, shift;                                                     \
-        obj_p $rn;                                                                                     \
-        index_type_t index_type;                                                                       \
-        Incoerce##_t *$in;                                                                             \
-        Outcoerse##_t *$out;                                                                           \
-        index_type = index_group_type(Index);                                                          \
-        $n = (index_type == INDEX_TYPE_PARTEDCOMMON) ? 1 : index_group_count(Index);                   \
-        if (index_type == INDEX_TYPE_WINDOW)                                                           \
-            $n = Len;                                                                                  \
-        $o = (index_type == INDEX_TYPE_WINDOW) ? Offset : 0;                                           \
-        group_ids = index_group_ids(Index);                                                            \
-        $in = __AS_##Incoerce(Val);                                                                    \
-        $out = __AS_##Outcoerse(Res);                                                                  \
-        for ($y = $o; $y < $n + $o; ++$y) {                                                            \
-            Ini;                                                                                       \
-        }                                                                                              \
-        filter = index_group_filter_ids(Index);                                                        \
-        switch (index_type) {                                                                          \
-            case INDEX_TYPE_SHIFT:                                                                     \
-                source = index_group_source(Index);                                                    \
-                shift = index_group_shift(Index);                                                      \
-                if (filter != NULL) {                                                                  \
-                    for ($i = 0; $i < Len; ++$i) {                                                     \
-                        $x = filter[$i + Offset];                                                      \
-                        $y = group_ids[source[$x] - shift];                                            \
-                        Aggr;                                                                          \
-                    }                                                                                  \
-                } else {                                                                               \
-                    for ($i = 0; $i < Len; ++$i) {                                                     \
-                        $x = $i + Offset;                                                              \
-                        $y = group_ids[source[$x] - shift];                                            \
-                        Aggr;                                                                          \
-                    }                                                                                  \
-                }                                                                                      \
-                break;                                                                                 \
-            case INDEX_TYPE_IDS:                                                                       \
-                if (filter != NULL) {                                                                  \
-                    for ($i = 0; $i < Len; ++$i) {                                                     \
-                        $x = filter[$i + Offset];                                                      \
-                        $y = group_ids[$i + Offset];                                                   \
-                        Aggr;                                                                          \
-                    }                                                                                  \
-                } else {                                                                               \
-                    for ($i = 0; $i < Len; ++$i) {                                                     \
-                        $x = $i + Offset;                                                              \
-                        $y = group_ids[$x];                                                            \
-                        Aggr;                                                                          \
-                    }                                                                                  \
-                }                                                                                      \
-                break;                                                                                 \
-            case INDEX_TYPE_PARTEDCOMMON:                                                              \
-                for ($i = 0; $i < Len; ++$i) {                                                         \
-                    $x = $i + Offset;                                                                  \
-                    $y = 0;                                                                            \
-                    Aggr;                                                                              \
-                }                                                                                      \
-                break;                                                                                 \
-            case INDEX_TYPE_WINDOW:                                                                    \
-                $it = index_group_meta(Index)->i64;                                                    \
-                for ($i = Offset; $i < Offset + Len; ++$i) {                                           \
-                    $y = $i;                                                                           \
-                    $rn = AS_LIST(AS_LIST(Index)[5])[$i];                                              \
-                    if ($rn != NULL_OBJ) {                                                             \
-                        $fi = AS_I64($rn)[0];                                                          \
-                        $ti = AS_I64($rn)[1];                                                          \
-                        $kl = AS_I32(AS_LIST(AS_LIST(Index)[4])[0])[$i];                               \
-                        $kr = AS_I32(AS_LIST(AS_LIST(Index)[4])[1])[$i];                               \
-                        if ($it == 0) {                                                                \
-                            $li = indexr_bin_i32_($kl, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1); \
-                        } else {                                                                       \
-                            $li = indexl_bin_i32_($kl, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1); \
-                        }                                                                              \
-                        $ri = indexr_bin_i32_($kr, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1);     \
-                    }                                                                                  \
-                    if ($rn == NULL_OBJ || AS_I32(AS_LIST(Index)[3])[$li] > $kr ||                     \
-                        ($it == 1 && AS_I32(AS_LIST(Index)[3])[$ri] < $kl)) {                          \
-                        Null;                                                                          \
-                    } else {                                                                           \
-                        for ($x = $li; $x <= $ri; ++$x) {                                              \
-                            Aggr;                                                                      \
-                        }                                                                              \
-                    }                                                                                  \
-                }                                                                                      \
-                break;                                                                                 \
-        }                                                                                              \
-    })
+#include "serde.h"
 
 #define AGGR_COLLECT(parts, groups, incoerse, outcoerse, aggr) \
     ({                                                         \
@@ -197,6 +74,147 @@ i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
         $$res;                                                                                        \
     })
 
+static obj_p aggr_range_count_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p counts, i64_t width) {
+    i64_t *cnt = AS_I64(counts);
+
+    AGGR_ITER(
+        index, len, offset, val, counts, i64, i64, ,
+        {
+            UNUSED($in);
+            UNUSED($out);
+            cnt[$y / width]++;
+        }, );
+
+    return NULL_OBJ;
+}
+
+static obj_p aggr_range_scatter_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p pos, i64_t width,
+                                        obj_p rows, obj_p ids) {
+    i64_t r, p, *at = AS_I64(pos);
+
+    AGGR_ITER(
+        index, len, offset, val, pos, i64, i64, ,
+        {
+            UNUSED($in);
+            UNUSED($out);
+            r = $y / width;
+            p = at[r]++;
+            AS_I64(AS_LIST(rows)[r])[p] = $x;
+            AS_I64(AS_LIST(ids)[r])[p] = $y - r * width;
+        }, );
+
+    return NULL_OBJ;
+}
+
+// Too many groups to replicate the partials per task: the rows are partitioned by
+// group id range (a counting pass and a scatter pass over row chunks), then every
+// task aggregates the rows of its range into a partial of the range size only and
+// the partials are laid end to end
+static obj_p aggr_map_ranged(raw_p aggr, obj_p val, i8_t outype, obj_p index, i64_t n) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, j, l, r, lo, size, chunk, width, ranges, group_count, *base;
+    obj_p v, counts, rows, ids, slices, parts, res;
+
+    group_count = index_group_count(index);
+    l = index_group_len(index);
+    width = (group_count + n - 1) / n;
+    ranges = (group_count + width - 1) / width;
+    chunk = l / n;
+
+    counts = LIST(n);
+    for (i = 0; i < n; i++) {
+        AS_LIST(counts)[i] = vector(TYPE_I64, ranges);
+        memset(AS_I64(AS_LIST(counts)[i]), 0, ranges * sizeof(i64_t));
+    }
+
+    pool_prepare(pool);
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)aggr_range_count_partial, 6, chunk, i * chunk, val, index, AS_LIST(counts)[i],
+                      width);
+
+    pool_add_task(pool, (raw_p)aggr_range_count_partial, 6, l - i * chunk, i * chunk, val, index,
+                  AS_LIST(counts)[i], width);
+
+    v = pool_run(pool);
+    if (IS_ERR(v)) {
+        drop_obj(counts);
+        return v;
+    }
+
+    drop_obj(v);
+
+    // Counts become the positions every chunk writes its rows from
+    rows = LIST(ranges);
+    ids = LIST(ranges);
+    for (r = 0; r < ranges; r++) {
+        for (i = 0, size = 0; i < n; i++) {
+            base = AS_I64(AS_LIST(counts)[i]);
+            j = base[r];
+            base[r] = size;
+            size += j;
+        }
+
+        AS_LIST(rows)[r] = vector(TYPE_I64, size);
+        AS_LIST(ids)[r] = vector(TYPE_I64, size);
+    }
+
+    pool_prepare(pool);
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)aggr_range_scatter_partial, 8, chunk, i * chunk, val, index, AS_LIST(counts)[i],
+                      width, rows, ids);
+
+    pool_add_task(pool, (raw_p)aggr_range_scatter_partial, 8, l - i * chunk, i * chunk, val, index,
+                  AS_LIST(counts)[i], width, rows, ids);
+
+    v = pool_run(pool);
+    drop_obj(counts);
+    if (IS_ERR(v)) {
+        drop_obj(rows);
+        drop_obj(ids);
+        return v;
+    }
+
+    drop_obj(v);
+
+    // Every range is a group index of its own over the rows it got
+    slices = LIST(ranges);
+    for (r = 0; r < ranges; r++) {
+        lo = r * width;
+        size = (group_count - lo < width) ? group_count - lo : width;
+        AS_LIST(slices)[r] = index_group_slice(size, clone_obj(AS_LIST(ids)[r]), clone_obj(AS_LIST(rows)[r]));
+    }
+
+    drop_obj(rows);
+    drop_obj(ids);
+
+    pool_prepare(pool);
+    for (r = 0; r < ranges; r++) {
+        v = AS_LIST(slices)[r];
+        size = index_group_count(v);
+        pool_add_task(pool, aggr, 5, index_group_len(v), 0, val, v, vector(outype, size));
+    }
+
+    parts = pool_run(pool);
+    drop_obj(slices);
+    if (IS_ERR(parts))
+        return parts;
+
+    size = size_of_type(outype);
+    res = vector(outype, group_count);
+    for (r = 0; r < ranges; r++) {
+        v = AS_LIST(parts)[r];
+        memcpy(AS_C8(res) + r * width * size, AS_C8(v), v->len * size);
+
+        // The items of a list move to the result
+        if (outype == TYPE_LIST)
+            v->len = 0;
+    }
+
+    drop_obj(parts);
+
+    return vn_list(1, res);
+}
+
 static obj_p aggr_map_other(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     pool_p pool = runtime_get()->pool;
     i64_t i, l, n, group_count, group_len, out_len, chunk;
@@ -207,6 +225,12 @@ static obj_p aggr_map_other(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     group_len = index_group_len(index);
     out_len = group_count;
 
+    // A full partial per task pays off only while they are small against the rows
+    n = pool_split_by(pool, group_len, 0);
+    if (n > 1 && group_count > 0 &&
+        (group_count * n > group_len || pool_split_by(pool, group_len, group_count) == 1))
+        return aggr_map_ranged(aggr, val, outype, index, n);
+
     n = pool_split_by(pool, group_len, group_count);
 
     if (n == 1) {
@@ -275,10 +299,10 @@ static obj_p aggr_map_window(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     group_len = index_group_len(index);
     out_len = group_count;
 
-    n = pool_get_executors_count(pool);
+    n = MINI64(pool_get_executors_count(pool), group_count);
     res = vector(outype, out_len);
 
-    if (n == 1) {
+    if (n <= 1) {
         argv[0] = (raw_p)group_len;
         argv[1] = (raw_p)0;
         argv[2] = val;
@@ -288,9 +312,6 @@ static obj_p aggr_map_window(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
         return vn_list(1, res);
     }
 
-    if (n > group_count)
-        n = group_count;
-
     pool_prepare(pool);
     l = group_len;
     chunk = l / n;
@@ -323,6 +344,203 @@ static obj_p aggr_map(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     }
 }
 
+// Window-join aggregates kept up to date as the windows slide. Left rows are walked by window start,
+// so the rows entering a window are added and the rows leaving it are dropped instead of rescanning
+// it. A window that does not overlap the previous one, as the first one of another key, restarts.
+typedef enum aggr_window_kind_t {
+    AGGR_WINDOW_SUM = 0,
+    AGGR_WINDOW_MIN,
+    AGGR_WINDOW_MAX,
+} aggr_window_kind_t;
+
+#define AGGR_WINDOW_NIL_i64(v) ((v) == NULL_I64)
+#define AGGR_WINDOW_NIL_f64(v) ISNANF64(v)
+
+// Sum of the non-null rows in [$l, $h], null if any row of it is
+#define AGGR_WINDOW_SUM_ITER(index, len, offset, val, res, t)               \
+    ({                                                                      \
+        i64_t $j, $i, $lo, $hi, $l = 0, $h = -1, $nn = 0;                   \
+        i64_t *$los = index_window_lo(index), *$his = index_window_hi(index); \
+        i64_t *$ord = index_window_order(index);                            \
+        t##_t $s = 0, *$in = __AS_##t(val), *$out = __AS_##t(res);          \
+        for ($j = (offset); $j < (offset) + (len); $j++) {                  \
+            $i = $ord ? $ord[$j] : $j;                                      \
+            $lo = $los[$i];                                                 \
+            $hi = $his[$i];                                                 \
+            if ($lo > $hi) {                                                \
+                $out[$i] = __NULL_##t;                                      \
+                continue;                                                   \
+            }                                                               \
+            if ($lo > $h || $hi < $l) {                                     \
+                $l = $lo;                                                   \
+                $h = $lo - 1;                                               \
+                $s = 0;                                                     \
+                $nn = 0;                                                    \
+            }                                                               \
+            for (; $h < $hi; $h++) {                                        \
+                if (AGGR_WINDOW_NIL_##t($in[$h + 1]))                       \
+                    $nn++;                                                  \
+                else                                                        \
+                    $s += $in[$h + 1];                                      \
+            }                                                               \
+            for (; $h > $hi; $h--) {                                        \
+                if (AGGR_WINDOW_NIL_##t($in[$h]))                           \
+                    $nn--;                                                  \
+                else                                                        \
+                    $s -= $in[$h];                                          \
+            }                                                               \
+            for (; $l < $lo; $l++) {                                        \
+                if (AGGR_WINDOW_NIL_##t($in[$l]))                           \
+                    $nn--;                                                  \
+                else                                                        \
+                    $s -= $in[$l];                                          \
+            }                                                               \
+            for (; $l > $lo; $l--) {                                        \
+                if (AGGR_WINDOW_NIL_##t($in[$l - 1]))                       \
+                    $nn++;                                                  \
+                else                                                        \
+                    $s += $in[$l - 1];                                      \
+            }                                                               \
+            $out[$i] = $nn ? __NULL_##t : $s;                               \
+        }                                                                   \
+    })
+
+// Monotonic deque of the non-null rows in [lo, h], its head being the extremum of the window.
+// Window starts never go back in the walk, a window ending before the previous one restarts.
+#define AGGR_WINDOW_EXT_ITER(index, len, offset, val, res, t, cmp, empty)         \
+    ({                                                                            \
+        i64_t $j, $i, $lo, $hi, $w, $h = -1, $qh = 0, $qt = 0, $c, *$q;           \
+        i64_t *$los = index_window_lo(index), *$his = index_window_hi(index);     \
+        i64_t *$ord = index_window_order(index);                                  \
+        t##_t *$in = __AS_##t(val), *$out = __AS_##t(res);                        \
+        for ($j = (offset), $w = 1; $j < (offset) + (len); $j++) {                \
+            $i = $ord ? $ord[$j] : $j;                                            \
+            $w = MAXI64($w, $his[$i] - $los[$i] + 1);                             \
+        }                                                                         \
+        for ($c = 1; $c < $w; $c <<= 1)                                           \
+            ;                                                                     \
+        $q = (i64_t *)heap_alloc($c * sizeof(i64_t));                             \
+        $c -= 1;                                                                  \
+        for ($j = (offset); $j < (offset) + (len); $j++) {                        \
+            $i = $ord ? $ord[$j] : $j;                                            \
+            $lo = $los[$i];                                                       \
+            $hi = $his[$i];                                                       \
+            if ($lo > $hi) {                                                      \
+                $out[$i] = __NULL_##t;                                            \
+                continue;                                                         \
+            }                                                                     \
+            if ($lo > $h || $hi < $h) {                                           \
+                $h = $lo - 1;                                                     \
+                $qh = $qt = 0;                                                    \
+            }                                                                     \
+            while ($qh < $qt && $q[$qh & $c] < $lo)                               \
+                $qh++;                                                            \
+            for (; $h < $hi; $h++) {                                              \
+                if (AGGR_WINDOW_NIL_##t($in[$h + 1]))                             \
+                    continue;                                                     \
+                while ($qh < $qt && $in[$q[($qt - 1) & $c]] cmp $in[$h + 1])      \
+                    $qt--;                                                        \
+                $q[$qt++ & $c] = $h + 1;                                          \
+            }                                                                     \
+            $out[$i] = ($qh < $qt) ? $in[$q[$qh & $c]] : (empty);                 \
+        }                                                                         \
+        heap_free($q);                                                            \
+    })
+
+static obj_p aggr_window_partial(i64_t kind, i64_t len, i64_t offset, obj_p val, obj_p index, obj_p res) {
+    switch (MTYPE2(kind, val->type)) {
+        case MTYPE2(AGGR_WINDOW_SUM, TYPE_I64):
+            AGGR_WINDOW_SUM_ITER(index, len, offset, val, res, i64);
+            return NULL_OBJ;
+        case MTYPE2(AGGR_WINDOW_SUM, TYPE_F64):
+            AGGR_WINDOW_SUM_ITER(index, len, offset, val, res, f64);
+            return NULL_OBJ;
+        case MTYPE2(AGGR_WINDOW_MIN, TYPE_I64):
+            AGGR_WINDOW_EXT_ITER(index, len, offset, val, res, i64, >=, INF_I64);
+            return NULL_OBJ;
+        case MTYPE2(AGGR_WINDOW_MIN, TYPE_F64):
+            AGGR_WINDOW_EXT_ITER(index, len, offset, val, res, f64, >=, INF_F64);
+            return NULL_OBJ;
+        case MTYPE2(AGGR_WINDOW_MAX, TYPE_I64):
+            AGGR_WINDOW_EXT_ITER(index, len, offset, val, res, i64, <=, NULL_I64);
+            return NULL_OBJ;
+        case MTYPE2(AGGR_WINDOW_MAX, TYPE_F64):
+            AGGR_WINDOW_EXT_ITER(index, len, offset, val, res, f64, <=, NULL_F64);
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "window aggregate: unsupported type: '%s'", type_name(val->type));
+    }
+}
+
+// Windows of the left rows at positions a - 1 and a of the walk share rows
+static b8_t aggr_window_overlap(obj_p index, i64_t a) {
+    i64_t *lo = index_window_lo(index), *hi = index_window_hi(index), *ord = index_window_order(index);
+    i64_t p = ord ? ord[a - 1] : a - 1, q = ord ? ord[a] : a;
+
+    return lo[p] <= hi[p] && lo[q] <= hi[q] && lo[q] <= hi[p];
+}
+
+static obj_p aggr_window(aggr_window_kind_t kind, obj_p val, obj_p index) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, b, chunk, start, end;
+    obj_p v, res;
+
+    l = index_group_count(index);
+    res = vector(val->type, l);
+    n = pool_split_by(pool, l, 0);
+
+    if (n == 1) {
+        v = aggr_window_partial(kind, l, 0, val, index, res);
+        if (IS_ERR(v)) {
+            drop_obj(res);
+            return v;
+        }
+
+        return res;
+    }
+
+    // Split the walk by keys: a chunk ends where the windows stop overlapping, which is at the latest
+    // where the key changes, or at the end of the next chunk if a key spans it
+    pool_prepare(pool);
+    chunk = l / n;
+
+    for (i = 1, start = 0; i <= n && start < l; i++) {
+        end = (i == n) ? l : MAXI64(start + 1, i * chunk);
+        for (b = end; b < l && b < end + chunk && aggr_window_overlap(index, b); b++)
+            ;
+        if (b == l || !aggr_window_overlap(index, b))
+            end = b;
+        pool_add_task(pool, (raw_p)aggr_window_partial, 6, (i64_t)kind, end - start, start, val, index, res);
+        start = end;
+    }
+
+    v = pool_run(pool);
+    if (IS_ERR(v)) {
+        drop_obj(res);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return res;
+}
+
+static obj_p aggr_window_count(obj_p index) {
+    i64_t i, l, *lo, *hi, *out;
+    obj_p res;
+
+    l = index_group_count(index);
+    lo = index_window_lo(index);
+    hi = index_window_hi(index);
+    res = I64(l);
+    out = AS_I64(res);
+
+    for (i = 0; i < l; i++)
+        out[i] = (lo[i] > hi[i]) ? 0 : hi[i] - lo[i] + 1;
+
+    return res;
+}
+
 nil_t destroy_partial_result(obj_p res) {
     res->len = 0;
     drop_obj(res);
@@ -663,6 +881,9 @@ obj_p aggr_sum(obj_p val, obj_p index) {
     i64_t n;
     obj_p parts, res;
 
+    if (index_group_type(index) == INDEX_TYPE_WINDOW && (val->type == TYPE_I64 || val->type == TYPE_F64))
+        return aggr_window(AGGR_WINDOW_SUM, val, index);
+
     n = index_group_count(index);
 
     switch (val->type) {
@@ -713,6 +934,9 @@ obj_p aggr_max(obj_p val, obj_p index) {
     i64_t n;
     obj_p parts, res;
 
+    if (index_group_type(index) == INDEX_TYPE_WINDOW && (val->type == TYPE_I64 || val->type == TYPE_F64))
+        return aggr_window(AGGR_WINDOW_MAX, val, index);
+
     n = index_group_count(index);
 
     switch (val->type) {
@@ -762,6 +986,9 @@ obj_p aggr_min(obj_p val, obj_p index) {
     i64_t n;
     obj_p parts, res;
 
+    if (index_group_type(index) == INDEX_TYPE_WINDOW && (val->type == TYPE_I64 || val->type == TYPE_F64))
+        return aggr_window(AGGR_WINDOW_MIN, val, index);
+
     n = index_group_count(index);
     parts = aggr_map((raw_p)aggr_min_partial, val, val->type, index);
     if (IS_ERR(parts))
@@ -847,6 +1074,10 @@ obj_p aggr_count_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p a
 obj_p aggr_count(obj_p val, obj_p index) {
     i64_t n;
     obj_p parts, res;
+
+    if (index_group_type(index) == INDEX_TYPE_WINDOW)
+        return aggr_window_count(index);
+
     n = index_group_count(index);
     parts = aggr_map((raw_p)aggr_count_partial, val, TYPE_I64, index);
     if (IS_ERR(parts))
@@ -1012,3 +1243,64 @@ obj_p aggr_row(obj_p val, obj_p index) {
 
     return res;
 }
+
+static obj_p aggr_scatter_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p col) {
+    switch (col->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+            AGGR_ITER(index, len, offset, val, col, u8, u8, , $out[$x] = $in[$y], );
+            return NULL_OBJ;
+        case TYPE_I16:
+            AGGR_ITER(index, len, offset, val, col, i16, i16, , $out[$x] = $in[$y], );
+            return NULL_OBJ;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            AGGR_ITER(index, len, offset, val, col, i32, i32, , $out[$x] = $in[$y], );
+            return NULL_OBJ;
+        case TYPE_I64:
+        case TYPE_SYMBOL:
+        case TYPE_TIMESTAMP:
+            AGGR_ITER(index, len, offset, val, col, i64, i64, , $out[$x] = $in[$y], );
+            return NULL_OBJ;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, col, f64, f64, , $out[$x] = $in[$y], );
+            return NULL_OBJ;
+        case TYPE_GUID:
+            AGGR_ITER(index, len, offset, val, col, guid, guid, , memcpy($out[$x], $in[$y], sizeof(guid_t)), );
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "scatter: unsupported type: '%s", type_name(col->type));
+    }
+}
+
+// Writes one value per group back to every row of the group: col[row] = val[group(row)].
+// The column must be of the same fixed width type as val.
+obj_p aggr_scatter(obj_p val, obj_p index, obj_p col) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, chunk;
+    raw_p argv[5];
+
+    l = index_group_len(index);
+    n = pool_split_by(pool, l, 0);
+
+    if (n == 1) {
+        argv[0] = (raw_p)l;
+        argv[1] = (raw_p)0;
+        argv[2] = val;
+        argv[3] = index;
+        argv[4] = col;
+        return pool_call_task_fn((raw_p)aggr_scatter_partial, 5, argv);
+    }
+
+    pool_prepare(pool);
+    chunk = l / n;
+
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)aggr_scatter_partial, 5, chunk, i * chunk, val, index, col);
+
+    pool_add_task(pool, (raw_p)aggr_scatter_partial, 5, l - i * chunk, i * chunk, val, index, col);
+
+    return pool_run(pool);
+}
@@ -25,6 +25,8 @@
 #define AGGR_H
 
 #include "rayforce.h"
+#include "index.h"
+#include "util.h"
 
 obj_p aggr_sum(obj_p val, obj_p index);
 obj_p aggr_first(obj_p val, obj_p index);
@@ -37,5 +39,83 @@ obj_p aggr_med(obj_p val, obj_p index);
 obj_p aggr_dev(obj_p val, obj_p index);
 obj_p aggr_collect(obj_p val, obj_p index);
 obj_p aggr_row(obj_p val, obj_p index);
+obj_p aggr_scatter(obj_p val, obj_p index, obj_p col);
+
+// Walks rows [Offset, Offset + Len) of a group index: $x is the row of Val, $y its group
+#define AGGR_ITER(Index, Len, Offset, Val, Res, Incoerce, Outcoerse, Ini, Aggr, Null)                  \
+    ({                                                                                                 \
+        i64_t $i, $x, $y, $n, $o, $li, $ri;                                                            \
+        i64_t *group_ids, *source, *filter, shift;                                                     \
+        index_type_t index_type;                                                                       \
+        Incoerce##_t *$in;                                                                             \
+        Outcoerse##_t *$out;                                                                           \
+        index_type = index_group_type(Index);                                                          \
+        $n = (index_type == INDEX_TYPE_PARTEDCOMMON) ? 1 : index_group_count(Index);                   \
+        if (index_type == INDEX_TYPE_WINDOW)                                                           \
+            $n = Len;                                                                                  \
+        $o = (index_type == INDEX_TYPE_WINDOW) ? Offset : 0;                                           \
+        group_ids = index_group_ids(Index);                                                            \
+        $in = __AS_##Incoerce(Val);                                                                    \
+        $out = __AS_##Outcoerse(Res);                                                                  \
+        for ($y = $o; $y < $n + $o; ++$y) {                                                            \
+            Ini;                                                                                       \
+        }                                                                                              \
+        filter = index_group_filter_ids(Index);                                                        \
+        switch (index_type) {                                                                          \
+            case INDEX_TYPE_SHIFT:                                                                     \
+                source = index_group_source(Index);                                                    \
+                shift = index_group_shift(Index);                                                      \
+                if (filter != NULL) {                                                                  \
+                    for ($i = 0; $i < Len; ++$i) {                                                     \
+                        $x = filter[$i + Offset];                                                      \
+                        $y = group_ids[source[$x] - shift];                                            \
+                        Aggr;                                                                          \
+                    }                                                                                  \
+                } else {                                                                               \
+                    for ($i = 0; $i < Len; ++$i) {                                                     \
+                        $x = $i + Offset;                                                              \
+                        $y = group_ids[source[$x] - shift];                                            \
+                        Aggr;                                                                          \
+                    }                                                                                  \
+                }                                                                                      \
+                break;                                                                                 \
+            case INDEX_TYPE_IDS:                                                                       \
+                if (filter != NULL) {                                                                  \
+                    for ($i = 0; $i < Len; ++$i) {                                                     \
+                        $x = filter[$i + Offset];                                                      \
+                        $y = group_ids[$i + Offset];                                                   \
+                        Aggr;                                                                          \
+                    }                                                                                  \
+                } else {                                                                               \
+                    for ($i = 0; $i < Len; ++$i) {                                                     \
+                        $x = $i + Offset;                                                              \
+                        $y = group_ids[$x];                                                            \
+                        Aggr;                                                                          \
+                    }                                                                                  \
+                }                                                                                      \
+                break;                                                                                 \
+            case INDEX_TYPE_PARTEDCOMMON:                                                              \
+                for ($i = 0; $i < Len; ++$i) {                                                         \
+                    $x = $i + Offset;                                                                  \
+                    $y = 0;                                                                            \
+                    Aggr;                                                                              \
+                }                                                                                      \
+                break;                                                                                 \
+            case INDEX_TYPE_WINDOW:                                                                    \
+                for ($i = Offset; $i < Offset + Len; ++$i) {                                           \
+                    $y = $i;                                                                           \
+                    $li = group_ids[$i];                                                               \
+                    $ri = index_window_hi(Index)[$i];                                                  \
+                    if ($li > $ri) {                                                                   \
+                        Null;                                                                          \
+                    } else {                                                                           \
+                        for ($x = $li; $x <= $ri; ++$x) {                                              \
+                            Aggr;                                                                      \
+                        }                                                                              \
+                    }                                                                                  \
+                }                                                                                      \
+                break;                                                                                 \
+        }                                                                                              \
+    })
 
 #endif  // AGGR_H
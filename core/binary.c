@@ -59,7 +59,7 @@ obj_p binary_set(obj_p x, obj_p y) {
 
     switch (x->type) {
         case -TYPE_SYMBOL:
-            res = set_obj(&runtime_get()->env.variables, x, clone_obj(y));
+            res = env_set(&runtime_get()->env, x, clone_obj(y));
 
             if (y && y->type == TYPE_LAMBDA) {
                 if (is_null(AS_LAMBDA(y)->name))
@@ -29,6 +29,7 @@
 #include "items.h"
 #include "runtime.h"
 #include "pool.h"
+#include "symbols.h"
 
 typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
 
@@ -70,9 +71,9 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
 #define __DECLARE_CMP_FN(op)                                                                                \
     obj_p ray_##op##_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res) {                        \
         i64_t i;                                                                                            \
-        i64_t *xi, *ei, si;                                                                                 \
+        i64_t n, *xi, *yi, *ei;                                                                             \
         b8_t *out;                                                                                          \
-        obj_p k, sym, e;                                                                                    \
+        obj_p sym, t;                                                                                       \
                                                                                                             \
         switch (MTYPE2(x->type, y->type)) {                                                                 \
             case MTYPE2(-TYPE_B8, -TYPE_B8):                                                                \
@@ -171,7 +172,6 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
             case MTYPE2(-TYPE_I64, -TYPE_I32):                                                              \
                 return b8(op##I64(x->i64, i32_to_i64(y->i32)));                                             \
             case MTYPE2(-TYPE_I64, -TYPE_I64):                                                              \
-            case MTYPE2(-TYPE_SYMBOL, -TYPE_SYMBOL):                                                        \
             case MTYPE2(-TYPE_TIMESTAMP, -TYPE_TIMESTAMP):                                                  \
                 return b8(op##I64(x->i64, y->i64));                                                         \
             case MTYPE2(-TYPE_I64, -TYPE_F64):                                                              \
@@ -181,7 +181,6 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
             case MTYPE2(-TYPE_I64, TYPE_I32):                                                               \
                 return __CMP_A_V(x, y, i64, i32, i64, op##I64, len, offset, res);                           \
             case MTYPE2(-TYPE_I64, TYPE_I64):                                                               \
-            case MTYPE2(-TYPE_SYMBOL, TYPE_SYMBOL):                                                         \
             case MTYPE2(-TYPE_TIMESTAMP, TYPE_TIMESTAMP):                                                   \
                 return __CMP_A_V(x, y, i64, i64, i64, op##I64, len, offset, res);                           \
             case MTYPE2(-TYPE_I64, TYPE_F64):                                                               \
@@ -191,7 +190,6 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
             case MTYPE2(TYPE_I64, -TYPE_I32):                                                               \
                 return __CMP_V_A(x, y, i64, i32, i64, op##I64, len, offset, res);                           \
             case MTYPE2(TYPE_I64, -TYPE_I64):                                                               \
-            case MTYPE2(TYPE_SYMBOL, -TYPE_SYMBOL):                                                         \
             case MTYPE2(TYPE_TIMESTAMP, -TYPE_TIMESTAMP):                                                   \
                 return __CMP_V_A(x, y, i64, i64, i64, op##I64, len, offset, res);                           \
             case MTYPE2(TYPE_I64, -TYPE_F64):                                                               \
@@ -201,7 +199,6 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
             case MTYPE2(TYPE_I64, TYPE_I32):                                                                \
                 return __CMP_V_V(x, y, i64, i32, i64, op##I64, len, offset, res);                           \
             case MTYPE2(TYPE_I64, TYPE_I64):                                                                \
-            case MTYPE2(TYPE_SYMBOL, TYPE_SYMBOL):                                                          \
             case MTYPE2(TYPE_TIMESTAMP, TYPE_TIMESTAMP):                                                    \
                 return __CMP_V_V(x, y, i64, i64, i64, op##I64, len, offset, res);                           \
             case MTYPE2(TYPE_I64, TYPE_F64):                                                                \
@@ -257,54 +254,80 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
             case MTYPE2(TYPE_TIMESTAMP, TYPE_DATE):                                                         \
                 return __CMP_V_V(x, y, timestamp, date, timestamp, op##I64, len, offset, res);              \
                                                                                                             \
+            case MTYPE2(-TYPE_SYMBOL, -TYPE_SYMBOL):                                                        \
+                return b8(op##SYM(x->i64, y->i64));                                                         \
+            case MTYPE2(-TYPE_SYMBOL, TYPE_SYMBOL):                                                         \
+                return __CMP_A_V(x, y, symbol, symbol, symbol, op##SYM, len, offset, res);                  \
+            case MTYPE2(TYPE_SYMBOL, -TYPE_SYMBOL):                                                         \
+                return __CMP_V_A(x, y, symbol, symbol, symbol, op##SYM, len, offset, res);                  \
+            case MTYPE2(TYPE_SYMBOL, TYPE_SYMBOL):                                                          \
+                return __CMP_V_V(x, y, symbol, symbol, symbol, op##SYM, len, offset, res);                  \
+                                                                                                            \
             case MTYPE2(TYPE_ENUM, -TYPE_SYMBOL):                                                           \
-                k = ray_key(x);                                                                             \
-                sym = ray_get(k);                                                                           \
-                drop_obj(k);                                                                                \
+                sym = enum_domain(x);                                                                       \
+                if (is_null(sym))                                                                           \
+                    THROW(ERR_TYPE, "eq: invalid enum");                                                    \
                                                                                                             \
-                e = ENUM_VAL(x);                                                                            \
+                /* compare the dictionary entries once and map the codes through the result */              \
+                xi = AS_I64(sym);                                                                           \
+                n = sym->len;                                                                               \
+                t = B8(n + 1);                                                                              \
+                for (i = 0; i < n; i++)                                                                     \
+                    AS_B8(t)[i] = op##SYM(xi[i], y->i64);                                                   \
+                AS_B8(t)[n] = op##SYM(NULL_I64, y->i64);                                                    \
+                drop_obj(sym);                                                                              \
                                                                                                             \
-                if (is_null(sym) || sym->type != TYPE_SYMBOL) {                                             \
-                    drop_obj(sym);                                                                          \
+                enum_map_b8(AS_I64(ENUM_VAL(x)) + offset, len, AS_B8(t), n, AS_B8(res) + offset);           \
+                drop_obj(t);                                                                                \
+                return res;                                                                                 \
+            case MTYPE2(-TYPE_SYMBOL, TYPE_ENUM):                                                           \
+                sym = enum_domain(y);                                                                       \
+                if (is_null(sym))                                                                           \
                     THROW(ERR_TYPE, "eq: invalid enum");                                                    \
-                }                                                                                           \
                                                                                                             \
                 xi = AS_I64(sym);                                                                           \
-                ei = AS_I64(e) + offset;                                                                    \
-                si = y->i64;                                                                                \
+                n = sym->len;                                                                               \
+                t = B8(n + 1);                                                                              \
+                for (i = 0; i < n; i++)                                                                     \
+                    AS_B8(t)[i] = op##SYM(x->i64, xi[i]);                                                   \
+                AS_B8(t)[n] = op##SYM(x->i64, NULL_I64);                                                    \
+                drop_obj(sym);                                                                              \
+                                                                                                            \
+                enum_map_b8(AS_I64(ENUM_VAL(y)) + offset, len, AS_B8(t), n, AS_B8(res) + offset);           \
+                drop_obj(t);                                                                                \
+                return res;                                                                                 \
+            case MTYPE2(TYPE_ENUM, TYPE_SYMBOL):                                                            \
+                sym = enum_domain(x);                                                                       \
+                if (is_null(sym))                                                                           \
+                    THROW(ERR_TYPE, "eq: invalid enum");                                                    \
+                                                                                                            \
+                xi = AS_I64(sym);                                                                           \
+                n = sym->len;                                                                               \
+                ei = AS_I64(ENUM_VAL(x)) + offset;                                                          \
+                yi = AS_I64(y) + offset;                                                                    \
                 out = AS_B8(res) + offset;                                                                  \
                                                                                                             \
                 for (i = 0; i < len; i++)                                                                   \
-                    out[i] = xi[ei[i]] == si;                                                               \
+                    out[i] = op##SYM(((u64_t)ei[i] < (u64_t)n) ? xi[ei[i]] : NULL_I64, yi[i]);              \
                                                                                                             \
                 drop_obj(sym);                                                                              \
                 return res;                                                                                 \
-            case MTYPE2(-TYPE_SYMBOL, TYPE_ENUM):                                                           \
-                return ray_##op##_partial(y, x, len, offset, res);                                          \
-            case MTYPE2(TYPE_ENUM, TYPE_SYMBOL):                                                            \
-                k = ray_key(y);                                                                             \
-                sym = ray_get(k);                                                                           \
-                drop_obj(k);                                                                                \
-                                                                                                            \
-                e = ENUM_VAL(y);                                                                            \
-                                                                                                            \
-                if (is_null(sym) || sym->type != TYPE_SYMBOL) {                                             \
-                    drop_obj(sym);                                                                          \
+            case MTYPE2(TYPE_SYMBOL, TYPE_ENUM):                                                            \
+                sym = enum_domain(y);                                                                       \
+                if (is_null(sym))                                                                           \
                     THROW(ERR_TYPE, "eq: invalid enum");                                                    \
-                }                                                                                           \
                                                                                                             \
-                xi = AS_I64(x);                                                                             \
-                ei = AS_I64(e) + offset;                                                                    \
-                si = sym->i64;                                                                              \
+                yi = AS_I64(sym);                                                                           \
+                n = sym->len;                                                                               \
+                ei = AS_I64(ENUM_VAL(y)) + offset;                                                          \
+                xi = AS_I64(x) + offset;                                                                    \
                 out = AS_B8(res) + offset;                                                                  \
                                                                                                             \
                 for (i = 0; i < len; i++)                                                                   \
-                    out[i] = xi[i] == ei[si];                                                               \
+                    out[i] = op##SYM(xi[i], ((u64_t)ei[i] < (u64_t)n) ? yi[ei[i]] : NULL_I64);              \
                                                                                                             \
                 drop_obj(sym);                                                                              \
                 return res;                                                                                 \
-            case MTYPE2(TYPE_SYMBOL, TYPE_ENUM):                                                            \
-                return ray_##op##_partial(y, x, len, offset, res);                                          \
                                                                                                             \
             case MTYPE2(-TYPE_GUID, -TYPE_GUID):                                                            \
                 return b8(op##GUID(AS_GUID(x)[0], AS_GUID(y)[0]));                                          \
@@ -386,15 +409,16 @@ obj_p cmp_map(raw_p op, obj_p x, obj_p y) {
             return b8(cmp_obj(x, y) == 0);
     }
 
+    // counted rather than read from len, an enum in memory is a pair of the domain and the codes
     if (IS_VECTOR(x) && IS_VECTOR(y)) {
-        if (x->len != y->len)
+        if (ops_count(x) != ops_count(y))
             THROW(ERR_LENGTH, "vectors must have the same length");
 
-        l = x->len;
+        l = ops_count(x);
     } else if (IS_VECTOR(x))
-        l = x->len;
+        l = ops_count(x);
     else if (IS_VECTOR(y))
-        l = y->len;
+        l = ops_count(y);
     else {
         return cmp_fn(x, y, 1, 0, NULL_OBJ);
     }
@@ -458,7 +482,35 @@ __DECLARE_CMP_FN(GE)
 
 obj_p ray_eq(obj_p x, obj_p y) { return cmp_map(ray_EQ_partial, x, y); }
 obj_p ray_ne(obj_p x, obj_p y) { return cmp_map(ray_NE_partial, x, y); }
-obj_p ray_lt(obj_p x, obj_p y) { return cmp_map(ray_LT_partial, x, y); }
-obj_p ray_gt(obj_p x, obj_p y) { return cmp_map(ray_GT_partial, x, y); }
-obj_p ray_le(obj_p x, obj_p y) { return cmp_map(ray_LE_partial, x, y); }
-obj_p ray_ge(obj_p x, obj_p y) { return cmp_map(ray_GE_partial, x, y); }
+
+// Symbols are ordered by their ranks, brought up to date here as the partials may run on the executors
+static nil_t cmp_rank(obj_p x, obj_p y) {
+    i8_t tx, ty;
+
+    tx = (x->type == TYPE_MAPCOMMON) ? AS_LIST(x)[0]->type : x->type;
+    ty = (y->type == TYPE_MAPCOMMON) ? AS_LIST(y)[0]->type : y->type;
+
+    if (tx == TYPE_SYMBOL || tx == -TYPE_SYMBOL || tx == TYPE_ENUM || ty == TYPE_SYMBOL || ty == -TYPE_SYMBOL ||
+        ty == TYPE_ENUM)
+        symbols_rank(runtime_get()->symbols);
+}
+
+obj_p ray_lt(obj_p x, obj_p y) {
+    cmp_rank(x, y);
+    return cmp_map(ray_LT_partial, x, y);
+}
+
+obj_p ray_gt(obj_p x, obj_p y) {
+    cmp_rank(x, y);
+    return cmp_map(ray_GT_partial, x, y);
+}
+
+obj_p ray_le(obj_p x, obj_p y) {
+    cmp_rank(x, y);
+    return cmp_map(ray_LE_partial, x, y);
+}
+
+obj_p ray_ge(obj_p x, obj_p y) {
+    cmp_rank(x, y);
+    return cmp_map(ray_GE_partial, x, y);
+}
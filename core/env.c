@@ -28,6 +28,7 @@
 #include "compose.h"
 #include "cond.h"
 #include "dynlib.h"
+#include "eval.h"
 #include "format.h"
 #include "io.h"
 #include "items.h"
@@ -36,6 +37,7 @@
 #include "logic.h"
 #include "math.h"
 #include "misc.h"
+#include "moving.h"
 #include "ops.h"
 #include "order.h"
 #include "query.h"
@@ -43,6 +45,8 @@
 #include "runtime.h"
 #include "string.h"
 #include "chrono.h"
+#include "hash.h"
+#include "error.h"
 #include "date.h"
 #include "timestamp.h"
 #include "unary.h"
@@ -173,6 +177,13 @@ nil_t init_functions(obj_p functions)
     REGISTER_FN(functions,  "unify",               TYPE_UNARY,    FN_NONE,                   ray_unify);
     REGISTER_FN(functions,  "diverse",             TYPE_UNARY,    FN_NONE,                   ray_diverse);
     REGISTER_FN(functions,  "row",                 TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_row);
+    REGISTER_FN(functions,  "sums",                TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_sums);
+    REGISTER_FN(functions,  "prds",                TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_prds);
+    REGISTER_FN(functions,  "mins",                TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_mins);
+    REGISTER_FN(functions,  "maxs",                TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_maxs);
+    REGISTER_FN(functions,  "deltas",              TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_deltas);
+    REGISTER_FN(functions,  "ratios",              TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_ratios);
+    REGISTER_FN(functions,  "fills",               TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_fills);
     
     // Binary           
     REGISTER_FN(functions,  "try",                 TYPE_BINARY,   FN_NONE | FN_SPECIAL_FORM, try_obj);
@@ -215,6 +226,13 @@ nil_t init_functions(obj_p functions)
     REGISTER_FN(functions,  "split",               TYPE_BINARY,   FN_NONE,                   ray_split);
     REGISTER_FN(functions,  "bin",                 TYPE_BINARY,   FN_NONE,                   ray_bin);
     REGISTER_FN(functions,  "binr",                TYPE_BINARY,   FN_NONE,                   ray_binr);
+    REGISTER_FN(functions,  "advise",              TYPE_BINARY,   FN_NONE,                   ray_advise);
+    REGISTER_FN(functions,  "msum",                TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_msum);
+    REGISTER_FN(functions,  "mavg",                TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_mavg);
+    REGISTER_FN(functions,  "mmin",                TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_mmin);
+    REGISTER_FN(functions,  "mmax",                TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_mmax);
+    REGISTER_FN(functions,  "mdev",                TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_mdev);
+    REGISTER_FN(functions,  "ema",                 TYPE_BINARY,   FN_NONE | FN_AGGR,         ray_ema);
 
     // Vary               
     REGISTER_FN(functions,  "do",                  TYPE_VARY,     FN_NONE | FN_SPECIAL_FORM, ray_do);
@@ -231,6 +249,7 @@ nil_t init_functions(obj_p functions)
     REGISTER_FN(functions,  "println",             TYPE_VARY,     FN_NONE,                   ray_println);
     REGISTER_FN(functions,  "apply",               TYPE_VARY,     FN_NONE,                   ray_apply);
     REGISTER_FN(functions,  "map",                 TYPE_VARY,     FN_NONE,                   ray_map);
+    REGISTER_FN(functions,  "pmap",                TYPE_VARY,     FN_NONE,                   ray_pmap);
     REGISTER_FN(functions,  "map-left",            TYPE_VARY,     FN_NONE,                   ray_map_left);
     REGISTER_FN(functions,  "map-right",           TYPE_VARY,     FN_NONE,                   ray_map_right);
     REGISTER_FN(functions,  "fold",                TYPE_VARY,     FN_NONE,                   ray_fold);
@@ -250,6 +269,8 @@ nil_t init_functions(obj_p functions)
     REGISTER_FN(functions,  "asof-join",           TYPE_VARY,     FN_NONE,                   ray_asof_join);
     REGISTER_FN(functions,  "window-join",         TYPE_VARY,     FN_NONE,                   ray_window_join);
     REGISTER_FN(functions,  "window-join1",        TYPE_VARY,     FN_NONE,                   ray_window_join1);
+    REGISTER_FN(functions,  "xasc-take",           TYPE_VARY,     FN_NONE,                   ray_xasc_take);
+    REGISTER_FN(functions,  "xdesc-take",          TYPE_VARY,     FN_NONE,                   ray_xdesc_take);
     REGISTER_FN(functions,  "if",                  TYPE_VARY,     FN_NONE | FN_SPECIAL_FORM, ray_cond);
     REGISTER_FN(functions,  "return",              TYPE_VARY,     FN_NONE,                   ray_return);
     REGISTER_FN(functions,  "hopen",               TYPE_VARY,     FN_NONE,                   ray_hopen);
@@ -360,6 +381,9 @@ env_t env_create(nil_t) {
         .keywords = keywords,
         .functions = functions,
         .variables = variables,
+        .index = ht_oa_create(ENV_INDEX_SIZE, TYPE_I64),
+        .indexed = 0,
+        .names = NULL_OBJ,
         .typenames = typenames,
         .internals = internals,
     };
@@ -371,10 +395,111 @@ nil_t env_destroy(env_t *env) {
     drop_obj(env->keywords);
     drop_obj(env->functions);
     drop_obj(env->variables);
+    drop_obj(env->index);
     drop_obj(env->typenames);
     drop_obj(env->internals);
 }
 
+// Variables are only ever appended, so the index is extended with the ones added since the last call
+static nil_t env_index(env_t *env) {
+    i64_t i, slot, *names, *keys;
+    obj_p k;
+
+    k = AS_LIST(env->variables)[0];
+    names = AS_SYMBOL(k);
+
+    for (i = env->indexed; i < k->len; i++) {
+        // Keep the probe chains short
+        if (2 * (i + 1) > AS_LIST(env->index)[0]->len)
+            ht_oa_rehash(&env->index, &hash_kmh, NULL);
+
+        slot = ht_oa_tab_next_with(&env->index, names[i], &hash_kmh, &hash_cmp_i64, NULL);
+        keys = AS_I64(AS_LIST(env->index)[0]);
+
+        // The first one wins, as in a linear lookup
+        if (keys[slot] == NULL_I64) {
+            keys[slot] = names[i];
+            AS_I64(AS_LIST(env->index)[1])[slot] = i;
+        }
+    }
+
+    env->indexed = k->len;
+    env->names = k;
+}
+
+// Variables were modified bypassing env_set: the names were replaced or shrunk
+static inline b8_t env_stale(env_t *env) {
+    obj_p k = AS_LIST(env->variables)[0];
+    return k != env->names || k->len < env->indexed;
+}
+
+// Does not modify the index, so it is safe to be called from the pool workers
+obj_p *env_get(env_t *env, i64_t key) {
+    i64_t i, slot;
+    obj_p k;
+
+    k = AS_LIST(env->variables)[0];
+    slot = env_stale(env) ? NULL_I64 : ht_oa_tab_get_with(env->index, key, &hash_kmh, &hash_cmp_i64, NULL);
+
+    if (slot != NULL_I64) {
+        i = AS_I64(AS_LIST(env->index)[1])[slot];
+        if (AS_SYMBOL(k)[i] == key)
+            return &AS_LIST(AS_LIST(env->variables)[1])[i];
+    }
+
+    // Variables were modified bypassing env_set, the index is not reliable anymore
+    if (slot != NULL_I64 || env_stale(env)) {
+        i = find_raw(k, &key);
+        return (i == NULL_I64) ? NULL : &AS_LIST(AS_LIST(env->variables)[1])[i];
+    }
+
+    for (i = env->indexed; i < k->len; i++) {
+        if (AS_SYMBOL(k)[i] == key)
+            return &AS_LIST(AS_LIST(env->variables)[1])[i];
+    }
+
+    return NULL;
+}
+
+obj_p env_set(env_t *env, obj_p key, obj_p val) {
+    obj_p *v, res;
+
+    // Globals are shared by the interpreters, the executors only read them
+    if (interpreter_current()->id != 0) {
+        drop_obj(val);
+        THROW(ERR_NOT_SUPPORTED, "set: globals can only be assigned in main thread");
+    }
+
+    if (env->indexed > 0 && env_stale(env)) {
+        drop_obj(env->index);
+        env->index = ht_oa_create(ENV_INDEX_SIZE, TYPE_I64);
+        env->indexed = 0;
+    }
+
+    env_index(env);
+    v = env_get(env, key->i64);
+
+    if (v != NULL) {
+        drop_obj(*v);
+        *v = val;
+        return *v;
+    }
+
+    res = push_obj(&AS_LIST(env->variables)[0], clone_obj(key));
+    if (IS_ERR(res)) {
+        drop_obj(val);
+        return res;
+    }
+
+    res = push_obj(&AS_LIST(env->variables)[1], val);
+    if (IS_ERR(res))
+        PANIC("env_set: inconsistent update");
+
+    env_index(env);
+
+    return val;
+}
+
 i64_t env_get_typename_by_type(env_t *env, i8_t type) {
     i64_t t, i;
 
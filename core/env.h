@@ -31,6 +31,9 @@
 #define TYPE_OFFSET TYPE_C8
 #define MAX_TYPE (TYPE_ERR + TYPE_OFFSET + 2)
 
+// initial size of the global variables index
+#define ENV_INDEX_SIZE 1024
+
 // hot symbols
 extern i64_t SYMBOL_FN;
 extern i64_t SYMBOL_SELF;
@@ -50,6 +53,9 @@ typedef struct env_t {
     obj_p keywords;   // list of reserved keywords
     obj_p functions;  // dict, containing function primitives
     obj_p variables;  // dict, containing mappings variables names to their values
+    obj_p index;      // hash table, containing mappings variables names to their positions in variables
+    i64_t indexed;    // count of variables covered by index
+    obj_p names;      // names vector the index was built over (not owned), another one makes the index stale
     obj_p typenames;  // dict, containing mappings type ids to their names
     obj_p internals;  // dict, containing internal functions, variables, descriptors etc.
 } env_t;
@@ -67,6 +73,7 @@ obj_p env_get_internal_function_by_id(i64_t id);
 str_p env_get_internal_function_name(lit_p name, i64_t len, i64_t *index, b8_t exact);
 str_p env_get_internal_keyword_name(lit_p name, i64_t len, i64_t *index, b8_t exact);
 str_p env_get_global_name(lit_p name, i64_t len, i64_t *index, i64_t *sbidx);
+obj_p *env_get(env_t *env, i64_t key);
 obj_p env_set(env_t *env, obj_p key, obj_p val);
 obj_p ray_env(obj_p *x, i64_t n);
 obj_p ray_memstat(obj_p *x, i64_t n);
@@ -88,6 +88,7 @@ interpreter_p interpreter_create(i64_t id) {
     AS_LAMBDA(f)->nfo = NULL_OBJ;
     AS_LAMBDA(f)->args = NULL_OBJ;
     AS_LAMBDA(f)->body = NULL_OBJ;
+    AS_LAMBDA(f)->slots = NULL_OBJ;
 
     ctx_push(f);
 
@@ -112,13 +113,16 @@ obj_p call(obj_p obj, i64_t arity) {
     obj_p res;
     i64_t sp;
 
+    lambda = AS_LAMBDA(obj);
+
+    if (arity != lambda->args->len)
+        return error_str(ERR_ARITY, "wrong number of arguments");
+
     sp = __INTERPRETER->sp - arity;
 
     // local env
     stack_push(NULL_OBJ);
 
-    lambda = AS_LAMBDA(obj);
-
     // push context
     ctx = ctx_push(obj);
     ctx->sp = sp;
@@ -135,6 +139,29 @@ obj_p call(obj_p obj, i64_t arity) {
     return res;
 }
 
+// Arguments are bound to their slots on a lambda creation, no lookup is needed unless locals may shadow them
+static inline obj_p *resolve_obj(obj_p sym) {
+    i64_t n, *keys;
+    u64_t h;
+    obj_p lambda, slots;
+    ctx_p ctx;
+
+    ctx = ctx_get();
+    lambda = ctx->lambda;
+    slots = AS_LAMBDA(lambda)->slots;
+
+    if (slots != NULL_OBJ && __INTERPRETER->stack[ctx->sp + AS_LAMBDA(lambda)->args->len] == NULL_OBJ) {
+        keys = AS_I64(slots);
+        n = slots->len / 2;
+        for (h = LAMBDA_SLOT_HASH(sym, n); keys[h] != 0; h = (h + 1) & (n - 1)) {
+            if (keys[h] == (i64_t)sym)
+                return &__INTERPRETER->stack[ctx->sp + keys[n + h]];
+        }
+    }
+
+    return resolve(sym->i64);
+}
+
 __attribute__((hot)) obj_p eval(obj_p obj) {
     i64_t len, i;
     obj_p car, *val, *args, x, y, z, res;
@@ -290,7 +317,7 @@ __attribute__((hot)) obj_p eval(obj_p obj) {
                     return unwrap(lambda_call(car, stack_peek(len - 1), len), (i64_t)obj);
 
                 case -TYPE_SYMBOL:
-                    val = resolve(car->i64);
+                    val = resolve_obj(car);
                     if (val == NULL)
                         return unwrap(error(ERR_EVAL, "undefined symbol: '%s", str_from_symbol(car->i64)), (i64_t)obj);
                     car = *val;
@@ -303,7 +330,7 @@ __attribute__((hot)) obj_p eval(obj_p obj) {
             if (obj->attrs & ATTR_QUOTED)
                 return symboli64(obj->i64);
 
-            val = resolve(obj->i64);
+            val = resolve_obj(obj);
             if (val == NULL)
                 return unwrap(error(ERR_EVAL, "undefined symbol: '%s", str_from_symbol(obj->i64)), (i64_t)obj);
             return clone_obj(*val);
@@ -601,7 +628,7 @@ nil_t interpreter_env_set(interpreter_p interpreter, obj_p env) { interpreter->s
 nil_t interpreter_env_unset(interpreter_p interpreter) { drop_obj(interpreter->stack[--interpreter->sp]); }
 
 obj_p *resolve(i64_t sym) {
-    i64_t j, bp, *args;
+    i64_t bp, *args;
     obj_p lambda, env;
     i64_t i, l, n;
     ctx_p ctx;
@@ -636,11 +663,11 @@ obj_p *resolve(i64_t sym) {
     }
 
     // search globals
-    j = find_raw(AS_LIST(runtime_get()->env.variables)[0], &sym);
-    if (j == NULL_I64)
-        return NULL;
+    return env_get(&runtime_get()->env, sym);
+}
 
-    return &AS_LIST(AS_LIST(runtime_get()->env.variables)[1])[j];
+b8_t resolve_writable(i64_t sym, obj_p *val) {
+    return __INTERPRETER->id == 0 || val != env_get(&runtime_get()->env, sym);
 }
 
 obj_p ray_exit(obj_p *x, i64_t n) {
@@ -75,6 +75,7 @@ nil_t interpreter_destroy(nil_t);
 interpreter_p interpreter_current(nil_t);
 obj_p call(obj_p obj, i64_t arity);
 obj_p *resolve(i64_t sym);
+b8_t resolve_writable(i64_t sym, obj_p *val);  // globals are written by the main interpreter only
 obj_p amend(obj_p sym, obj_p val);
 obj_p mount_env(obj_p obj);
 obj_p unmount_env(i64_t n);
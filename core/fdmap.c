@@ -26,6 +26,7 @@
 #include "mmap.h"
 #include "ops.h"
 #include "util.h"
+#include "runtime.h"
 
 obj_p fdmap_create() {
     obj_p fdmap;
@@ -39,10 +40,11 @@ obj_p fdmap_create() {
 nil_t fdmap_add_fd(obj_p *fdmap, obj_p obj, i64_t fd, i64_t size) {
     obj_p v;
 
-    v = I64(3);
+    v = I64(4);
     AS_I64(v)[0] = (i64_t)obj;
     AS_I64(v)[1] = fd;
     AS_I64(v)[2] = size;
+    AS_I64(v)[3] = 0;  // queued to the loader
     AS_LIST(*fdmap)[0] = v;
     // push_obj(fdmap, v);
 }
@@ -59,6 +61,9 @@ nil_t fdmap_destroy(obj_p fdmap) {
         fd = (i64_t)AS_I64(AS_LIST(fdmap)[i])[1];
         size = AS_I64(AS_LIST(fdmap)[i])[2];
 
+        if (obj != NULL && runtime_get()->loader != NULL)
+            loader_forget(runtime_get()->loader, obj, size);
+
         if (obj != NULL)
             mmap_free(obj, size);
 
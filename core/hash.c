@@ -25,6 +25,9 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdint.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "string.h"
 #include "hash.h"
 #include "rayforce.h"
@@ -249,6 +252,168 @@ i64_t ht_oa_tab_get_with(obj_p obj, i64_t key, hash_f hash, cmp_f cmp, raw_p see
     return NULL_I64;
 }
 
+ht_sw_p ht_sw_create(i64_t size) {
+    i64_t cap, ctrl;
+    ht_sw_p ht;
+
+    // keep the load under 7/8
+    for (cap = HT_SW_GROUP * 2; cap * 7 < size * 8; cap <<= 1)
+        ;
+
+    ctrl = ALIGNUP(cap + HT_SW_GROUP, sizeof(i64_t));
+    ht = (ht_sw_p)heap_alloc(sizeof(struct ht_sw_t) + ctrl + cap * sizeof(ht_sw_slot_t));
+    if (ht == NULL)
+        return NULL;
+
+    ht->size = cap;
+    ht->count = 0;
+    ht->slots = (ht_sw_slot_t *)(ht->ctrl + ctrl);
+    memset(ht->ctrl, HT_SW_EMPTY, cap + HT_SW_GROUP);
+
+    return ht;
+}
+
+nil_t ht_sw_destroy(ht_sw_p ht) { heap_free(ht); }
+
+// Bit per control byte of the group at pos equal to b
+static inline u32_t ht_sw_match(const u8_t *ctrl, u8_t b) {
+#if defined(__SSE2__)
+    __m128i g = _mm_loadu_si128((const __m128i *)ctrl);
+    return (u32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((i8_t)b)));
+#else
+    u32_t i, m = 0;
+    for (i = 0; i < HT_SW_GROUP; i++)
+        m |= (u32_t)(ctrl[i] == b) << i;
+    return m;
+#endif
+}
+
+static inline nil_t ht_sw_set_ctrl(ht_sw_p ht, i64_t i, u8_t b) {
+    ht->ctrl[i] = b;
+    if (i < HT_SW_GROUP)
+        ht->ctrl[ht->size + i] = b;
+}
+
+// Slot of the key, or the empty slot it goes to (ctrl is HT_SW_EMPTY then)
+static inline i64_t ht_sw_probe(ht_sw_p ht, i64_t key, u64_t hash) {
+    i64_t pos, step, mask;
+    u32_t m;
+    u8_t h2 = (u8_t)(hash & 0x7f);
+
+    mask = ht->size - 1;
+    pos = (i64_t)(hash >> 7) & mask;
+
+    for (step = HT_SW_GROUP;; step += HT_SW_GROUP) {
+        for (m = ht_sw_match(ht->ctrl + pos, h2); m; m &= m - 1) {
+            i64_t i = (pos + __builtin_ctz(m)) & mask;
+            if (ht->slots[i].key == key)
+                return i;
+        }
+
+        m = ht_sw_match(ht->ctrl + pos, HT_SW_EMPTY);
+        if (m)
+            return (pos + __builtin_ctz(m)) & mask;
+
+        pos = (pos + step) & mask;
+    }
+}
+
+static nil_t ht_sw_grow(ht_sw_p *ht) {
+    i64_t i, j, size;
+    ht_sw_p old = *ht, new;
+    u64_t hash;
+
+    size = old->size;
+    new = ht_sw_create(size * 2 * 7 / 8);
+
+    for (i = 0; i < size; i++) {
+        if (old->ctrl[i] == HT_SW_EMPTY)
+            continue;
+        hash = ht_sw_hash(old->slots[i].key);
+        j = ht_sw_probe(new, old->slots[i].key, hash);
+        ht_sw_set_ctrl(new, j, (u8_t)(hash & 0x7f));
+        new->slots[j] = old->slots[i];
+    }
+
+    new->count = old->count;
+    heap_free(old);
+    *ht = new;
+}
+
+static inline i64_t ht_sw_insert_hashed(ht_sw_p *ht, i64_t key, u64_t hash, i64_t val) {
+    i64_t i;
+    ht_sw_p t = *ht;
+
+    i = ht_sw_probe(t, key, hash);
+    if (t->ctrl[i] != HT_SW_EMPTY)
+        return t->slots[i].val;
+
+    if ((t->count + 1) * 8 > t->size * 7) {
+        ht_sw_grow(ht);
+        t = *ht;
+        i = ht_sw_probe(t, key, hash);
+    }
+
+    ht_sw_set_ctrl(t, i, (u8_t)(hash & 0x7f));
+    t->slots[i].key = key;
+    t->slots[i].val = val;
+    t->count++;
+
+    return val;
+}
+
+i64_t ht_sw_insert(ht_sw_p *ht, i64_t key, i64_t val) { return ht_sw_insert_hashed(ht, key, ht_sw_hash(key), val); }
+
+i64_t ht_sw_get(ht_sw_p ht, i64_t key) {
+    i64_t i = ht_sw_probe(ht, key, ht_sw_hash(key));
+    return (ht->ctrl[i] == HT_SW_EMPTY) ? NULL_I64 : ht->slots[i].val;
+}
+
+// Hashes a batch of keys and touches their first groups before any of them is probed
+static inline nil_t ht_sw_prefetch(ht_sw_p ht, i64_t keys[], i64_t filter[], i64_t from, i64_t n, u64_t hashes[]) {
+    i64_t j, pos, mask = ht->size - 1;
+
+    for (j = 0; j < n; j++) {
+        hashes[j] = ht_sw_hash(filter ? keys[filter[from + j]] : keys[from + j]);
+        pos = (i64_t)(hashes[j] >> 7) & mask;
+        __builtin_prefetch(ht->ctrl + pos, 0, 1);
+        __builtin_prefetch(ht->slots + pos, 0, 1);
+    }
+}
+
+i64_t ht_sw_group(ht_sw_p *ht, i64_t keys[], i64_t filter[], i64_t out[], i64_t len, i64_t groups) {
+    i64_t i, j, n, key;
+    u64_t hashes[HT_SW_BATCH];
+
+    for (i = 0; i < len; i += HT_SW_BATCH) {
+        n = (len - i < HT_SW_BATCH) ? len - i : HT_SW_BATCH;
+        ht_sw_prefetch(*ht, keys, filter, i, n, hashes);
+
+        for (j = 0; j < n; j++) {
+            key = filter ? keys[filter[i + j]] : keys[i + j];
+            out[i + j] = ht_sw_insert_hashed(ht, key, hashes[j], groups);
+            groups += (out[i + j] == groups);
+        }
+    }
+
+    return groups;
+}
+
+nil_t ht_sw_find(ht_sw_p ht, i64_t keys[], i64_t out[], i64_t len) {
+    i64_t i, j, n, s;
+    u64_t hashes[HT_SW_BATCH];
+
+    for (i = 0; i < len; i += HT_SW_BATCH) {
+        n = (len - i < HT_SW_BATCH) ? len - i : HT_SW_BATCH;
+        ht_sw_prefetch(ht, keys, NULL, i, n, hashes);
+
+        for (j = 0; j < n; j++) {
+            s = ht_sw_probe(ht, keys[i + j], hashes[j]);
+            out[i + j] = (ht->ctrl[s] == HT_SW_EMPTY) ? NULL_I64 : ht->slots[s].val;
+        }
+    }
+}
+
 u64_t hash_index_obj(obj_p obj) {
     u64_t hash, len, i;
 
@@ -39,6 +39,44 @@ i64_t ht_oa_tab_get(obj_p obj, i64_t key);
 i64_t ht_oa_tab_get_with(obj_p obj, i64_t key, hash_f hash, cmp_f cmp, raw_p seed);
 nil_t ht_oa_rehash(obj_p *obj, hash_f hash, raw_p seed);
 
+// Single threaded table of i64 keys: a control byte per slot holds 7 bits of the key hash, or
+// HT_SW_EMPTY, and the control bytes are matched a group of HT_SW_GROUP at a time
+#define HT_SW_GROUP 16
+#define HT_SW_EMPTY 0x80
+#define HT_SW_BATCH 16  // keys hashed and prefetched ahead of the probes
+
+typedef struct ht_sw_slot_t {
+    i64_t key;
+    i64_t val;
+} ht_sw_slot_t;
+
+typedef struct ht_sw_t {
+    i64_t size;  // slots, a power of two
+    i64_t count;  // keys
+    ht_sw_slot_t *slots;
+    u8_t ctrl[];  // size + HT_SW_GROUP bytes, the tail mirrors the first group
+} *ht_sw_p;
+
+// murmur3 finalizer, the low 7 bits go to the control byte, the rest choose the group
+static inline u64_t ht_sw_hash(i64_t key) {
+    u64_t h = (u64_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+ht_sw_p ht_sw_create(i64_t size);
+nil_t ht_sw_destroy(ht_sw_p ht);
+i64_t ht_sw_insert(ht_sw_p *ht, i64_t key, i64_t val);  // value of the key, val if it has been inserted
+i64_t ht_sw_get(ht_sw_p ht, i64_t key);                 // NULL_I64 if there is no such key
+// Numbers the keys (through filter if not NULL) from groups on, returns the new groups count
+i64_t ht_sw_group(ht_sw_p *ht, i64_t keys[], i64_t filter[], i64_t out[], i64_t len, i64_t groups);
+// Looks the keys up, out gets their values or NULL_I64
+nil_t ht_sw_find(ht_sw_p ht, i64_t keys[], i64_t out[], i64_t len);
+
 // Multithreaded lockfree hash table
 typedef struct bucket_t {
     i64_t key;
@@ -33,6 +33,7 @@
 #include "sys.h"
 #include "os.h"
 #include "log.h"
+#include "atomic.h"
 
 #ifndef __EMSCRIPTEN__
 RAYASSERT(sizeof(struct block_t) == (2 * sizeof(struct obj_t)), heap_h);
@@ -40,6 +41,12 @@ RAYASSERT(sizeof(struct block_t) == (2 * sizeof(struct obj_t)), heap_h);
 
 __thread heap_p __HEAP = NULL;
 __thread c8_t HEAP_SWAP[64] = {0};
+__thread b8_t HEAP_HUGETLB = B8_FALSE;
+
+// Heaps by id, so a thread freeing a block it does not own can hand it over to the owner
+static heap_p HEAPS[MAX_HEAPS] = {0};
+// Hand overs in flight by heap id: a heap being destroyed waits for them before its last drain
+static i64_t HEAPS_PUSHING[MAX_HEAPS] = {0};
 
 #define BLOCKSIZE(s) (sizeof(struct obj_t) + (s))
 #define BSIZEOF(o) (1ll << (i64_t)(o))
@@ -49,7 +56,12 @@ __thread c8_t HEAP_SWAP[64] = {0};
 #define RAW2BLOCK(r) ((block_p)((i64_t)(r) - sizeof(struct obj_t)))
 #define DEFAULT_HEAP_SWAP "/tmp/"
 
+static nil_t heap_release(nil_t);
+static nil_t heap_drain(nil_t);
+
 heap_p heap_create(i64_t id) {
+    c8_t buf[8];
+
     LOG_INFO("Creating heap with id %lld", id);
     __HEAP = (heap_p)mmap_alloc(sizeof(struct heap_t));
 
@@ -59,10 +71,17 @@ heap_p heap_create(i64_t id) {
     }
 
     __HEAP->id = id;
+    __HEAP->node = -1;
     __HEAP->avail = 0;
     __HEAP->foreign_blocks = NULL;
+    __HEAP->remote = NULL;
+    __HEAP->large = NULL;
+    __HEAP->large_count = 0;
 
     memset(__HEAP->freelist, 0, sizeof(__HEAP->freelist));
+    memset(__HEAP->freetail, 0, sizeof(__HEAP->freetail));
+    memset(__HEAP->slabs, 0, sizeof(__HEAP->slabs));
+    memset(__HEAP->slab_count, 0, sizeof(__HEAP->slab_count));
 
     if (os_get_var("HEAP_SWAP", HEAP_SWAP, sizeof(HEAP_SWAP)) == -1)
         snprintf(HEAP_SWAP, sizeof(HEAP_SWAP), "%s", DEFAULT_HEAP_SWAP);
@@ -70,20 +89,37 @@ heap_p heap_create(i64_t id) {
     if (HEAP_SWAP[strlen(HEAP_SWAP) - 1] != '/')
         strcat(HEAP_SWAP, "/");
 
+    // Large objects are put on explicit huge pages if asked to (and the hugetlb pool has them)
+    HEAP_HUGETLB = os_get_var("HEAP_HUGETLB", buf, sizeof(buf)) != -1 && strcmp(buf, "0") != 0;
+
+    if (id >= 0 && id < MAX_HEAPS)
+        __atomic_store_n(&HEAPS[id], __HEAP, __ATOMIC_RELEASE);
+
     LOG_DEBUG("Heap created successfully with swap path: %s", HEAP_SWAP);
     return __HEAP;
 }
 
 nil_t heap_destroy(nil_t) {
-    i64_t i;
+    i64_t i, rounds = 0;
     block_p block, next;
 
     LOG_INFO("Destroying heap");
 
+    // Nobody reaches the heap once it is unregistered and the hand overs that did are over
+    if (__HEAP->id >= 0 && __HEAP->id < MAX_HEAPS) {
+        __atomic_store_n(&HEAPS[__HEAP->id], NULL, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&HEAPS_PUSHING[__HEAP->id], __ATOMIC_SEQ_CST) != 0)
+            backoff_spin(&rounds);
+    }
+
+    heap_drain();
+
     // Ensure foreign blocks are freed
     if (__HEAP->foreign_blocks != NULL)
         LOG_WARN("Heap[%lld]: foreign blocks not freed", __HEAP->id);
 
+    heap_release();
+
     // All the nodes remains are pools, so just munmap them
     for (i = MIN_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
         block = __HEAP->freelist[i];
@@ -107,6 +143,10 @@ nil_t heap_destroy(nil_t) {
     LOG_DEBUG("Heap destroyed successfully");
 }
 
+// Pools are populated by the thread adding them, so they stay on its node. Tracking the node
+// lets the executors borrow only local pools and the large objects be placed by their writers.
+nil_t heap_set_node(i64_t node) { __HEAP->node = node; }
+
 heap_p heap_get(nil_t) {
     LOG_TRACE("Getting heap instance");
     return __HEAP;
@@ -122,11 +162,17 @@ nil_t heap_free(raw_p ptr) {
         free(ptr);
 }
 raw_p heap_realloc(raw_p ptr, i64_t size) { return realloc(ptr, size); }
+i64_t heap_cap(raw_p ptr) {
+    UNUSED(ptr);
+    return 0;
+}
 nil_t heap_unmap(raw_p ptr, i64_t size) { mmap_free(ptr, size); }
 i64_t heap_gc(nil_t) { return 0; }
 nil_t heap_borrow(heap_p heap) { UNUSED(heap); }
 nil_t heap_merge(heap_p heap) { UNUSED(heap); }
 memstat_t heap_memstat(nil_t) { return (memstat_t){0}; }
+static nil_t heap_release(nil_t) {}
+static nil_t heap_drain(nil_t) {}
 
 #else
 
@@ -198,8 +244,10 @@ inline __attribute__((always_inline)) nil_t heap_insert_block(block_p block, i64
 
     if (__HEAP->freelist[order] != NULL)
         __HEAP->freelist[order]->prev = block;
-    else
+    else {
         __HEAP->avail |= size;
+        __HEAP->freetail[order] = block;
+    }
 
     __HEAP->freelist[order] = block;
 }
@@ -209,6 +257,8 @@ inline __attribute__((always_inline)) nil_t heap_remove_block(block_p block, i64
         block->prev->next = block->next;
     if (block->next)
         block->next->prev = block->prev;
+    else
+        __HEAP->freetail[order] = block->prev;
 
     if (__HEAP->freelist[order] == block)
         __HEAP->freelist[order] = block->next;
@@ -250,8 +300,185 @@ raw_p heap_stack(i64_t size) {
     return ptr;
 }
 
+// Takes a block of the order out of the buddy free lists, adding a pool if none fits
+static block_p heap_buddy_alloc(i64_t order) {
+    i64_t i;
+    block_p block;
+
+    // blocks freed by the other threads may have left a fitting one
+    if (__atomic_load_n(&__HEAP->remote, __ATOMIC_RELAXED) != NULL)
+        heap_drain();
+
+    // find least order block that fits
+    i = (AVAIL_MASK << order) & __HEAP->avail;
+
+    // no free block found for this size, so add a new pool and split it
+    if (i == 0) {
+        block = heap_add_pool(BSIZEOF(MAX_BLOCK_ORDER));
+
+        if (block == NULL)
+            return NULL;
+
+        i = MAX_BLOCK_ORDER;
+        heap_insert_block(block, i);
+    } else
+        i = __builtin_ctzll(i);
+
+    // remove the block out of list
+    block = __HEAP->freelist[i];
+
+    __HEAP->freelist[i] = block->next;
+    if (__HEAP->freelist[i] != NULL)
+        __HEAP->freelist[i]->prev = NULL;
+    else {
+        __HEAP->avail &= ~BSIZEOF(i);
+        __HEAP->freetail[i] = NULL;
+    }
+
+    heap_split_block(block, order, i);
+
+    block->order = order;
+    block->used = 1;
+    block->heap_id = __HEAP->id;
+    block->backed = B8_FALSE;
+    block->large = LARGE_NONE;
+
+    return block;
+}
+
+// Carves a block into used blocks of a small order, they stay buddies and merge back once released
+static block_p heap_slab_refill(i64_t order) {
+    i64_t i, n;
+    block_p block, b;
+
+    block = heap_buddy_alloc(SLAB_REFILL_ORDER);
+    if (block == NULL)
+        return NULL;
+
+    n = BSIZEOF(SLAB_REFILL_ORDER - order);
+
+    // the first block is the carved one, so its header is overwritten last
+    for (i = n - 1; i >= 0; i--) {
+        b = (block_p)((i64_t)block + i * BSIZEOF(order));
+        b->pool = block->pool;
+        b->pool_order = block->pool_order;
+        b->order = order;
+        b->used = 1;
+        b->heap_id = __HEAP->id;
+        b->backed = B8_FALSE;
+        b->large = LARGE_NONE;
+        b->next = __HEAP->slabs[order];
+        __HEAP->slabs[order] = b;
+    }
+
+    __HEAP->slab_count[order] += n;
+
+    return __HEAP->slabs[order];
+}
+
+// Maps a large object with its exact page rounded size, reusing a freed mapping that fits
+static block_p heap_large_alloc(i64_t size) {
+    i64_t cap, kind;
+    block_p block, *prev, *best;
+
+    cap = ALIGNUP(size, RAY_PAGE_SIZE);
+    best = NULL;
+
+    for (prev = &__HEAP->large; *prev != NULL; prev = &(*prev)->next) {
+        if ((i64_t)(*prev)->pool >= cap && (best == NULL || (*prev)->pool < (*best)->pool))
+            best = prev;
+    }
+
+    if (best != NULL) {
+        block = *best;
+        *best = block->next;
+        __HEAP->large_count--;
+
+        // the tail is handed back, so the mapping stays exact
+        if ((i64_t)block->pool > cap && mmap_remap(block, (i64_t)block->pool, cap) == block) {
+            __HEAP->memstat.system -= (i64_t)block->pool - cap;
+            block->pool = (block_p)cap;
+        }
+
+        cap = (i64_t)block->pool;
+        kind = LARGE_MAP;
+    } else {
+        block = NULL;
+        kind = LARGE_MAP;
+
+        if (HEAP_HUGETLB) {
+            block = (block_p)mmap_alloc_huge(ALIGNUP(size, HUGE_PAGE_SIZE));
+            if (block != NULL) {
+                cap = ALIGNUP(size, HUGE_PAGE_SIZE);
+                kind = LARGE_HUGETLB;
+            }
+        }
+
+        if (block == NULL)
+            block = (block_p)mmap_alloc_large(cap);
+
+        if (block == NULL)
+            return NULL;
+
+        __HEAP->memstat.system += cap;
+    }
+
+    block->pool = (block_p)cap;
+    block->pool_order = 0;
+    block->order = ORDEROF(size);
+    block->used = 1;
+    block->heap_id = __HEAP->id;
+    block->backed = B8_FALSE;
+    block->large = kind;
+
+    return block;
+}
+
+// Only the main heap keeps freed large mappings, the executors return them to the system. Neither does
+// it on a NUMA box: a fresh mapping is faulted in by the threads filling it, on their own nodes.
+static nil_t heap_large_free(block_p block) {
+    i64_t size = (i64_t)block->pool;
+
+    if (__HEAP->id != 0 || __HEAP->node >= 0 || block->large != LARGE_MAP || __HEAP->large_count >= LARGE_CACHE) {
+        mmap_free(block, size);
+        __HEAP->memstat.system -= size;
+        return;
+    }
+
+    block->used = 0;
+    block->next = __HEAP->large;
+    __HEAP->large = block;
+    __HEAP->large_count++;
+}
+
+// Resizes a large mapping in place or by moving its pages. It grows by a quarter at least and
+// shrinks only once a quarter is unused, so vectors pushed to one by one do not remap every time.
+static block_p heap_large_resize(block_p block, i64_t size) {
+    i64_t cap, need;
+    block_p res;
+
+    cap = (i64_t)block->pool;
+    need = ALIGNUP(size, RAY_PAGE_SIZE);
+
+    if (need <= cap && need > cap - cap / 4)
+        return block;
+
+    if (need > cap && need < cap + cap / 4)
+        need = ALIGNUP(cap + cap / 4, RAY_PAGE_SIZE);
+
+    res = (block_p)mmap_remap(block, cap, need);
+    if (res == NULL)
+        return NULL;
+
+    res->pool = (block_p)need;
+    res->order = ORDEROF(size);
+    __HEAP->memstat.system += need - cap;
+
+    return res;
+}
+
 raw_p __attribute__((hot)) heap_alloc(i64_t size) {
-    i64_t i, order, block_size;
+    i64_t order, block_size;
     block_p block;
 
     if (size == 0 || size > BSIZEOF(MAX_POOL_ORDER))
@@ -262,13 +489,28 @@ raw_p __attribute__((hot)) heap_alloc(i64_t size) {
     // calculate minimal order for this size
     order = ORDEROF(block_size);
 
-    // find least order block that fits
-    i = (AVAIL_MASK << order) & __HEAP->avail;
+    if (order <= SLAB_ORDER) {
+        block = __HEAP->slabs[order];
 
-    // no free block found for this size, so mmap it directly if it is bigger than pool size or
-    // add a new pool and split as well
-    if (i == 0) {
-        if (order >= MAX_BLOCK_ORDER) {
+        if (block == NULL)
+            block = heap_slab_refill(order);
+
+        if (block != NULL) {
+            __HEAP->slabs[order] = block->next;
+            __HEAP->slab_count[order]--;
+            return BLOCK2RAW(block);
+        }
+    }
+
+    // objects that do not fit into a pool get a mapping of their own, if the system is out of
+    // memory they fall back to a power of two pool which may be backed by a swap file
+    if (order > MAX_BLOCK_ORDER) {
+        block = heap_large_alloc(block_size);
+
+        if (block != NULL)
+            return BLOCK2RAW(block);
+
+        if (((AVAIL_MASK << order) & __HEAP->avail) == 0) {
             LOG_TRACE("Adding pool of size %lld requested size %lld", BSIZEOF(order), size);
             size = BSIZEOF(order);
             block = heap_add_pool(size);
@@ -279,43 +521,85 @@ raw_p __attribute__((hot)) heap_alloc(i64_t size) {
             block->order = order;
             block->used = 1;
             block->heap_id = __HEAP->id;
+            block->large = LARGE_NONE;
 
             __HEAP->memstat.system += size;
 
             return BLOCK2RAW(block);
         }
+    }
 
-        block = heap_add_pool(BSIZEOF(MAX_BLOCK_ORDER));
+    block = heap_buddy_alloc(order);
 
-        if (block == NULL)
-            return NULL;
+    return (block == NULL) ? NULL : BLOCK2RAW(block);
+}
 
-        i = MAX_BLOCK_ORDER;
-        heap_insert_block(block, i);
-    } else
-        i = __builtin_ctzll(i);
+// Returns a block to the free lists, merging it with its free buddies
+static nil_t heap_coalesce(block_p block, i64_t order) {
+    block_p buddy;
 
-    // remove the block out of list
-    block = __HEAP->freelist[i];
+    for (;; order++) {
+        // check if we are at the root block (no buddies left)
+        if (block->pool_order == order)
+            return heap_insert_block(block, order);
 
-    __HEAP->freelist[i] = block->next;
-    if (__HEAP->freelist[i] != NULL)
-        __HEAP->freelist[i]->prev = NULL;
-    else
-        __HEAP->avail &= ~BSIZEOF(i);
+        // calculate buddy
+        buddy = BUDDYOF(block, order);
 
-    heap_split_block(block, order, i);
+        // buddy is used, or buddy is of different order, so we can't merge
+        if (buddy->used || buddy->order != order)
+            return heap_insert_block(block, order);
 
-    block->order = order;
-    block->used = 1;
-    block->heap_id = __HEAP->id;
-    block->backed = B8_FALSE;
+        // merge blocks: remove buddy from its freelist.
+        heap_remove_block(buddy, order);
+
+        // check if buddy is lower address than block (means it is of higher order), if so, swap them
+        block = (buddy < block) ? buddy : block;
+    }
+}
+
+// Hands a block over to the heap owning it: pushed onto its remote list, which the owner drains
+// when it runs short of free blocks. Returns false if the owner is not reachable.
+static b8_t heap_remote_free(block_p block) {
+    i64_t id;
+    heap_p owner;
+    block_p head;
+
+    id = block->heap_id;
+    if (id >= MAX_HEAPS)
+        return B8_FALSE;
+
+    // Announce the hand over before looking the owner up, so heap_destroy either hides it or waits for it
+    __atomic_fetch_add(&HEAPS_PUSHING[id], 1, __ATOMIC_SEQ_CST);
+
+    owner = __atomic_load_n(&HEAPS[id], __ATOMIC_SEQ_CST);
+    if (owner != NULL) {
+        head = __atomic_load_n(&owner->remote, __ATOMIC_RELAXED);
+        do {
+            block->next = head;
+        } while (
+            !__atomic_compare_exchange_n(&owner->remote, &head, block, B8_TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    __atomic_fetch_sub(&HEAPS_PUSHING[id], 1, __ATOMIC_RELEASE);
+
+    return owner != NULL;
+}
+
+// Frees the blocks other threads have handed over to this heap
+static nil_t heap_drain(nil_t) {
+    block_p block, next;
+
+    block = __atomic_exchange_n(&__HEAP->remote, NULL, __ATOMIC_ACQUIRE);
 
-    return BLOCK2RAW(block);
+    for (; block != NULL; block = next) {
+        next = block->next;
+        heap_free(BLOCK2RAW(block));
+    }
 }
 
 __attribute__((hot)) nil_t heap_free(raw_p ptr) {
-    block_p block, buddy;
+    block_p block;
     i64_t fd, res;
     i64_t order;
     c8_t filename[64];
@@ -340,50 +624,62 @@ __attribute__((hot)) nil_t heap_free(raw_p ptr) {
         return;
     }
 
+    // the main heap owns every block between the parallel runs, so it frees them in place then
+    if (block->heap_id != __HEAP->id && (__HEAP->id != 0 || rc_sync_get()) && heap_remote_free(block))
+        return;
+
     if (__HEAP->id != 0 && block->heap_id != __HEAP->id) {
         block->next = __HEAP->foreign_blocks;
         __HEAP->foreign_blocks = block;
         return;
     }
 
-    for (;; order++) {
-        // check if we are at the root block (no buddies left)
-        if (block->pool_order == order)
-            return heap_insert_block(block, order);
-
-        // calculate buddy
-        buddy = BUDDYOF(block, order);
-
-        // buddy is used, or buddy is of different order, so we can't merge
-        if (buddy->used || buddy->order != order)
-            return heap_insert_block(block, order);
-
-        // merge blocks: remove buddy from its freelist.
-        heap_remove_block(buddy, order);
+    if (block->large)
+        return heap_large_free(block);
 
-        // check if buddy is lower address than block (means it is of higher order), if so, swap them
-        block = (buddy < block) ? buddy : block;
+    // small blocks stay used in the slab, so their buddies never see them free
+    if (order <= SLAB_ORDER && __HEAP->slab_count[order] < SLAB_LIMIT) {
+        block->next = __HEAP->slabs[order];
+        __HEAP->slabs[order] = block;
+        __HEAP->slab_count[order]++;
+        return;
     }
+
+    heap_coalesce(block, order);
 }
 
 __attribute__((hot)) raw_p heap_realloc(raw_p ptr, i64_t new_size) {
-    block_p block;
+    block_p block, large;
     i64_t i, old_size, cap, order;
+    b8_t foreign;
     raw_p new_ptr;
 
     if (ptr == NULL)
         return heap_alloc(new_size);
 
     block = RAW2BLOCK(ptr);
-    old_size = BSIZEOF(block->order);
     cap = BLOCKSIZE(new_size);
     order = ORDEROF(cap);
+    foreign = (__HEAP->id != 0 && block->heap_id != __HEAP->id);
+
+    if (block->large) {
+        old_size = (i64_t)block->pool;
 
-    if (block->order == order)
-        return ptr;
+        // stays large: remap rather than copy
+        if (block->large == LARGE_MAP && order > MAX_BLOCK_ORDER && !foreign) {
+            large = heap_large_resize(block, cap);
+            if (large != NULL)
+                return BLOCK2RAW(large);
+        }
+    } else {
+        old_size = BSIZEOF(block->order);
+
+        if (block->order == order)
+            return ptr;
+    }
 
-    // grow or block is not in the same heap
-    if (order > block->order || (__HEAP->id != 0 && block->heap_id != __HEAP->id) || block->backed) {
+    // grow, leave a large mapping or block is not in the same heap
+    if (block->large || order > block->order || foreign || block->backed) {
         new_ptr = heap_alloc(new_size);
 
         if (new_ptr == NULL) {
@@ -391,7 +687,7 @@ __attribute__((hot)) raw_p heap_realloc(raw_p ptr, i64_t new_size) {
             return NULL;
         }
 
-        memcpy(new_ptr, ptr, old_size - sizeof(struct obj_t));
+        memcpy(new_ptr, ptr, ((old_size < cap) ? old_size : cap) - sizeof(struct obj_t));
         heap_free(ptr);
 
         return new_ptr;
@@ -405,15 +701,57 @@ __attribute__((hot)) raw_p heap_realloc(raw_p ptr, i64_t new_size) {
     return ptr;
 }
 
+// Bytes usable at ptr (its object header included) before heap_realloc has to move or grow it
+i64_t heap_cap(raw_p ptr) {
+    block_p block = RAW2BLOCK(ptr);
+
+    if (block->large)
+        return (i64_t)block->pool - ISIZEOF(struct obj_t);
+
+    return BSIZEOF(block->order) - ISIZEOF(struct obj_t);
+}
+
 nil_t heap_unmap(raw_p ptr, i64_t size) {
     mmap_free(ptr, size);
     __HEAP->memstat.system -= size;
 }
 
+// Merges the slab blocks back into their buddies and unmaps the cached large mappings
+static nil_t heap_release(nil_t) {
+    i64_t i;
+    block_p block, next;
+
+    for (i = MIN_BLOCK_ORDER; i <= SLAB_ORDER; i++) {
+        for (block = __HEAP->slabs[i]; block != NULL; block = next) {
+            next = block->next;
+            heap_coalesce(block, i);
+        }
+
+        __HEAP->slabs[i] = NULL;
+        __HEAP->slab_count[i] = 0;
+    }
+
+    for (block = __HEAP->large; block != NULL; block = next) {
+        next = block->next;
+        __HEAP->memstat.system -= (i64_t)block->pool;
+        mmap_free(block, (i64_t)block->pool);
+    }
+
+    __HEAP->large = NULL;
+    __HEAP->large_count = 0;
+}
+
 i64_t heap_gc(nil_t) {
     i64_t i, size, total = 0;
     block_p block, next;
 
+    heap_drain();
+
+    for (block = __HEAP->large; block != NULL; block = block->next)
+        total += (i64_t)block->pool;
+
+    heap_release();
+
     for (i = MAX_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
         block = __HEAP->freelist[i];
         size = BSIZEOF(i);
@@ -436,19 +774,33 @@ i64_t heap_gc(nil_t) {
 
 nil_t heap_borrow(heap_p heap) {
     i64_t i;
+    block_p block;
 
     for (i = MAX_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
         // Only borrow if the source heap has a freelist[i] and it has more than one node and it is the pool (not a
         // splitted block)
-        if (__HEAP->freelist[i] == NULL || __HEAP->freelist[i]->next == NULL || __HEAP->freelist[i]->pool_order != i)
+        block = __HEAP->freelist[i];
+        if (block == NULL || block->next == NULL)
             continue;
 
-        heap->freelist[i] = __HEAP->freelist[i];
-        __HEAP->freelist[i] = __HEAP->freelist[i]->next;
-        __HEAP->freelist[i]->prev = NULL;
+        // on a NUMA box an executor takes only a pool placed on its own node
+        if (heap->node >= 0) {
+            while (block != NULL && (block->pool_order != i || mmap_node(block) != heap->node))
+                block = block->next;
+
+            if (block == NULL)
+                continue;
+        }
+
+        if (block->pool_order != i)
+            continue;
+
+        heap_remove_block(block, i);
 
-        heap->freelist[i]->next = NULL;
-        heap->freelist[i]->prev = NULL;
+        block->next = NULL;
+        block->prev = NULL;
+        heap->freelist[i] = block;
+        heap->freetail[i] = block;
         heap->avail |= BSIZEOF(i);
     }
 }
@@ -457,40 +809,80 @@ nil_t heap_merge(heap_p heap) {
     i64_t i;
     block_p block, last;
 
-    // First traverse foreign blocks and free them
-    block = heap->foreign_blocks;
-    while (block != NULL) {
-        last = block;
-        block = block->next;
-        last->heap_id = __HEAP->id;
-        heap_free(BLOCK2RAW(last));
-    }
-
-    heap->foreign_blocks = NULL;
-
-    for (i = MIN_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
-        block = heap->freelist[i];
+    // Slab blocks of the executor are buddies of blocks merged below, so they move along
+    for (i = MIN_BLOCK_ORDER; i <= SLAB_ORDER; i++) {
+        block = heap->slabs[i];
         last = NULL;
 
         while (block != NULL) {
             last = block;
+            block->heap_id = __HEAP->id;
             block = block->next;
         }
 
         if (last != NULL) {
-            last->next = __HEAP->freelist[i];
+            last->next = __HEAP->slabs[i];
+            __HEAP->slabs[i] = heap->slabs[i];
+            __HEAP->slab_count[i] += heap->slab_count[i];
+            heap->slabs[i] = NULL;
+            heap->slab_count[i] = 0;
+        }
+    }
+
+    for (i = MIN_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
+        if (heap->freelist[i] == NULL)
+            continue;
 
-            if (__HEAP->freelist[i] != NULL)
-                __HEAP->freelist[i]->prev = last;
+        heap->freetail[i]->next = __HEAP->freelist[i];
 
-            __HEAP->freelist[i] = heap->freelist[i];
+        if (__HEAP->freelist[i] != NULL)
+            __HEAP->freelist[i]->prev = heap->freetail[i];
+        else
+            __HEAP->freetail[i] = heap->freetail[i];
 
-            heap->freelist[i] = NULL;
-        }
+        __HEAP->freelist[i] = heap->freelist[i];
+
+        heap->freelist[i] = NULL;
+        heap->freetail[i] = NULL;
     }
 
     __HEAP->avail |= heap->avail;
     heap->avail = 0;
+
+    // Nothing is freed before the executor's lists are spliced in: coalescing unlinks the free buddies
+    // through this heap's lists, while a buddy may still sit in the executor's ones
+
+    // Blocks of this heap the executors have freed during the run
+    heap_drain();
+
+    // Blocks handed over to the executor, along with the foreign ones it kept, are freed here
+    last = __atomic_exchange_n(&heap->remote, NULL, __ATOMIC_ACQUIRE);
+    if (last != NULL) {
+        for (block = last; block->next != NULL; block = block->next)
+            ;
+        block->next = heap->foreign_blocks;
+        heap->foreign_blocks = last;
+    }
+
+    block = heap->foreign_blocks;
+    while (block != NULL) {
+        last = block;
+        block = block->next;
+        last->heap_id = __HEAP->id;
+        heap_free(BLOCK2RAW(last));
+    }
+
+    heap->foreign_blocks = NULL;
+
+    // the slabs gathered from all the executors are kept bounded, the rest goes back to the buddies
+    for (i = MIN_BLOCK_ORDER; i <= SLAB_ORDER; i++) {
+        while (__HEAP->slab_count[i] > SLAB_LIMIT) {
+            block = __HEAP->slabs[i];
+            __HEAP->slabs[i] = block->next;
+            __HEAP->slab_count[i]--;
+            heap_coalesce(block, i);
+        }
+    }
 }
 
 memstat_t heap_memstat(nil_t) {
@@ -508,6 +900,13 @@ memstat_t heap_memstat(nil_t) {
         }
     }
 
+    // blocks waiting in the slabs and the cached large mappings are free as well
+    for (i = MIN_BLOCK_ORDER; i <= SLAB_ORDER; i++)
+        __HEAP->memstat.free += __HEAP->slab_count[i] * BSIZEOF(i);
+
+    for (block = __HEAP->large; block != NULL; block = block->next)
+        __HEAP->memstat.free += (i64_t)block->pool;
+
     return __HEAP->memstat;
 }
 
@@ -31,6 +31,19 @@
 #define MAX_BLOCK_ORDER 25  // 2^25 = 32MB
 #define MAX_POOL_ORDER 38   // 2^38 = 256GB
 
+// Small blocks are kept in per thread slabs instead of being merged back into their buddies
+#define SLAB_ORDER 6          // 2^6 = 64B
+#define SLAB_REFILL_ORDER 12  // an empty slab is refilled by carving a 2^12 = 4KB block
+#define SLAB_LIMIT 4096       // blocks kept in a slab, the rest are merged back
+#define LARGE_CACHE 4         // freed large mappings kept by the main heap for reuse
+#define HUGE_PAGE_SIZE (2ll << 20)
+#define MAX_HEAPS 1024        // heaps reachable by id for the frees made by other threads
+
+// Large objects (above the pool size) are mapped with their exact page rounded size
+#define LARGE_NONE 0
+#define LARGE_MAP 1      // anonymous mapping, transparent huge pages where available
+#define LARGE_HUGETLB 2  // explicit huge pages
+
 // Memory modes
 #define MMOD_INTERNAL 0xff
 #define MMOD_EXTERNAL_SIMPLE 0xfd
@@ -50,7 +63,7 @@ typedef struct block_t {
     u8_t mode;
     u16_t heap_id;
     b8_t backed;  // backed by a file
-    b8_t pad;
+    u8_t large;   // LARGE_* kind of the mapping, its size is kept in pool
     struct block_t *pool;
     struct block_t *prev;
     struct block_t *next;
@@ -58,20 +71,29 @@ typedef struct block_t {
 
 typedef struct heap_t {
     i64_t id;
+    i64_t node;                            // NUMA node the heap's thread runs on, -1 if not tracked
     block_p freelist[MAX_POOL_ORDER + 2];  // free list of blocks by order
+    block_p freetail[MAX_POOL_ORDER + 2];  // last block of each free list, so heaps merge without walking them
     i64_t avail;                           // mask of available blocks by order
     block_p foreign_blocks;                // foreign blocks (to be freed by the owner)
+    block_p remote;                        // blocks freed by other threads, drained by the owner
     block_p backed_blocks;                 // backed blocks (to be unmapped)
+    block_p slabs[SLAB_ORDER + 1];         // small used blocks ready to be handed out, by order
+    i64_t slab_count[SLAB_ORDER + 1];
+    block_p large;                         // freed large mappings kept for reuse
+    i64_t large_count;
     memstat_t memstat;
 } *heap_p;
 
 heap_p heap_create(i64_t id);
 nil_t heap_destroy(nil_t);
+nil_t heap_set_node(i64_t node);
 heap_p heap_get(nil_t);
 raw_p heap_mmap(i64_t size);
 raw_p heap_stack(i64_t size);
 raw_p heap_alloc(i64_t size);
 raw_p heap_realloc(raw_p ptr, i64_t size);
+i64_t heap_cap(raw_p ptr);  // 0 when the allocator does not tell
 nil_t heap_free(raw_p ptr);
 nil_t heap_unmap(raw_p ptr, i64_t size);
 i64_t heap_gc(nil_t);
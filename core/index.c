@@ -33,6 +33,7 @@
 #include "pool.h"
 #include "runtime.h"  // for RAY_PAGE_SIZE
 #include "serde.h"    // for size_of_type
+#include "order.h"
 
 const i64_t MAX_RANGE = 1 << 20;
 
@@ -350,6 +351,7 @@ obj_p index_scope_partial_i64(i64_t len, i64_t* values, i64_t* indices, i64_t of
 index_scope_t index_scope_i64(i64_t values[], i64_t indices[], i64_t len) {
     i64_t i, chunks, base_chunk, elems_per_page, elem_size, page_size;
     i64_t min, max;
+    u64_t span;
     pool_p pool = pool_get();
     obj_p v;
 
@@ -385,7 +387,58 @@ index_scope_t index_scope_i64(i64_t values[], i64_t indices[], i64_t len) {
         }
     }
     timeit_tick("index scope");
-    return (index_scope_t){min, max, (i64_t)(max - min + 1)};
+
+    // a span wider than i64 (nulls next to large values) saturates: no table is ever built over it
+    span = (u64_t)max - (u64_t)min;
+    return (index_scope_t){min, max, (span < (u64_t)LLONG_MAX) ? (i64_t)span + 1 : LLONG_MAX};
+}
+
+index_scope_t index_scope_u8(u8_t values[], i64_t indices[], i64_t len) {
+    i64_t i, min, max;
+
+    if (len == 0)
+        return (index_scope_t){NULL_I64, NULL_I64, 0};
+
+    min = 255;
+    max = 0;
+
+    if (indices) {
+        for (i = 0; i < len; i++) {
+            min = values[indices[i]] < min ? values[indices[i]] : min;
+            max = values[indices[i]] > max ? values[indices[i]] : max;
+        }
+    } else {
+        for (i = 0; i < len; i++) {
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+    }
+
+    return (index_scope_t){min, max, max - min + 1};
+}
+
+index_scope_t index_scope_i16(i16_t values[], i64_t indices[], i64_t len) {
+    i64_t i, min, max;
+
+    if (len == 0)
+        return (index_scope_t){NULL_I64, NULL_I64, 0};
+
+    min = 32767;
+    max = -32768;
+
+    if (indices) {
+        for (i = 0; i < len; i++) {
+            min = values[indices[i]] < min ? values[indices[i]] : min;
+            max = values[indices[i]] > max ? values[indices[i]] : max;
+        }
+    } else {
+        for (i = 0; i < len; i++) {
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+    }
+
+    return (index_scope_t){min, max, max - min + 1};
 }
 
 obj_p index_distinct_i8(i8_t values[], i64_t len) {
@@ -504,8 +557,9 @@ obj_p index_distinct_i32(i32_t values[], i64_t len) {
 
 obj_p index_distinct_i64(i64_t values[], i64_t len) {
     i64_t i, l, j = 0;
-    i64_t p, *out, *keys;
-    obj_p vec, set;
+    i64_t p, *out;
+    obj_p vec;
+    ht_sw_p set;
     const index_scope_t scope = index_scope_i64(values, NULL, len);
 
     // use open addressing if range is small
@@ -530,32 +584,23 @@ obj_p index_distinct_i64(i64_t values[], i64_t len) {
         return vec;
     }
 
-    // otherwise, use a hash table
-    set = ht_oa_create(len, -1);
-
-    for (i = 0; i < len; i++) {
-        if (values[i] == NULL_I64)
-            continue;
-        p = ht_oa_tab_next(&set, values[i]);
-        out = AS_I64(AS_LIST(set)[0]);
-        if (out[p] == NULL_I64) {
-            out[p] = values[i];
-            j++;
-        }
-    }
-
-    vec = I64(j);
+    // otherwise, number the keys by first appearance and keep the first of each
+    vec = I64(len);
     out = AS_I64(vec);
+    set = ht_sw_create(4096);
+    l = ht_sw_group(&set, values, NULL, out, len, 0);
+    ht_sw_destroy(set);
 
-    keys = AS_I64(AS_LIST(set)[0]);
-    l = AS_LIST(set)[0]->len;
-
-    for (i = 0, j = 0; i < l; i++) {
-        if (keys[i] != NULL_I64)
-            out[j++] = keys[i];
+    // ids never run ahead of the rows, so the keys are compacted in place
+    for (i = 0, p = 0; i < len && p < l; i++) {
+        if (out[i] != p)
+            continue;
+        p++;
+        if (values[i] != NULL_I64)
+            out[j++] = values[i];
     }
 
-    drop_obj(set);
+    resize_obj(&vec, j);
     vec->attrs |= ATTR_DISTINCT;
     return vec;
 }
@@ -1243,9 +1288,10 @@ obj_p index_in_i64_i32(i64_t x[], i64_t xl, i32_t y[], i64_t yl) {
 }
 
 obj_p index_in_i64_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl) {
-    i64_t i, range;
-    i64_t val, min, max;
+    i64_t i, j, n, range;
+    i64_t val, min, max, found[HT_SW_BATCH * 16];
     obj_p vec, set;
+    ht_sw_p ht;
     i8_t *s, *r;
     b8_t nl = B8_FALSE;
 
@@ -1295,21 +1341,23 @@ obj_p index_in_i64_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl) {
     }
 
     // otherwise, use a hash table
-    set = ht_oa_create(xl, -1);
+    ht = ht_sw_create(yl);
 
     for (i = 0; i < yl; i++)
         if (y[i] == NULL_I64)
             nl = B8_TRUE;
         else
-            AS_I64(AS_LIST(set)[0])[ht_oa_tab_next(&set, y[i])] = y[i];
+            ht_sw_insert(&ht, y[i], 0);
 
-    for (i = 0; i < xl; i++)
-        if (x[i] == NULL_I64)
-            r[i] = nl;
-        else
-            r[i] = ht_oa_tab_get(set, x[i]) != NULL_I64;
+    // look the keys up a block at a time
+    for (i = 0; i < xl; i += HT_SW_BATCH * 16) {
+        n = (xl - i < HT_SW_BATCH * 16) ? xl - i : HT_SW_BATCH * 16;
+        ht_sw_find(ht, x + i, found, n);
+        for (j = 0; j < n; j++)
+            r[i + j] = (x[i + j] == NULL_I64) ? nl : found[j] != NULL_I64;
+    }
 
-    drop_obj(set);
+    ht_sw_destroy(ht);
 
     return vec;
 }
@@ -1393,6 +1441,7 @@ obj_p index_find_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl) {
     i64_t i, range;
     i64_t min, max, val, *d, *r;
     obj_p vec, dict;
+    ht_sw_p ht;
 
     if (xl == 0)
         return I64(0);
@@ -1437,23 +1486,15 @@ obj_p index_find_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl) {
         return vec;
     }
 
-    // otherwise, use a hash table
-    dict = ht_oa_create(xl, TYPE_I64);
-
-    for (i = 0; i < xl; i++) {
-        val = ht_oa_tab_next(&dict, x[i]);
-        if (AS_I64(AS_LIST(dict)[0])[val] == NULL_I64) {
-            AS_I64(AS_LIST(dict)[0])[val] = x[i];
-            AS_I64(AS_LIST(dict)[1])[val] = i;
-        }
-    }
+    // otherwise, use a hash table of the first positions
+    ht = ht_sw_create(xl);
 
-    for (i = 0; i < yl; i++) {
-        val = ht_oa_tab_get(dict, y[i]);
-        r[i] = val == NULL_I64 ? NULL_I64 : AS_I64(AS_LIST(dict)[1])[val];
-    }
+    for (i = 0; i < xl; i++)
+        if (x[i] != NULL_I64)
+            ht_sw_insert(&ht, x[i], i);
 
-    drop_obj(dict);
+    ht_sw_find(ht, y, r, yl);
+    ht_sw_destroy(ht);
 
     return vec;
 }
@@ -1571,71 +1612,203 @@ i64_t index_group_shift(obj_p index) { return AS_LIST(index)[3]->i64; }
 
 obj_p index_group_meta(obj_p index) { return AS_LIST(index)[6]; }
 
+i64_t* index_window_lo(obj_p index) { return AS_I64(AS_LIST(index)[2]); }
+
+i64_t* index_window_hi(obj_p index) { return AS_I64(AS_LIST(index)[3]); }
+
+i64_t* index_window_order(obj_p index) {
+    if (AS_LIST(index)[4] != NULL_OBJ)
+        return AS_I64(AS_LIST(index)[4]);
+
+    return NULL;
+}
+
 static obj_p index_group_build(index_type_t tp, i64_t groups_count, obj_p group_ids, obj_p index_min, obj_p source,
                                obj_p filter, obj_p meta) {
     return vn_list(7, i64(tp), i64(groups_count), group_ids, index_min, source, filter, meta);
 }
 
-typedef struct __group_radix_part_ctx_t {
-    i64_t partitions;
-    i64_t partition;
-}* group_radix_part_ctx_p;
-
-obj_p index_group_distribute_partial(group_radix_part_ctx_p ctx, i64_t* groups, i64_t keys[], i64_t filter[],
-                                     i64_t out[], i64_t len, hash_f hash, cmp_f cmp) {
-    i64_t i, partition_id, partitions, size, partition;
-    i64_t *k, *v, n, idx;
-    obj_p ht;
-
-    partitions = ctx->partitions;
-    partition = ctx->partition;
+obj_p index_group_slice(i64_t groups_count, obj_p group_ids, obj_p rows) {
+    return index_group_build(INDEX_TYPE_IDS, groups_count, group_ids, NULL_OBJ, NULL_OBJ, rows, NULL_OBJ);
+}
 
-    size = (partition + 1 < partitions) ? (len / partitions) : (len - (len / partitions) * partition);
-    ht = ht_oa_create(size, TYPE_I64);
+#define INDEX_GROUP_LOCAL_SIZE 4096
 
-    if (filter) {
-        for (i = 0; i < len; i++) {
-            n = keys[filter[i]];
+typedef struct __group_radix_part_ctx_t {
+    i64_t offset;  // first row of the chunk
+    i64_t len;     // rows in the chunk
+    obj_p keys;    // distinct keys of the chunk ordered by partition
+    obj_p ids;     // local ids of the keys
+    obj_p bounds;  // first key of each partition, partitions + 1 entries
+    obj_p remap;   // local id -> group id
+}* group_radix_part_ctx_p;
 
-            // determine if the key is ours due to radix partitioning
-            partition_id = n % partitions;
-            if (partition_id != partition)
-                continue;
+// Phase one: groups the rows of a chunk through a local table (out gets the local ids),
+// then orders the distinct keys by their partition
+obj_p index_group_distribute_local(group_radix_part_ctx_p ctx, i64_t keys[], i64_t filter[], i64_t out[],
+                                   i64_t partitions, hash_f hash, cmp_f cmp) {
+    i64_t i, l, g, n, idx, size, *k, *v, *bounds, *byid, *pk, *pi, *pp;
+    obj_p ht, ids;
+    ht_sw_p sw;
+
+    if (cmp == &hash_cmp_i64) {
+        sw = ht_sw_create(INDEX_GROUP_LOCAL_SIZE);
+        g = ht_sw_group(&sw, filter ? keys : keys + ctx->offset, filter ? filter + ctx->offset : NULL,
+                        out + ctx->offset, ctx->len, 0);
+
+        ids = I64(g);
+        byid = AS_I64(ids);
+        for (i = 0; i < sw->size; i++)
+            if (sw->ctrl[i] != HT_SW_EMPTY)
+                byid[sw->slots[i].val] = sw->slots[i].key;
+
+        ht_sw_destroy(sw);
+    } else {
+        ht = ht_oa_create(INDEX_GROUP_LOCAL_SIZE, TYPE_I64);
+        size = AS_LIST(ht)[0]->len;
 
+        for (i = ctx->offset, l = ctx->offset + ctx->len, g = 0; i < l; i++) {
+            n = filter ? keys[filter[i]] : keys[i];
             idx = ht_oa_tab_next_with(&ht, n, hash, cmp, NULL);
             k = AS_I64(AS_LIST(ht)[0]);
             v = AS_I64(AS_LIST(ht)[1]);
 
             if (k[idx] == NULL_I64) {
                 k[idx] = n;
-                v[idx] = __atomic_fetch_add(groups, 1, __ATOMIC_RELAXED);
+                v[idx] = g++;
             }
 
             out[i] = v[idx];
+
+            // keep the table sparse, probes degrade quickly above half load
+            if (g * 2 > size) {
+                ht_oa_rehash(&ht, hash, NULL);
+                size = AS_LIST(ht)[0]->len;
+            }
         }
-    } else {
-        for (i = 0; i < len; i++) {
-            n = keys[i];
 
-            // determine if the key is ours due to radix partitioning
-            partition_id = n % partitions;
-            if (partition_id != partition)
-                continue;
+        k = AS_I64(AS_LIST(ht)[0]);
+        v = AS_I64(AS_LIST(ht)[1]);
 
-            idx = ht_oa_tab_next_with(&ht, n, hash, cmp, NULL);
+        ids = I64(g);
+        byid = AS_I64(ids);
+        for (i = 0; i < size; i++)
+            if (k[i] != NULL_I64)
+                byid[v[i]] = k[i];
+
+        drop_obj(ht);
+    }
+
+    ctx->bounds = I64(partitions + 1);
+    bounds = AS_I64(ctx->bounds);
+    memset(bounds, 0, (partitions + 1) * sizeof(i64_t));
+
+    // remap holds the partitions of the keys until the merge
+    ctx->remap = I64(g);
+    pp = AS_I64(ctx->remap);
+
+    for (i = 0; i < g; i++) {
+        pp[i] = hash(byid[i], NULL) % partitions;
+        bounds[pp[i] + 1]++;
+    }
+
+    for (i = 0; i < partitions; i++)
+        bounds[i + 1] += bounds[i];
+
+    ctx->keys = I64(g);
+    ctx->ids = I64(g);
+    pk = AS_I64(ctx->keys);
+    pi = AS_I64(ctx->ids);
+
+    i64_t pos[partitions];
+    memcpy(pos, bounds, partitions * sizeof(i64_t));
+
+    for (i = 0; i < g; i++) {
+        n = pos[pp[i]]++;
+        pk[n] = byid[i];
+        pi[n] = i;
+    }
+
+    drop_obj(ids);
+
+    return NULL_OBJ;
+}
+
+// Phase two: merges the keys of one partition from all the chunks, numbering the partition groups from 0
+obj_p index_group_distribute_merge(group_radix_part_ctx_p ctxs, i64_t chunks, i64_t partition, i64_t* groups,
+                                   hash_f hash, cmp_f cmp) {
+    i64_t i, j, l, g, idx, *k, *v, *pk, *pi, *remap;
+    obj_p ht;
+    ht_sw_p sw;
+
+    for (i = 0, l = 0; i < chunks; i++)
+        l += AS_I64(ctxs[i].bounds)[partition + 1] - AS_I64(ctxs[i].bounds)[partition];
+
+    if (cmp == &hash_cmp_i64) {
+        sw = ht_sw_create(l);
+
+        for (i = 0, g = 0; i < chunks; i++) {
+            pk = AS_I64(ctxs[i].keys);
+            pi = AS_I64(ctxs[i].ids);
+            remap = AS_I64(ctxs[i].remap);
+
+            // the keys are not needed after the merge, so they are numbered in place
+            j = AS_I64(ctxs[i].bounds)[partition];
+            l = AS_I64(ctxs[i].bounds)[partition + 1];
+            g = ht_sw_group(&sw, pk + j, NULL, pk + j, l - j, g);
+
+            for (; j < l; j++)
+                remap[pi[j]] = pk[j];
+        }
+
+        ht_sw_destroy(sw);
+        *groups = g;
+
+        return NULL_OBJ;
+    }
+
+    ht = ht_oa_create(l, TYPE_I64);
+
+    for (i = 0, g = 0; i < chunks; i++) {
+        pk = AS_I64(ctxs[i].keys);
+        pi = AS_I64(ctxs[i].ids);
+        remap = AS_I64(ctxs[i].remap);
+
+        for (j = AS_I64(ctxs[i].bounds)[partition]; j < AS_I64(ctxs[i].bounds)[partition + 1]; j++) {
+            idx = ht_oa_tab_next_with(&ht, pk[j], hash, cmp, NULL);
             k = AS_I64(AS_LIST(ht)[0]);
             v = AS_I64(AS_LIST(ht)[1]);
 
             if (k[idx] == NULL_I64) {
-                k[idx] = n;
-                v[idx] = __atomic_fetch_add(groups, 1, __ATOMIC_RELAXED);
+                k[idx] = pk[j];
+                v[idx] = g++;
             }
 
-            out[i] = v[idx];
+            remap[pi[j]] = v[idx];
         }
     }
 
     drop_obj(ht);
+    *groups = g;
+
+    return NULL_OBJ;
+}
+
+// Phase three: shifts the partition group ids by the partition base and rewrites the local ids of the rows
+obj_p index_group_distribute_remap(group_radix_part_ctx_p ctx, i64_t bases[], i64_t partitions, i64_t out[]) {
+    i64_t i, j, l, *pi, *remap, *bounds;
+
+    pi = AS_I64(ctx->ids);
+    remap = AS_I64(ctx->remap);
+    bounds = AS_I64(ctx->bounds);
+
+    for (i = 0; i < partitions; i++) {
+        for (j = bounds[i]; j < bounds[i + 1]; j++)
+            remap[pi[j]] += bases[i];
+    }
+
+    for (i = ctx->offset, l = ctx->offset + ctx->len; i < l; i++)
+        out[i] = remap[out[i]];
 
     return NULL_OBJ;
 }
@@ -1645,11 +1818,20 @@ i64_t index_group_distribute(i64_t keys[], i64_t filter[], i64_t out[], i64_t le
     i64_t idx, n, *k, *v;
     pool_p pool;
     obj_p ht, res;
+    ht_sw_p sw;
 
     pool = pool_get();
     parts = pool_split_by(pool, len, 0);
     groups = 0;
 
+    if (parts == 1 && cmp == &hash_cmp_i64) {
+        sw = ht_sw_create(len);
+        groups = ht_sw_group(&sw, keys, filter, out, len, 0);
+        ht_sw_destroy(sw);
+
+        return groups;
+    }
+
     if (parts == 1) {
         ht = ht_oa_create(len, TYPE_I64);
 
@@ -1688,19 +1870,47 @@ i64_t index_group_distribute(i64_t keys[], i64_t filter[], i64_t out[], i64_t le
         return groups;
     }
 
+    // Chunks of rows are pre-aggregated into local tables, their distinct keys are then merged by
+    // hash partition, so that every key is read about twice instead of once per executor
     struct __group_radix_part_ctx_t ctx[parts];
+    i64_t counts[parts], bases[parts], chunk;
+
+    chunk = (len + parts - 1) / parts;
+    for (i = 0; i < parts; i++) {
+        ctx[i].offset = (i * chunk < len) ? i * chunk : len;
+        ctx[i].len = (ctx[i].offset + chunk < len) ? chunk : len - ctx[i].offset;
+    }
+
+    pool_prepare(pool);
+    for (i = 0; i < parts; i++)
+        pool_add_task(pool, (raw_p)index_group_distribute_local, 7, &ctx[i], keys, filter, out, parts, hash, cmp);
+    res = pool_run(pool);
+    drop_obj(res);
 
     pool_prepare(pool);
+    for (i = 0; i < parts; i++)
+        pool_add_task(pool, (raw_p)index_group_distribute_merge, 6, ctx, parts, i, &counts[i], hash, cmp);
+    res = pool_run(pool);
+    drop_obj(res);
+
     for (i = 0; i < parts; i++) {
-        ctx[i].partitions = parts;
-        ctx[i].partition = i;
-        pool_add_task(pool, (raw_p)index_group_distribute_partial, 8, &ctx[i], &groups, keys, filter, out, len, hash,
-                      cmp);
+        bases[i] = groups;
+        groups += counts[i];
     }
 
+    pool_prepare(pool);
+    for (i = 0; i < parts; i++)
+        pool_add_task(pool, (raw_p)index_group_distribute_remap, 4, &ctx[i], bases, parts, out);
     res = pool_run(pool);
     drop_obj(res);
 
+    for (i = 0; i < parts; i++) {
+        drop_obj(ctx[i].keys);
+        drop_obj(ctx[i].ids);
+        drop_obj(ctx[i].bounds);
+        drop_obj(ctx[i].remap);
+    }
+
     return groups;
 }
 
@@ -1976,15 +2186,142 @@ obj_p index_group(obj_p val, obj_p filter) {
     }
 }
 
-obj_p index_group_list_perfect(obj_p obj, obj_p filter) {
+// Adds the scaled code of each key column to the packed keys of rows [offset, offset + len)
+obj_p index_group_pack_partial(obj_p cols, obj_p codes, index_scope_t scopes[], i64_t multipliers[], i64_t filter[],
+                               i64_t out[], i64_t len, i64_t offset) {
     u8_t* xb;
-    u64_t i, j, l, len, product;
-    i64_t *xi, *xo, *indices;
-    obj_p ht, col, res, *values;
-    index_scope_t *scopes, scope;
+    i16_t* xs;
+    i32_t* xw;
+    i64_t i, j, l, m, min, *xi;
+    obj_p col;
+
+    l = offset + len;
+
+    for (i = 0; i < (i64_t)cols->len; i++) {
+        m = multipliers[i];
+        min = scopes[i].min;
+
+        // dense group ids are already relative to the filter
+        if (AS_LIST(codes)[i] != NULL_OBJ) {
+            xi = AS_I64(AS_LIST(codes)[i]);
+            for (j = offset; j < l; j++)
+                out[j] += xi[j] * m;
+            continue;
+        }
+
+        col = AS_LIST(cols)[i];
+        switch (col->type) {
+            case TYPE_B8:
+            case TYPE_U8:
+            case TYPE_C8:
+                xb = AS_U8(col);
+                if (filter) {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xb[filter[j]] - min) * m;
+                } else {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xb[j] - min) * m;
+                }
+                break;
+            case TYPE_I16:
+                xs = AS_I16(col);
+                if (filter) {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xs[filter[j]] - min) * m;
+                } else {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xs[j] - min) * m;
+                }
+                break;
+            case TYPE_I32:
+            case TYPE_DATE:
+            case TYPE_TIME:
+                xw = AS_I32(col);
+                if (filter) {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xw[filter[j]] - min) * m;
+                } else {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xw[j] - min) * m;
+                }
+                break;
+            default:
+                xi = (col->type == TYPE_ENUM) ? AS_I64(ENUM_VAL(col)) : AS_I64(col);
+                if (filter) {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xi[filter[j]] - min) * m;
+                } else {
+                    for (j = offset; j < l; j++)
+                        out[j] += (xi[j] - min) * m;
+                }
+                break;
+        }
+    }
+
+    return NULL_OBJ;
+}
+
+// Replaces the column i by its dense group ids
+static nil_t index_group_list_code(obj_p codes, index_scope_t scopes[], i64_t i, obj_p col, obj_p filter) {
+    i64_t j, l, groups;
+    obj_p idx, wide;
+
+    switch (col->type) {
+        case TYPE_I16:
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            // there are no tables over the narrower ints, their values are widened to be coded
+            l = col->len;
+            wide = I64(l);
+            if (col->type == TYPE_I16) {
+                for (j = 0; j < l; j++)
+                    AS_I64(wide)[j] = AS_I16(col)[j];
+            } else {
+                for (j = 0; j < l; j++)
+                    AS_I64(wide)[j] = AS_I32(col)[j];
+            }
+
+            idx = index_group_i64_unscoped(wide, filter);
+            drop_obj(wide);
+            break;
+        case TYPE_F64:
+            idx = index_group_f64(col, filter);
+            break;
+        case TYPE_GUID:
+            idx = index_group_guid(col, filter);
+            break;
+        case TYPE_LIST:
+            idx = index_group_obj(col, filter);
+            break;
+        case TYPE_ENUM:
+            idx = index_group_i64_unscoped(ENUM_VAL(col), filter);
+            break;
+        default:
+            idx = index_group_i64_unscoped(col, filter);
+            break;
+    }
+
+    groups = index_group_count(idx);
+    scopes[i] = (index_scope_t){0, groups - 1, (groups > 0) ? groups : 1};
+    AS_LIST(codes)[i] = clone_obj(AS_LIST(idx)[2]);
+    drop_obj(idx);
+}
+
+// Groups by several columns packed into a single 64-bit key per row. Integral columns contribute their
+// offset from the min, scaled by the product of the previous ranges. Other columns, and the widest
+// integral ones while the ranges do not fit, contribute their dense group ids instead. The packed keys are grouped through a direct
+// table when their product fits the rows count and through the radix partitioned tables otherwise.
+// Returns NULL if a column can not be coded or the product overflows 63 bits.
+obj_p index_group_list_packed(obj_p obj, obj_p filter) {
+    u64_t product;
+    i64_t i, l, len, wide, groups, chunks, base_chunk, elems_per_page;
+    i64_t *hk, *xo, *out, *indices;
+    obj_p col, codes, packed, keys, vals, v, *values;
+    index_scope_t* scopes;
+    pool_p pool;
 
     l = obj->len;
-    i64_t multipliers[l];
 
     if (l == 0)
         return NULL_OBJ;
@@ -1993,123 +2330,168 @@ obj_p index_group_list_perfect(obj_p obj, obj_p filter) {
     indices = is_null(filter) ? NULL : AS_I64(filter);
     len = indices ? filter->len : values[0]->len;
 
-    // First, check if columns types are suitable for perfect hashing
+    if (len == 0)
+        return NULL_OBJ;
+
+    // First, check if columns types can be coded
     for (i = 0; i < l; i++) {
         switch (values[i]->type) {
             case TYPE_B8:
             case TYPE_U8:
             case TYPE_C8:
+            case TYPE_I16:
+            case TYPE_I32:
+            case TYPE_DATE:
+            case TYPE_TIME:
             case TYPE_I64:
             case TYPE_SYMBOL:
             case TYPE_TIMESTAMP:
             case TYPE_ENUM:
+            case TYPE_F64:
+            case TYPE_GUID:
+            case TYPE_LIST:
                 break;
             default:
                 return NULL_OBJ;
         }
     }
 
+    i64_t multipliers[l];
     scopes = (index_scope_t*)heap_alloc(l * sizeof(index_scope_t));
+    codes = LIST(l);
+    for (i = 0; i < l; i++)
+        AS_LIST(codes)[i] = NULL_OBJ;
 
-    // calculate scopes of each column to check if we can use direct hashing
+    // calculate the range of each integral column, the others are always replaced by their group ids
     for (i = 0; i < l; i++) {
-        switch (values[i]->type) {
+        col = values[i];
+        switch (col->type) {
             case TYPE_B8:
             case TYPE_U8:
             case TYPE_C8:
-                scopes[i].max = 255;
-                scopes[i].min = 0;
-                scopes[i].range = 256;
+                scopes[i] = index_scope_u8(AS_U8(col), indices, len);
+                break;
+            case TYPE_I16:
+                scopes[i] = index_scope_i16(AS_I16(col), indices, len);
+                break;
+            case TYPE_I32:
+            case TYPE_DATE:
+            case TYPE_TIME:
+                scopes[i] = index_scope_i32(AS_I32(col), indices, len);
                 break;
             case TYPE_I64:
             case TYPE_SYMBOL:
             case TYPE_TIMESTAMP:
             case TYPE_ENUM:
-                scopes[i] = index_scope_i64(AS_I64(values[i]), indices, len);
+                scopes[i] = index_scope_i64(AS_I64((col->type == TYPE_ENUM) ? ENUM_VAL(col) : col), indices, len);
+                // the offsets from the min would not fit
+                if (scopes[i].range < 1 || scopes[i].range == LLONG_MAX)
+                    index_group_list_code(codes, scopes, i, col, filter);
                 break;
             default:
-                // because we already checked the types, this should never happen
-                __builtin_unreachable();
+                index_group_list_code(codes, scopes, i, col, filter);
+                break;
         }
     }
 
-    // Precompute multipliers for each column
-    for (i = 0, product = 1, scope = (index_scope_t){0, 0, 0}; i < l; i++) {
-        if (ULLONG_MAX / product < (u64_t)scopes[i].range) {
+    // while the ranges do not fit, replace the widest integral column by its group ids
+    for (;;) {
+        for (i = 0, product = 1, wide = -1; i < l; i++) {
+            // keep the packed keys positive: they are radix partitioned by their value
+            if (LLONG_MAX / product < (u64_t)scopes[i].range) {
+                product = 0;
+                break;
+            }
+
+            multipliers[i] = product;
+            product *= scopes[i].range;
+        }
+
+        if (product > 0)
+            break;
+
+        for (i = 0; i < l; i++) {
+            if (AS_LIST(codes)[i] == NULL_OBJ && scopes[i].range > len &&
+                (wide < 0 || scopes[i].range > scopes[wide].range))
+                wide = i;
+        }
+
+        if (wide < 0) {
             heap_free(scopes);
+            drop_obj(codes);
             return NULL_OBJ;  // Overflow would occur
         }
 
-        scope.max += (scopes[i].max - scopes[i].min) * product;
-
-        multipliers[i] = product;
-        product *= scopes[i].range;
+        index_group_list_code(codes, scopes, wide, values[wide], filter);
     }
 
-    scope.range = scope.max + 1;
+    timeit_tick("group index list codes");
 
-    ht = I64(len);
-    xo = AS_I64(ht);
+    packed = I64(len);
+    xo = AS_I64(packed);
     memset(xo, 0, len * sizeof(i64_t));
 
-    for (i = 0; i < l; i++) {
-        col = values[i];
-        switch (col->type) {
-            case TYPE_B8:
-            case TYPE_U8:
-            case TYPE_C8:
-                xb = AS_U8(col);
-                if (indices) {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xb[indices[j]] - scopes[i].min) * multipliers[i];
-                } else {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xb[j] - scopes[i].min) * multipliers[i];
-                }
-                break;
-            case TYPE_I64:
-            case TYPE_SYMBOL:
-            case TYPE_TIMESTAMP:
-                xi = AS_I64(col);
-                if (indices) {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[indices[j]] - scopes[i].min) * multipliers[i];
-                } else {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[j] - scopes[i].min) * multipliers[i];
-                }
-                break;
-            case TYPE_ENUM:
-                xi = AS_I64(ENUM_VAL(col));
-                if (indices) {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[indices[j]] - scopes[i].min) * multipliers[i];
-                } else {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[j] - scopes[i].min) * multipliers[i];
-                }
-                break;
-            case TYPE_F64:
-                xi = (i64_t*)AS_F64(col);
-                if (indices) {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[indices[j]] - scopes[i].min) * multipliers[i];
-                } else {
-                    for (j = 0; j < len; j++)
-                        xo[j] += (xi[j] - scopes[i].min) * multipliers[i];
-                }
-                break;
-            default:
-                // because we already checked the types, this should never happen
-                __builtin_unreachable();
-        }
+    pool = pool_get();
+    chunks = pool_split_by(pool, len, 0);
+    elems_per_page = RAY_PAGE_SIZE / sizeof(i64_t);
+    base_chunk = (len + chunks - 1) / chunks;
+    base_chunk = ((base_chunk + elems_per_page - 1) / elems_per_page) * elems_per_page;
+
+    if (chunks == 1)
+        index_group_pack_partial(obj, codes, scopes, multipliers, indices, xo, len, 0);
+    else {
+        pool_prepare(pool);
+        for (i = 0; i < chunks - 1; i++)
+            pool_add_task(pool, (raw_p)index_group_pack_partial, 8, obj, codes, scopes, multipliers, indices, xo,
+                          base_chunk, i * base_chunk);
+        pool_add_task(pool, (raw_p)index_group_pack_partial, 8, obj, codes, scopes, multipliers, indices, xo,
+                      len - (chunks - 1) * base_chunk, (chunks - 1) * base_chunk);
+        v = pool_run(pool);
+        drop_obj(v);
     }
 
     heap_free(scopes);
-    res = index_group_i64_scoped(ht, NULL_OBJ, scope);
-    drop_obj(ht);
+    drop_obj(codes);
 
-    return res;
+    timeit_tick("group index list pack");
+
+    // wide product: radix partitioned tables, one partition per executor
+    if (product > (u64_t)len) {
+        vals = I64(len);
+        out = AS_I64(vals);
+        groups = index_group_distribute(xo, NULL, out, len, &hash_fnv1a, &hash_cmp_i64);
+        drop_obj(packed);
+
+        return index_group_build(INDEX_TYPE_IDS, groups, vals, i64(NULL_I64), NULL_OBJ, clone_obj(filter), NULL_OBJ);
+    }
+
+    // narrow product: direct table, group ids in the order of appearance
+    keys = I64(product);
+    hk = AS_I64(keys);
+    for (i = 0; i < (i64_t)product; i++)
+        hk[i] = NULL_I64;
+
+    for (i = 0, groups = 0; i < len; i++) {
+        if (hk[xo[i]] == NULL_I64)
+            hk[xo[i]] = groups++;
+    }
+
+    if (chunks == 1)
+        index_group_i64_scoped_partial(xo, NULL, hk, len, 0, 0, xo);
+    else {
+        pool_prepare(pool);
+        for (i = 0; i < chunks - 1; i++)
+            pool_add_task(pool, (raw_p)index_group_i64_scoped_partial, 7, xo, NULL, hk, base_chunk, i * base_chunk,
+                          0, xo);
+        pool_add_task(pool, (raw_p)index_group_i64_scoped_partial, 7, xo, NULL, hk, len - (chunks - 1) * base_chunk,
+                      (chunks - 1) * base_chunk, 0, xo);
+        v = pool_run(pool);
+        drop_obj(v);
+    }
+
+    drop_obj(keys);
+
+    return index_group_build(INDEX_TYPE_IDS, groups, packed, i64(NULL_I64), NULL_OBJ, clone_obj(filter), NULL_OBJ);
 }
 
 obj_p index_group_list(obj_p obj, obj_p filter) {
@@ -2124,10 +2506,10 @@ obj_p index_group_list(obj_p obj, obj_p filter) {
     if (ops_count(obj) == 1)
         return index_group(AS_LIST(obj)[0], filter);
 
-    // If the list values range is small, use perfect hashing
-    res = index_group_list_perfect(obj, filter);
+    // If the key columns pack into 64 bits, group by the packed keys
+    res = index_group_list_packed(obj, filter);
     if (!is_null(res)) {
-        timeit_tick("group index list perfect");
+        timeit_tick("group index list packed");
         return res;
     }
 
@@ -2380,22 +2762,68 @@ i64_t index_bin_f64(f64_t val, f64_t vals[], i64_t ids[], i64_t len) {
     return ids[idx];
 }
 
-static obj_p __asof_ids_partial(__index_list_ctx_t* ctx, obj_p lxcol, obj_p rxcol, obj_p ht, i64_t len, i64_t offset,
-                                obj_p ids) {
-    i64_t i, idx, p;
+obj_p index_join_ranges(obj_p rcols, i64_t rl) {
+    i64_t i, idx;
+    obj_p ht, hashes;
+    __index_list_ctx_t ctx;
+
+    ht = ht_oa_create(rl, TYPE_I64);
+    hashes = I64(rl);
+
+    __index_list_precalc_hash(rcols, (i64_t*)AS_I64(hashes), rcols->len, rl, NULL, B8_TRUE);
+    ctx = (__index_list_ctx_t){rcols, rcols, (i64_t*)AS_I64(hashes), NULL};
+    for (i = 0; i < rl; i++) {
+        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
+        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64)
+            AS_I64(AS_LIST(ht)[0])[idx] = i;
+        AS_I64(AS_LIST(ht)[1])[idx] = i;
+    }
+
+    drop_obj(hashes);
+
+    return ht;
+}
+
+// Last row in [First, Last] with a value not greater than Val, NULL_I64 if there is none
+#define INDEX_RANGE_BIN(Val, Vals, First, Last)             \
+    ({                                                      \
+        i64_t $l = (First), $r = (Last), $m, $p = NULL_I64; \
+        while ($l <= $r) {                                  \
+            $m = $l + ($r - $l) / 2;                        \
+            if ((Vals)[$m] <= (Val)) {                      \
+                $p = $m;                                    \
+                $l = $m + 1;                                \
+            } else {                                        \
+                $r = $m - 1;                                \
+            }                                               \
+        }                                                   \
+        $p;                                                 \
+    })
+
+static obj_p __asof_ids_partial(__index_list_ctx_t* ctx, obj_p lxcol, obj_p rxcol, obj_p ranges, i64_t len,
+                                i64_t offset, obj_p ids) {
+    i64_t i, idx, *first, *last, *out;
+
+    first = AS_I64(AS_LIST(ranges)[0]);
+    last = AS_I64(AS_LIST(ranges)[1]);
+    out = AS_I64(ids);
 
     switch (lxcol->type) {
         case TYPE_I32:
         case TYPE_DATE:
         case TYPE_TIME:
             for (i = offset; i < len + offset; i++) {
-                idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
-                if (idx != NULL_I64) {
-                    p = index_bin_i32(AS_I32(lxcol)[i], AS_I32(rxcol), AS_I64(AS_LIST(AS_LIST(ht)[1])[idx]),
-                                      AS_LIST(AS_LIST(ht)[1])[idx]->len);
-                    AS_I64(ids)[i] = p;
-                } else
-                    AS_I64(ids)[i] = NULL_I64;
+                idx = ht_oa_tab_get_with(ranges, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
+                out[i] = (idx == NULL_I64) ? NULL_I64
+                                           : INDEX_RANGE_BIN(AS_I32(lxcol)[i], AS_I32(rxcol), first[idx], last[idx]);
+            }
+            break;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            for (i = offset; i < len + offset; i++) {
+                idx = ht_oa_tab_get_with(ranges, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
+                out[i] = (idx == NULL_I64) ? NULL_I64
+                                           : INDEX_RANGE_BIN(AS_I64(lxcol)[i], AS_I64(rxcol), first[idx], last[idx]);
             }
             break;
         default:
@@ -2405,36 +2833,17 @@ static obj_p __asof_ids_partial(__index_list_ctx_t* ctx, obj_p lxcol, obj_p rxco
     return NULL_OBJ;
 }
 
-obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol) {
-    i64_t i, ll, rl, n, chunk;
-    obj_p v, ht, ids, hashes;
-    i64_t idx;
+obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p ranges) {
+    i64_t i, ll, n, chunk;
+    obj_p v, ids, hashes;
     __index_list_ctx_t ctx;
     pool_p pool;
 
-    ll = ops_count(AS_LIST(lcols)[0]);
-    rl = ops_count(AS_LIST(rcols)[0]);
-    ht = ht_oa_create(rl, TYPE_I64);
-    hashes = I64(MAXI64(ll, rl));
-
-    // Right hashes
-    __index_list_precalc_hash(rcols, (i64_t*)AS_I64(hashes), rcols->len, rl, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, rcols, (i64_t*)AS_I64(hashes), NULL};
-    for (i = 0; i < rl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64) {
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-            v = I64(1);
-            AS_I64(v)[0] = i;
-            AS_LIST(AS_LIST(ht)[1])[idx] = v;
-        } else {
-            push_raw(AS_LIST(AS_LIST(ht)[1]) + idx, (raw_p)&i);
-        }
-    }
-
+    ll = ops_count(lxcol);
     ids = I64(ll);
+    hashes = I64(ll);
 
-    // Left hashes
+    // Left hashes, looked up in the key ranges of the sorted right side
     __index_list_precalc_hash(lcols, (i64_t*)AS_I64(hashes), lcols->len, ll, NULL, B8_TRUE);
     ctx = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(hashes), NULL};
 
@@ -2442,115 +2851,156 @@ obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol) {
     n = pool_split_by(pool, ll, 0);
 
     if (n == 1) {
-        __asof_ids_partial(&ctx, lxcol, rxcol, ht, ll, 0, ids);
-        goto clean;
+        v = __asof_ids_partial(&ctx, lxcol, rxcol, ranges, ll, 0, ids);
     } else {
         pool_prepare(pool);
         chunk = ll / n;
 
         for (i = 0; i < n - 1; i++)
-            pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ht, chunk, i * chunk, ids);
-        pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ht, ll - i * chunk, i * chunk, ids);
+            pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ranges, chunk, i * chunk, ids);
+        pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ranges, ll - i * chunk, i * chunk, ids);
         v = pool_run(pool);
-
-        if (IS_ERR(v)) {
-            drop_obj(ids);
-            drop_obj(hashes);
-            drop_obj(ht);
-            return v;
-        }
-
-        drop_obj(v);
     }
 
-clean:
     drop_obj(hashes);
-    rl = AS_LIST(ht)[0]->len;
-    for (i = 0; i < rl; i++)
-        if (AS_I64(AS_LIST(ht)[0])[i] != NULL_I64)
-            drop_obj(AS_LIST(AS_LIST(ht)[1])[i]);
 
-    drop_obj(ht);
+    if (IS_ERR(v)) {
+        drop_obj(ids);
+        return v;
+    }
+
+    drop_obj(v);
 
     return ids;
 }
 
-static obj_p __window_join_fill(__index_list_ctx_t* ctx, obj_p ht, i64_t len, i64_t offset, obj_p out) {
-    i64_t i, idx;
-    obj_p* ids;
-
-    ids = AS_LIST(out);
-    len += offset;
-
-    for (i = offset; i < len; i++) {
-        idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
-        if (idx != NULL_I64)
-            ids[i] = clone_obj(AS_LIST(AS_LIST(ht)[1])[idx]);
-        else
-            ids[i] = NULL_OBJ;
+// First row in [First, Last] with a value not less than Val, NULL_I64 if there is none
+#define INDEX_RANGE_LBIN(Val, Vals, First, Last)            \
+    ({                                                      \
+        i64_t $l = (First), $r = (Last), $m, $p = NULL_I64; \
+        while ($l <= $r) {                                  \
+            $m = $l + ($r - $l) / 2;                        \
+            if ((Vals)[$m] >= (Val)) {                      \
+                $p = $m;                                    \
+                $r = $m - 1;                                \
+            } else {                                        \
+                $l = $m + 1;                                \
+            }                                               \
+        }                                                   \
+        $p;                                                 \
+    })
+
+typedef struct __window_join_ctx_t {
+    __index_list_ctx_t keys;  // left key columns against the right ones
+    obj_p ranges;             // key ranges of the sorted right side
+    obj_p rxcol;              // sorted right times
+    obj_p kl, kr;             // window bounds of every left row
+    i64_t jtype;              // 1 when the window excludes the quote prevailing at its start
+} __window_join_ctx_t;
+
+// Window of every left row as rows [lo, hi] of the sorted right side, lo > hi for an empty one.
+// A window-join window also takes the last quote at or before its start.
+#define WINDOW_JOIN_SPANS(Ctx, Len, Offset, Lo, Hi, t)                                                     \
+    ({                                                                                                     \
+        i64_t $i, $idx, $l, $h, *$first, *$last;                                                           \
+        t##_t *$rx = __AS_##t((Ctx)->rxcol), *$kl = __AS_##t((Ctx)->kl), *$kr = __AS_##t((Ctx)->kr);       \
+        $first = AS_I64(AS_LIST((Ctx)->ranges)[0]);                                                        \
+        $last = AS_I64(AS_LIST((Ctx)->ranges)[1]);                                                         \
+        for ($i = (Offset); $i < (Offset) + (Len); $i++) {                                                 \
+            (Lo)[$i] = 0;                                                                                  \
+            (Hi)[$i] = -1;                                                                                 \
+            $idx = ht_oa_tab_get_with((Ctx)->ranges, $i, &__index_list_hash_get, &__index_list_cmp_row,    \
+                                      &(Ctx)->keys);                                                       \
+            if ($idx == NULL_I64)                                                                          \
+                continue;                                                                                  \
+            $h = INDEX_RANGE_BIN($kr[$i], $rx, $first[$idx], $last[$idx]);                                 \
+            if ((Ctx)->jtype == 0) {                                                                       \
+                $l = INDEX_RANGE_BIN($kl[$i], $rx, $first[$idx], $last[$idx]);                             \
+                if ($l == NULL_I64)                                                                        \
+                    $l = $first[$idx];                                                                     \
+            } else {                                                                                       \
+                $l = INDEX_RANGE_LBIN($kl[$i], $rx, $first[$idx], $last[$idx]);                            \
+            }                                                                                              \
+            if ($l != NULL_I64 && $h != NULL_I64) {                                                        \
+                (Lo)[$i] = $l;                                                                             \
+                (Hi)[$i] = $h;                                                                             \
+            }                                                                                              \
+        }                                                                                                  \
+    })
+
+static obj_p __window_join_fill(__window_join_ctx_t* ctx, i64_t len, i64_t offset, obj_p lo, obj_p hi) {
+    switch (ctx->rxcol->type) {
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            WINDOW_JOIN_SPANS(ctx, len, offset, AS_I64(lo), AS_I64(hi), i32);
+            return NULL_OBJ;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            WINDOW_JOIN_SPANS(ctx, len, offset, AS_I64(lo), AS_I64(hi), i64);
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "window-join: invalid type: %s", type_name(ctx->rxcol->type));
     }
-
-    return NULL_OBJ;
 }
 
-obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p windows, obj_p ltab, obj_p rtab,
+obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p ranges, obj_p windows,
                             i64_t jtype) {
-    i64_t i, ll, rl, n, chunk;
-    obj_p v, ht, hashes, index;
-    i64_t idx;
-    __index_list_ctx_t ctx;
+    i64_t i, ll, n, chunk, start;
+    obj_p v, hashes, lo, hi, order;
+    __window_join_ctx_t ctx;
     pool_p pool;
 
-    ll = ops_count(ltab);
-    rl = ops_count(rtab);
-    ht = ht_oa_create(rl, TYPE_I64);
-    hashes = I64(MAXI64(ll, rl));
+    ll = ops_count(lxcol);
+    lo = I64(ll);
+    hi = I64(ll);
+    hashes = I64(ll);
 
-    // Right hashes
-    __index_list_precalc_hash(rcols, (i64_t*)AS_I64(hashes), rcols->len, rl, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, rcols, (i64_t*)AS_I64(hashes), NULL};
-    for (i = 0; i < rl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64) {
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-            v = I64(2);
-            AS_I64(v)[0] = i;
-            AS_I64(v)[1] = i;
-            AS_LIST(AS_LIST(ht)[1])[idx] = v;
-        } else {
-            AS_I64(AS_LIST(AS_LIST(ht)[1])[idx])[1] = i;
-        }
-    }
-
-    index = LIST(ll);
-
-    // Left hashes
+    // Left hashes, looked up in the key ranges of the sorted right side
     __index_list_precalc_hash(lcols, (i64_t*)AS_I64(hashes), lcols->len, ll, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(hashes), NULL};
+    ctx = (__window_join_ctx_t){
+        .keys = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(hashes), NULL},
+        .ranges = ranges,
+        .rxcol = rxcol,
+        .kl = AS_LIST(windows)[0],
+        .kr = AS_LIST(windows)[1],
+        .jtype = jtype,
+    };
 
     pool = pool_get();
     n = pool_split_by(pool, ll, 0);
 
     if (n == 1) {
-        __window_join_fill(&ctx, ht, ll, 0, index);
+        v = __window_join_fill(&ctx, ll, 0, lo, hi);
     } else {
         pool_prepare(pool);
         chunk = ll / n;
         for (i = 0; i < n - 1; i++)
-            pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, ht, chunk, i * chunk, index);
-        pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, ht, ll - i * chunk, i * chunk, index);
+            pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, chunk, i * chunk, lo, hi);
+        pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, ll - i * chunk, i * chunk, lo, hi);
         v = pool_run(pool);
-        drop_obj(v);
     }
 
     drop_obj(hashes);
-    rl = AS_LIST(ht)[0]->len;
-    for (i = 0; i < rl; i++)
-        if (AS_I64(AS_LIST(ht)[0])[i] != NULL_I64)
-            drop_obj(AS_LIST(AS_LIST(ht)[1])[i]);
 
-    drop_obj(ht);
+    if (IS_ERR(v)) {
+        drop_obj(lo);
+        drop_obj(hi);
+        return v;
+    }
+
+    drop_obj(v);
 
-    return index_group_build(INDEX_TYPE_WINDOW, ll, clone_obj(lxcol), clone_obj(rxcol), clone_obj(windows), index,
-                             i64(jtype));
-}
\ No newline at end of file
+    // Windows are walked by their starts, which keeps the windows of a key together and in order
+    for (i = 0, start = 0; i < ll; i++) {
+        if (AS_I64(lo)[i] > AS_I64(hi)[i])
+            continue;
+        if (AS_I64(lo)[i] < start)
+            break;
+        start = AS_I64(lo)[i];
+    }
+
+    order = (i < ll) ? ray_iasc(lo) : NULL_OBJ;
+
+    return index_group_build(INDEX_TYPE_WINDOW, ll, lo, hi, order, NULL_OBJ, NULL_OBJ);
+}
@@ -63,6 +63,13 @@ i64_t *index_group_filter_ids(obj_p index);
 obj_p index_group_filter(obj_p index);
 i64_t index_group_shift(obj_p index);
 obj_p index_group_meta(obj_p index);
+// Window index: rows [lo, hi] of the right side for every left row (lo > hi if empty),
+// and the left rows ordered by window start (NULL if they already are)
+i64_t *index_window_lo(obj_p index);
+i64_t *index_window_hi(obj_p index);
+i64_t *index_window_order(obj_p index);
+// Group index over the given rows of a column, group_ids[i] being the group of rows[i]
+obj_p index_group_slice(i64_t groups_count, obj_p group_ids, obj_p rows);
 obj_p index_distinct_i8(i8_t values[], i64_t len);
 obj_p index_distinct_i16(i16_t values[], i64_t len);
 obj_p index_distinct_i32(i32_t values[], i64_t len);
@@ -99,8 +106,10 @@ i64_t index_bin_i16(i16_t val, i16_t vals[], i64_t ids[], i64_t len);
 i64_t index_bin_i32(i32_t val, i32_t vals[], i64_t ids[], i64_t len);
 i64_t index_bin_i64(i64_t val, i64_t vals[], i64_t ids[], i64_t len);
 i64_t index_bin_f64(f64_t val, f64_t vals[], i64_t ids[], i64_t len);
-obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol);
-obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p windows, obj_p ltab, obj_p rtab,
+// Key ranges of a table sorted by its join keys: a hash of the key columns to the first and last rows of each key
+obj_p index_join_ranges(obj_p rcols, i64_t rl);
+obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p ranges);
+obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p ranges, obj_p windows,
                             i64_t jtype);
 obj_p index_upsert_obj(obj_p lcols, obj_p rcols, i64_t len);
 nil_t index_hash_obj(obj_p obj, i64_t out[], i64_t filter[], i64_t len, b8_t resolve);
@@ -43,6 +43,8 @@
 #include "compose.h"
 #include "items.h"
 #include "ipc.h"
+#include "symbols.h"
+#include "mmap.h"
 
 obj_p ray_hopen(obj_p *x, i64_t n) {
     i64_t fd, id, timeout = 0;
@@ -781,15 +783,75 @@ obj_p distinct_syms(obj_p *x, i64_t n) {
     return vec;
 }
 
+// Size and content hash of the sym file, the image saved next to it is only valid for the same one
+static i64_t io_symfile_stamp(lit_p file, u64_t *hash) {
+    i64_t fd, size;
+    str_p data;
+
+    fd = fs_fopen(file, ATTR_RDONLY);
+    if (fd == -1)
+        return -1;
+
+    size = fs_fsize(fd);
+    data = (size > 0) ? (str_p)mmap_file_private(fd, NULL, size, 0) : NULL;
+    fs_fclose(fd);
+
+    if (size > 0 && data == NULL)
+        return -1;
+
+    *hash = str_hash(data, size);
+    if (data != NULL)
+        mmap_free(data, size);
+
+    return size;
+}
+
+// Saves the symbols image next to the sym file, it is just a cache so a failure leaves no image at all
+static nil_t io_set_symimage(obj_p symfile, obj_p sym) {
+    i64_t size;
+    u64_t hash;
+    obj_p file, image, res;
+
+    file = cstring_from_obj(symfile);
+    image = str_fmt(-1, "%s.idx", AS_C8(file));
+    size = io_symfile_stamp(AS_C8(file), &hash);
+
+    res = (size == -1) ? NULL_OBJ : symbols_save(AS_C8(image), sym, size, hash);
+
+    if (size == -1 || IS_ERR(res))
+        fs_fdelete(AS_C8(image));
+
+    drop_obj(res);
+    drop_obj(image);
+    drop_obj(file);
+}
+
+// Maps the symbols image if it is up to date with the sym file, falls back to reading the sym file otherwise
+static obj_p io_get_symimage(obj_p symfile) {
+    i64_t size;
+    u64_t hash;
+    obj_p file, image, v;
+
+    file = cstring_from_obj(symfile);
+    image = str_fmt(-1, "%s.idx", AS_C8(file));
+    size = io_symfile_stamp(AS_C8(file), &hash);
+    v = (size == -1) ? NULL_OBJ : symbols_load(AS_C8(image), size, hash);
+
+    drop_obj(image);
+    drop_obj(file);
+
+    return (v == NULL_OBJ) ? ray_get(symfile) : v;
+}
+
 obj_p io_get_symfile(obj_p path) {
     obj_p s, col, v;
 
     if (path->len < 2 || AS_C8(path)[path->len - 1] != '/') {
-        v = ray_get(path);
+        v = io_get_symimage(path);
     } else {
         s = string_from_str("sym", 3);
         col = ray_concat(path, s);
-        v = ray_get(col);
+        v = io_get_symimage(col);
         drop_obj(s);
         drop_obj(col);
     }
@@ -881,6 +943,8 @@ obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile) {
                 s = cstring_from_str("sym", 3);
                 col = ray_concat(path, s);
                 res = binary_set(col, sym);
+                if (!IS_ERR(res))
+                    io_set_symimage(col, sym);
                 drop_obj(s);
                 drop_obj(col);
                 break;
@@ -899,6 +963,8 @@ obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile) {
 
                 drop_obj(s);
                 res = binary_set(symfile, sym);
+                if (!IS_ERR(res))
+                    io_set_symimage(symfile, sym);
                 break;
             default:
                 drop_obj(cols);
@@ -1022,3 +1088,84 @@ obj_p io_get_table_splayed(obj_p path, obj_p symfile) {
 
     return table(keys, vals);
 }
+
+// Passes the hints on to the mappings of the columns. With huge, a mapped vector is copied into anonymous
+// memory instead: a large copy gets transparent huge pages, which shared file mappings can not have.
+static obj_p io_advise_obj(obj_p x, i64_t hints) {
+    i64_t i, l, *entry;
+    obj_p fdmap, v, res;
+
+    switch (x->type) {
+        case TYPE_TABLE:
+            v = io_advise_obj(AS_LIST(x)[1], hints);
+            return table(clone_obj(AS_LIST(x)[0]), v);
+        case TYPE_LIST:
+            l = x->len;
+            res = LIST(l);
+            for (i = 0; i < l; i++)
+                AS_LIST(res)[i] = io_advise_obj(AS_LIST(x)[i], hints);
+
+            return res;
+        default:
+            if (!IS_EXTERNAL_SIMPLE(x) && !IS_EXTERNAL_COMPOUND(x))
+                return clone_obj(x);
+
+            fdmap = runtime_fdmap_get(runtime_get(), x);
+            if (fdmap->type == TYPE_MAPFD) {
+                entry = AS_I64(AS_LIST(fdmap)[0]);
+                mmap_advise((raw_p)entry[0], entry[2], hints);
+            }
+
+            drop_obj(fdmap);
+
+            if ((hints & MMAP_HUGEPAGE) && IS_EXTERNAL_SIMPLE(x) && x->type > TYPE_LIST && x->type < TYPE_ENUM) {
+                res = vector(x->type, x->len);
+                if (IS_ERR(res))
+                    return res;
+
+                memcpy(AS_U8(res), AS_U8(x), x->len * size_of_type(x->type));
+                res->attrs = x->attrs;
+
+                return res;
+            }
+
+            return clone_obj(x);
+    }
+}
+
+obj_p ray_advise(obj_p x, obj_p y) {
+    i64_t i, l, hints = 0, *ids;
+    lit_p name;
+
+    switch (y->type) {
+        case -TYPE_SYMBOL:
+            ids = &y->i64;
+            l = 1;
+            break;
+        case TYPE_SYMBOL:
+            ids = AS_SYMBOL(y);
+            l = y->len;
+            break;
+        default:
+            THROW(ERR_TYPE, "advise: expected symbol(s) as 2nd argument, got: '%s", type_name(y->type));
+    }
+
+    for (i = 0; i < l; i++) {
+        name = str_from_symbol(ids[i]);
+
+        if (strcmp(name, "normal") == 0)
+            continue;
+        else if (strcmp(name, "sequential") == 0)
+            hints |= MMAP_SEQUENTIAL;
+        else if (strcmp(name, "willneed") == 0)
+            hints |= MMAP_WILLNEED;
+        else if (strcmp(name, "populate") == 0)
+            hints |= MMAP_POPULATE;
+        else if (strcmp(name, "huge") == 0)
+            hints |= MMAP_HUGEPAGE;
+        else
+            THROW(ERR_TYPE, "advise: unknown hint: '%s", name);
+    }
+
+    return io_advise_obj(x, hints);
+}
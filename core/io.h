@@ -39,5 +39,6 @@ obj_p io_get_symfile(obj_p path);
 obj_p io_set_table(obj_p path, obj_p table);
 obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile);
 obj_p io_get_table_splayed(obj_p path, obj_p symfile);
+obj_p ray_advise(obj_p x, obj_p y);
 
 #endif  // IO_H
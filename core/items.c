@@ -568,8 +568,8 @@ obj_p ray_take(obj_p x, obj_p y) {
 }
 
 obj_p ray_in(obj_p x, obj_p y) {
-    i64_t i;
-    obj_p vec;
+    i64_t i, n;
+    obj_p vec, s, t, v;
 
     if (IS_ATOM(x) && IS_ATOM(y))
         return b8(cmp_obj(x, y) == 0);
@@ -618,6 +618,28 @@ obj_p ray_in(obj_p x, obj_p y) {
             return index_in_i64_i64(AS_I64(x), x->len, AS_I64(y), y->len);
         case MTYPE2(TYPE_GUID, TYPE_GUID):
             return index_in_guid_guid(AS_GUID(x), x->len, AS_GUID(y), y->len);
+        case MTYPE2(TYPE_ENUM, TYPE_SYMBOL):
+            // look up the dictionary entries, not the rows
+            s = enum_domain(x);
+            if (is_null(s))
+                THROW(ERR_TYPE, "in: can not resolve an enum");
+
+            n = s->len;
+            t = B8(n + 1);
+            v = index_in_i64_i64(AS_I64(s), n, AS_I64(y), y->len);
+            memcpy(AS_B8(t), AS_B8(v), n);
+            drop_obj(v);
+            drop_obj(s);
+
+            AS_B8(t)[n] = B8_FALSE;
+            for (i = 0; i < (i64_t)y->len; i++)
+                AS_B8(t)[n] |= AS_SYMBOL(y)[i] == NULL_I64;
+
+            vec = B8(ops_count(x));
+            enum_map_b8(AS_I64(ENUM_VAL(x)), vec->len, AS_B8(t), n, AS_B8(vec));
+            drop_obj(t);
+
+            return vec;
         default:
             if ((IS_VECTOR(y) || y->type == TYPE_LIST) && y->len == 0) {
                 if (IS_VECTOR(x) || x->type == TYPE_LIST) {
@@ -647,6 +669,28 @@ obj_p ray_in(obj_p x, obj_p y) {
     return NULL_OBJ;
 }
 
+obj_p enum_domain(obj_p x) {
+    obj_p k, sym;
+
+    k = ray_key(x);
+    sym = at_obj(runtime_get()->env.variables, k);
+    drop_obj(k);
+
+    if (is_null(sym) || sym->type != TYPE_SYMBOL) {
+        drop_obj(sym);
+        return NULL_OBJ;
+    }
+
+    return sym;
+}
+
+nil_t enum_map_b8(i64_t codes[], i64_t len, b8_t table[], i64_t n, b8_t out[]) {
+    i64_t i;
+
+    for (i = 0; i < len; i++)
+        out[i] = table[((u64_t)codes[i] < (u64_t)n) ? codes[i] : n];
+}
+
 obj_p ray_within(obj_p x, obj_p y) {
     i64_t i, l, min, max;
     obj_p res;
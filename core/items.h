@@ -43,4 +43,9 @@ obj_p ray_where(obj_p x);
 obj_p ray_bin(obj_p x, obj_p y);
 obj_p ray_binr(obj_p x, obj_p y);
 
+// Symbols of the enum domain, NULL_OBJ if the domain does not resolve to a symbol vector
+obj_p enum_domain(obj_p x);
+// Maps enum codes through a table built once per dictionary entry, table[n] is for the codes outside
+nil_t enum_map_b8(i64_t codes[], i64_t len, b8_t table[], i64_t n, b8_t out[]);
+
 #endif  // ITEMS_H
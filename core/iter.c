@@ -29,6 +29,7 @@
 #include "eval.h"
 #include "error.h"
 #include "pool.h"
+#include "serde.h"
 
 obj_p map_unary_fn(unary_f fn, i64_t attrs, obj_p x) {
     i64_t i, l, n;
@@ -414,45 +415,13 @@ obj_p map_vary_fn(vary_f fn, i64_t attrs, obj_p *x, i64_t n) {
 
 obj_p map_vary(obj_p f, obj_p *x, i64_t n) { return map_vary_fn((vary_f)f->i64, f->attrs, x, n); }
 
-obj_p map_lambda_partial(obj_p f, obj_p *lst, i64_t n, i64_t arg) {
-    i64_t i;
-    obj_p res;
-
-    for (i = 0; i < n; i++)
-        stack_push(at_idx(lst[i], arg));
-
-    res = call(f, n);
-
-    for (i = 0; i < n; i++)
-        drop_obj(stack_pop());
-
-    return res;
-}
-
-obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
-    i64_t i, j, l, executors;
+// Calls f on the rows [from, from + len) of x, collecting the results
+obj_p map_lambda_partial(obj_p f, obj_p *x, i64_t n, i64_t from, i64_t len) {
+    i64_t i, j;
     obj_p v, res;
-    pool_p pool;
-
-    l = ops_rank(x, n);
-
-    if (n == 0 || l == 0 || l == NULL_I64)
-        return NULL_OBJ;
-
-    pool = pool_get();
-    executors = pool_split_by(pool, l, 0);
-
-    if (executors > 1) {
-        pool_prepare(pool);
-
-        for (j = 0; j < l; j++)
-            pool_add_task(pool, (raw_p)map_lambda_partial, 4, f, x, n, j);
-
-        return pool_run(pool);
-    }
 
     for (j = 0; j < n; j++)
-        stack_push(at_idx(x[j], 0));
+        stack_push(at_idx(x[j], from));
 
     v = (f->attrs & FN_ATOMIC) ? map_lambda(f, x, n) : call(f, n);
 
@@ -462,13 +431,13 @@ obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
     if (IS_ERR(v))
         return v;
 
-    res = v->type < 0 ? vector(v->type, l) : LIST(l);
+    res = v->type < 0 ? vector(v->type, len) : LIST(len);
 
     ins_obj(&res, 0, v);
 
-    for (i = 1; i < l; i++) {
+    for (i = 1; i < len; i++) {
         for (j = 0; j < n; j++)
-            stack_push(at_idx(x[j], i));
+            stack_push(at_idx(x[j], from + i));
 
         v = (f->attrs & FN_ATOMIC) ? map_lambda(f, x, n) : call(f, n);
 
@@ -487,6 +456,83 @@ obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
     return res;
 }
 
+// Joins the per-executor results in order
+static obj_p map_lambda_merge(obj_p parts, i64_t l) {
+    i64_t i, j, k, size, n;
+    i8_t t;
+    obj_p part, res;
+
+    n = parts->len;
+    t = AS_LIST(parts)[0]->type;
+    for (i = 1; i < n; i++) {
+        if (AS_LIST(parts)[i]->type != t) {
+            t = TYPE_LIST;
+            break;
+        }
+    }
+
+    if (t == TYPE_LIST) {
+        res = LIST(l);
+        for (i = 0, k = 0; i < n; i++) {
+            part = AS_LIST(parts)[i];
+            for (j = 0; j < (i64_t)part->len; j++)
+                AS_LIST(res)[k++] = at_idx(part, j);
+        }
+
+        return res;
+    }
+
+    res = vector(t, l);
+    size = size_of_type(t);
+    for (i = 0, k = 0; i < n; i++) {
+        part = AS_LIST(parts)[i];
+        memcpy(AS_C8(res) + k * size, AS_C8(part), part->len * size);
+        k += part->len;
+    }
+
+    return res;
+}
+
+// Splits the rows into one range per executor, each running f on its own interpreter
+obj_p map_lambda_parallel(obj_p f, obj_p *x, i64_t n, i64_t l, i64_t executors) {
+    i64_t i, chunk, from;
+    obj_p parts, res;
+    pool_p pool;
+
+    pool = pool_get();
+    chunk = (l + executors - 1) / executors;
+
+    pool_prepare(pool);
+
+    for (i = 0, from = 0; from < l; i++, from += chunk)
+        pool_add_task(pool, (raw_p)map_lambda_partial, 5, f, x, n, from, (from + chunk > l) ? l - from : chunk);
+
+    parts = pool_run(pool);
+    if (IS_ERR(parts))
+        return parts;
+
+    res = map_lambda_merge(parts, l);
+    drop_obj(parts);
+
+    return res;
+}
+
+obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
+    i64_t l, executors;
+
+    l = ops_rank(x, n);
+
+    if (n == 0 || l == 0 || l == NULL_I64)
+        return NULL_OBJ;
+
+    executors = pool_split_by(pool_get(), l, 0);
+
+    if (executors > 1)
+        return map_lambda_parallel(f, x, n, l, executors);
+
+    return map_lambda_partial(f, x, n, 0, l);
+}
+
 obj_p ray_map(obj_p *x, i64_t n) {
     i64_t l;
     obj_p f;
@@ -527,6 +573,42 @@ obj_p ray_map(obj_p *x, i64_t n) {
     }
 }
 
+// Unlike map, splits the lambda calls across the executors regardless of the input size
+obj_p ray_pmap(obj_p *x, i64_t n) {
+    i64_t l, executors;
+    obj_p f;
+
+    if (n < 2)
+        return LIST(0);
+
+    f = x[0];
+
+    if (f->type != TYPE_LAMBDA)
+        return ray_map(x, n);
+
+    x++;
+    n--;
+
+    if (n != AS_LAMBDA(f)->args->len)
+        THROW(ERR_LENGTH, "'pmap': lambda call with wrong arguments count");
+
+    l = ops_rank(x, n);
+    if (l == NULL_I64)
+        THROW(ERR_LENGTH, "'pmap': arguments have different lengths");
+
+    if (l < 1)
+        return vector(x[0]->type, 0);
+
+    executors = rc_sync_get() ? 1 : pool_get_executors_count(pool_get());
+    if (executors > l)
+        executors = l;
+
+    if (executors > 1)
+        return map_lambda_parallel(f, x, n, l, executors);
+
+    return map_lambda_partial(f, x, n, 0, l);
+}
+
 obj_p ray_map_left(obj_p *x, i64_t n) {
     i64_t i, j, l;
     obj_p f, v, *b, res;
@@ -37,8 +37,11 @@ obj_p map_binary_right_fn(binary_f fn, i64_t attrs, obj_p x, obj_p y);
 obj_p map_binary_right(obj_p f, obj_p x, obj_p y);
 obj_p map_vary_fn(vary_f fn, i64_t attrs, obj_p *x, i64_t n);
 obj_p map_vary(obj_p f, obj_p *x, i64_t n);
+obj_p map_lambda_partial(obj_p f, obj_p *x, i64_t n, i64_t from, i64_t len);
+obj_p map_lambda_parallel(obj_p f, obj_p *x, i64_t n, i64_t l, i64_t executors);
 obj_p map_lambda(obj_p f, obj_p *x, i64_t n);
 obj_p ray_map(obj_p *x, i64_t n);
+obj_p ray_pmap(obj_p *x, i64_t n);
 obj_p ray_map_right(obj_p *x, i64_t n);
 obj_p ray_map_left(obj_p *x, i64_t n);
 obj_p ray_fold(obj_p *x, i64_t n);
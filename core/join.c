@@ -33,6 +33,7 @@
 #include "filter.h"
 #include "aggr.h"
 #include "order.h"
+#include "runtime.h"
 
 obj_p select_column(obj_p left_col, obj_p right_col, i64_t ids[], i64_t len) {
     i64_t i;
@@ -49,6 +50,17 @@ obj_p select_column(obj_p left_col, obj_p right_col, i64_t ids[], i64_t len) {
     if (right_col->type != type)
         THROW(ERR_TYPE, "select_column: incompatible types");
 
+    // the left table has no such column: the rows without a match get the typed null
+    if (is_null(left_col)) {
+        res = nullv(type, len);
+        for (i = 0; i < len; i++) {
+            if (ids[i] != NULL_I64)
+                ins_obj(&res, i, at_idx(right_col, ids[i]));
+        }
+
+        return res;
+    }
+
     res = vector(type, len);
 
     for (i = 0; i < len; i++) {
@@ -296,8 +308,116 @@ obj_p ray_inner_join(obj_p *x, i64_t n) {
     return table(cols, vals);
 }
 
+// Prepared right side of asof/window joins: [source, keys, sorted table, sorted key columns, key ranges]
+#define JOIN_SIDE_SOURCE 0
+#define JOIN_SIDE_KEYS 1
+#define JOIN_SIDE_TABLE 2
+#define JOIN_SIDE_COLS 3
+#define JOIN_SIDE_RANGES 4
+
+// Number of prepared right sides kept between calls
+#define JOIN_SIDES_MAX 8
+
+static obj_p join_side_build(obj_p keys, obj_p tab) {
+    obj_p jtab, ksyms, rcols;
+
+    jtab = ray_xasc(tab, keys);
+    if (IS_ERR(jtab))
+        return jtab;
+
+    ksyms = copy_obj(keys);
+    ksyms = remove_idx(&ksyms, ksyms->len - 1);
+    rcols = at_obj(jtab, ksyms);
+    drop_obj(ksyms);
+
+    return vn_list(5, clone_obj(tab), clone_obj(keys), jtab, rcols, index_join_ranges(rcols, ops_count(jtab)));
+}
+
+// Takes the side i out of the cache, to be dropped by the caller once the cache is consistent again
+static obj_p join_side_take(obj_p sides, i64_t i) {
+    obj_p side;
+
+    side = AS_LIST(sides)[i];
+    memmove(AS_LIST(sides) + i, AS_LIST(sides) + i + 1, (sides->len - i - 1) * sizeof(obj_p));
+    sides->len--;
+
+    return side;
+}
+
+/*
+ * Returns the right side of a join sorted by the join keys, with the rows range of every key.
+ * Sides of tables that outlive the call are kept in the runtime and reused by the next joins
+ * against the same table. Holding a reference makes any change of the table copy it first, so
+ * a side whose source is referenced by the cache only is stale: drop_obj evicts it as the last
+ * other reference goes (join_sides_evict), the scan below catches the ones dropped on the executors.
+ */
+static obj_p join_side(obj_p keys, obj_p tab) {
+    i64_t i;
+    obj_p *sides, side;
+
+    // A temporary table would not be seen again; the cache itself belongs to the main thread
+    if (rc_obj(tab) == 1 || interpreter_current()->id != 0)
+        return join_side_build(keys, tab);
+
+    sides = &runtime_get()->joins;
+
+    for (i = 0; i < (i64_t)(*sides)->len;) {
+        side = AS_LIST(*sides)[i];
+        if (AS_LIST(side)[JOIN_SIDE_SOURCE] == tab && cmp_obj(AS_LIST(side)[JOIN_SIDE_KEYS], keys) == 0)
+            return clone_obj(side);
+
+        if (rc_obj(AS_LIST(side)[JOIN_SIDE_SOURCE]) == 1)
+            drop_obj(join_side_take(*sides, i));
+        else
+            i++;
+    }
+
+    side = join_side_build(keys, tab);
+    if (IS_ERR(side))
+        return side;
+
+    if ((*sides)->len == JOIN_SIDES_MAX)
+        drop_obj(join_side_take(*sides, 0));
+
+    push_obj(sides, clone_obj(side));
+
+    return side;
+}
+
+nil_t join_sides_evict(obj_p tab, i64_t rc) {
+    i64_t i, j, n, l;
+    obj_p sides, side, evicted[JOIN_SIDES_MAX];
+    runtime_p runtime;
+
+    runtime = runtime_get();
+    if (runtime == NULL || runtime->joins == NULL_OBJ || rc > JOIN_SIDES_MAX)
+        return;
+
+    sides = runtime->joins;
+    l = sides->len;
+
+    for (i = 0, n = 0; i < l; i++)
+        n += (AS_LIST(AS_LIST(sides)[i])[JOIN_SIDE_SOURCE] == tab);
+
+    if (n != rc)
+        return;
+
+    for (i = 0, j = 0, n = 0; i < l; i++) {
+        side = AS_LIST(sides)[i];
+        if (AS_LIST(side)[JOIN_SIDE_SOURCE] == tab)
+            evicted[n++] = side;
+        else
+            AS_LIST(sides)[j++] = side;
+    }
+
+    sides->len = j;
+
+    for (i = 0; i < n; i++)
+        drop_obj(evicted[i]);
+}
+
 obj_p ray_asof_join(obj_p *x, i64_t n) {
-    obj_p idx, v, ajkl, ajkr, keys, lvals, rvals, res;
+    obj_p idx, v, ajkl, ajkr, keys, lvals, side, res;
 
     if (n != 3)
         THROW(ERR_ARITY, "asof-join");
@@ -311,47 +431,57 @@ obj_p ray_asof_join(obj_p *x, i64_t n) {
     if (x[2]->type != TYPE_TABLE)
         THROW(ERR_TYPE, "asof-join: third argument must be a table");
 
+    side = join_side(x[0], x[2]);
+    if (IS_ERR(side))
+        return side;
+
     v = ray_last(x[0]);
     ajkl = ray_at(x[1], v);
-    ajkr = ray_at(x[2], v);
+    ajkr = ray_at(AS_LIST(side)[JOIN_SIDE_TABLE], v);
     drop_obj(v);
 
     if (is_null(ajkl) || is_null(ajkr)) {
         drop_obj(ajkl);
         drop_obj(ajkr);
+        drop_obj(side);
         THROW(ERR_INDEX, "asof-join: key not found");
     }
 
     if (ajkl->type != ajkr->type) {
         drop_obj(ajkl);
         drop_obj(ajkr);
+        drop_obj(side);
         THROW(ERR_TYPE, "asof-join: incompatible types");
     }
 
-    keys = cow_obj(x[0]);
+    keys = copy_obj(x[0]);
     keys = remove_idx(&keys, keys->len - 1);
     lvals = at_obj(x[1], keys);
-    rvals = at_obj(x[2], keys);
 
-    idx = index_asof_join_obj(lvals, ajkl, rvals, ajkr);
+    idx = index_asof_join_obj(lvals, ajkl, AS_LIST(side)[JOIN_SIDE_COLS], ajkr, AS_LIST(side)[JOIN_SIDE_RANGES]);
 
     drop_obj(keys);
     drop_obj(lvals);
-    drop_obj(rvals);
     drop_obj(ajkl);
     drop_obj(ajkr);
 
+    if (IS_ERR(idx)) {
+        drop_obj(side);
+        return idx;
+    }
+
     keys = at_obj(x[1], x[0]);
 
-    res = __left_join_inner(x[1], x[2], x[0], keys, idx);
+    res = __left_join_inner(x[1], AS_LIST(side)[JOIN_SIDE_TABLE], x[0], keys, idx);
     drop_obj(idx);
     drop_obj(keys);
+    drop_obj(side);
     return res;
 }
 
 static obj_p __window_join(obj_p *x, i64_t n, i64_t tp) {
     i64_t i, l;
-    obj_p k, v, wjkl, wjkr, keys, lvals, rvals, idx;
+    obj_p k, v, wjkl, wjkr, keys, lvals, idx, side;
     obj_p agrvals, resyms, recols, jtab, rtab;
 
     if (n != 5)
@@ -372,9 +502,11 @@ static obj_p __window_join(obj_p *x, i64_t n, i64_t tp) {
     if (x[4]->type != TYPE_DICT)
         THROW(ERR_TYPE, "window-join: fifth argument must be a dict");
 
-    jtab = ray_xasc(x[3], x[0]);
-    if (IS_ERR(jtab))
-        return jtab;
+    side = join_side(x[0], x[3]);
+    if (IS_ERR(side))
+        return side;
+
+    jtab = clone_obj(AS_LIST(side)[JOIN_SIDE_TABLE]);
 
     v = ray_last(x[0]);
     wjkl = ray_at(x[2], v);
@@ -384,27 +516,41 @@ static obj_p __window_join(obj_p *x, i64_t n, i64_t tp) {
     if (is_null(wjkl) || is_null(wjkr)) {
         drop_obj(wjkl);
         drop_obj(wjkr);
+        drop_obj(jtab);
+        drop_obj(side);
         THROW(ERR_INDEX, "window-join: key not found");
     }
 
     if (wjkl->type != wjkr->type) {
         drop_obj(wjkl);
         drop_obj(wjkr);
+        drop_obj(jtab);
+        drop_obj(side);
         THROW(ERR_TYPE, "window-join: incompatible types");
     }
 
-    keys = cow_obj(x[0]);
+    l = ops_count(x[2]);
+    if (x[1]->len != 2 || AS_LIST(x[1])[0]->type != wjkl->type || AS_LIST(x[1])[1]->type != wjkl->type ||
+        ops_count(AS_LIST(x[1])[0]) != l || ops_count(AS_LIST(x[1])[1]) != l) {
+        drop_obj(wjkl);
+        drop_obj(wjkr);
+        drop_obj(jtab);
+        drop_obj(side);
+        THROW(ERR_TYPE, "window-join: windows must be two vectors of the join column type");
+    }
+
+    keys = copy_obj(x[0]);
     keys = remove_idx(&keys, keys->len - 1);
     lvals = at_obj(x[2], keys);
-    rvals = at_obj(jtab, keys);
 
-    idx = index_window_join_obj(lvals, wjkl, rvals, wjkr, x[1], x[2], jtab, tp);
+    idx = index_window_join_obj(lvals, wjkl, AS_LIST(side)[JOIN_SIDE_COLS], wjkr, AS_LIST(side)[JOIN_SIDE_RANGES],
+                                x[1], tp);
 
     drop_obj(keys);
     drop_obj(lvals);
-    drop_obj(rvals);
     drop_obj(wjkl);
     drop_obj(wjkr);
+    drop_obj(side);
 
     rtab = group_map(jtab, idx);
     mount_env(rtab);
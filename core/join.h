@@ -31,5 +31,6 @@ obj_p ray_inner_join(obj_p *x, i64_t n);
 obj_p ray_asof_join(obj_p *x, i64_t n);
 obj_p ray_window_join(obj_p *x, i64_t n);
 obj_p ray_window_join1(obj_p *x, i64_t n);
+nil_t join_sides_evict(obj_p tab, i64_t rc);  // drops the join sides of tab if they hold its last rc references
 
 #endif  // JOIN_H
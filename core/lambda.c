@@ -29,14 +29,61 @@
 #include "group.h"
 #include "pool.h"
 #include "iter.h"
+#include "env.h"
+#include "ops.h"
+
+/*
+ * Counts the body symbols referring to the arguments and, given a slots table, maps them to their slots.
+ * The atoms are keyed by address, so the parse tree is left untouched; nested lambdas are bound on their own.
+ */
+static i64_t lambda_bind(obj_p slots, obj_p args, obj_p body) {
+    i64_t i, l, n, *keys;
+    u64_t h;
+
+    switch (body->type) {
+        case -TYPE_SYMBOL:
+            if ((body->attrs & ATTR_QUOTED) || body->i64 == SYMBOL_SELF)
+                return 0;
+
+            l = args->len;
+            for (i = 0; i < l; i++) {
+                if (AS_SYMBOL(args)[i] == body->i64)
+                    break;
+            }
+
+            if (i == l)
+                return 0;
+
+            if (slots != NULL_OBJ) {
+                keys = AS_I64(slots);
+                n = slots->len / 2;
+                for (h = LAMBDA_SLOT_HASH(body, n); keys[h] != 0; h = (h + 1) & (n - 1))
+                    ;
+                keys[h] = (i64_t)body;
+                keys[n + h] = i;
+            }
+
+            return 1;
+        case TYPE_LIST:
+            for (i = 0, n = 0; i < (i64_t)body->len; i++)
+                n += lambda_bind(slots, args, AS_LIST(body)[i]);
+            return n;
+        case TYPE_DICT:
+            return lambda_bind(slots, args, AS_LIST(body)[1]);
+        default:
+            return 0;
+    }
+}
 
 obj_p lambda(obj_p args, obj_p body, obj_p nfo) {
+    i64_t bound, n;
     obj_p obj;
     lambda_p f;
 
     obj = (obj_p)heap_alloc(sizeof(struct obj_t) + sizeof(struct lambda_f));
     obj->mmod = MMOD_INTERNAL;
     obj->type = TYPE_LAMBDA;
+    obj->attrs = FN_NONE;
     obj->rc = 1;
 
     f = (lambda_p)obj->raw;
@@ -44,6 +91,21 @@ obj_p lambda(obj_p args, obj_p body, obj_p nfo) {
     f->args = args;
     f->body = body;
     f->nfo = nfo;
+    f->slots = NULL_OBJ;
+
+    if (args != NULL_OBJ && args->type == TYPE_SYMBOL && body != NULL_OBJ) {
+        bound = lambda_bind(NULL_OBJ, args, body);
+        if (bound > 0) {
+            // At most half full, so the probes stay short and always end on an empty key
+            n = LAMBDA_SLOTS_MIN;
+            while (n < 2 * bound)
+                n *= 2;
+
+            f->slots = vector(TYPE_I64, 2 * n);
+            memset(AS_I64(f->slots), 0, n * sizeof(i64_t));
+            lambda_bind(f->slots, args, body);
+        }
+    }
 
     return obj;
 }
@@ -31,10 +31,15 @@ typedef struct lambda_f {
     obj_p args;  // vector of arguments names
     obj_p body;  // body of lambda
     obj_p nfo;   // nfo from cc phase
+    obj_p slots; // i64 vector of the body symbol atoms referring to the arguments, followed by their slots
 } *lambda_p;
 
 #define AS_LAMBDA(o) ((lambda_p)(AS_C8(o)))
 
+// slots tables are open addressed over a power of two of atoms addresses, 0 marks an empty key
+#define LAMBDA_SLOTS_MIN 8
+#define LAMBDA_SLOT_HASH(a, n) ((((u64_t)(a)) * 0x9e3779b97f4a7c15ull) >> (64 - __builtin_ctzll(n)))
+
 obj_p lambda(obj_p args, obj_p body, obj_p nfo);
 obj_p lambda_call(obj_p f, obj_p *x, i64_t n);
 
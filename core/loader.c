@@ -0,0 +1,184 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#include "loader.h"
+#include "mmap.h"
+#include "heap.h"
+#include "ops.h"
+#include "util.h"
+#include "runtime.h"
+
+static raw_p loader_run(raw_p arg) {
+    loader_p loader = (loader_p)arg;
+    loader_chunk_t chunk;
+    i64_t slot;
+
+    mutex_lock(&loader->mutex);
+    slot = loader->started++;
+
+    for (;;) {
+        while (!loader->stop && loader->head == loader->tail)
+            cond_wait(&loader->work, &loader->mutex);
+
+        if (loader->stop)
+            break;
+
+        chunk = loader->queue[loader->head++ % LOADER_QUEUE];
+        loader->busy[slot] = chunk;
+        mutex_unlock(&loader->mutex);
+
+        mmap_advise(chunk.addr, chunk.size, MMAP_POPULATE);
+
+        mutex_lock(&loader->mutex);
+        loader->busy[slot] = (loader_chunk_t){NULL, 0};
+        cond_broadcast(&loader->done);
+    }
+
+    mutex_unlock(&loader->mutex);
+
+    return NULL;
+}
+
+loader_p loader_create(nil_t) {
+    i64_t i;
+    loader_p loader;
+
+    loader = (loader_p)heap_mmap(sizeof(struct loader_t));
+    if (loader == NULL)
+        return NULL;
+
+    loader->mutex = mutex_create();
+    loader->work = cond_create();
+    loader->done = cond_create();
+    loader->stop = B8_FALSE;
+    loader->started = 0;
+    loader->head = 0;
+    loader->tail = 0;
+
+    for (i = 0; i < LOADER_THREADS; i++) {
+        loader->busy[i] = (loader_chunk_t){NULL, 0};
+        loader->threads[i] = ray_thread_create(loader_run, loader);
+    }
+
+    return loader;
+}
+
+nil_t loader_destroy(loader_p loader) {
+    i64_t i;
+
+    mutex_lock(&loader->mutex);
+    loader->stop = B8_TRUE;
+    cond_broadcast(&loader->work);
+    mutex_unlock(&loader->mutex);
+
+    for (i = 0; i < LOADER_THREADS; i++)
+        thread_join(loader->threads[i]);
+
+    mutex_destroy(&loader->mutex);
+    cond_destroy(&loader->work);
+    cond_destroy(&loader->done);
+    heap_unmap(loader, sizeof(struct loader_t));
+}
+
+// Queues a mapping to be read in by chunks, in order. It is a hint: what does not fit is dropped.
+nil_t loader_load(loader_p loader, raw_p addr, i64_t size) {
+    i64_t offset;
+
+    mutex_lock(&loader->mutex);
+
+    for (offset = 0; offset < size && loader->tail - loader->head < LOADER_QUEUE; offset += LOADER_CHUNK) {
+        loader->queue[loader->tail++ % LOADER_QUEUE] =
+            (loader_chunk_t){(raw_p)((i64_t)addr + offset), (size - offset < LOADER_CHUNK) ? size - offset : LOADER_CHUNK};
+    }
+
+    cond_broadcast(&loader->work);
+    mutex_unlock(&loader->mutex);
+}
+
+// Must be called before a mapping goes away: its queued chunks are dropped and the ones being read in waited for
+nil_t loader_forget(loader_p loader, raw_p addr, i64_t size) {
+    i64_t i, n;
+    b8_t busy;
+    loader_chunk_t chunk;
+
+#define OVERLAPS(c) ((i64_t)(c).addr < (i64_t)addr + size && (i64_t)(c).addr + (c).size > (i64_t)addr)
+
+    mutex_lock(&loader->mutex);
+
+    for (i = loader->head, n = loader->head; i < loader->tail; i++) {
+        chunk = loader->queue[i % LOADER_QUEUE];
+        if (!OVERLAPS(chunk))
+            loader->queue[n++ % LOADER_QUEUE] = chunk;
+    }
+
+    loader->tail = n;
+
+    do {
+        busy = B8_FALSE;
+        for (i = 0; i < LOADER_THREADS; i++)
+            busy |= (loader->busy[i].addr != NULL && OVERLAPS(loader->busy[i]));
+
+        if (busy)
+            cond_wait(&loader->done, &loader->mutex);
+    } while (busy);
+
+    mutex_unlock(&loader->mutex);
+
+#undef OVERLAPS
+}
+
+// Queues the files mapped behind a column, every partition of a parted one, unless they were queued before
+nil_t loader_prefetch(obj_p obj) {
+    i64_t i, l, *entry;
+    obj_p fdmap;
+    runtime_p runtime = runtime_get();
+
+    if (obj->type >= TYPE_PARTEDLIST && obj->type <= TYPE_PARTEDENUM) {
+        l = obj->len;
+        for (i = 0; i < l; i++)
+            loader_prefetch(AS_LIST(obj)[i]);
+
+        return;
+    }
+
+    if (!IS_EXTERNAL_SIMPLE(obj) && !IS_EXTERNAL_COMPOUND(obj))
+        return;
+
+    fdmap = runtime_fdmap_get(runtime, obj);
+
+    if (fdmap->type == TYPE_MAPFD) {
+        entry = AS_I64(AS_LIST(fdmap)[0]);
+
+        if (!entry[3]) {
+            if (runtime->loader == NULL)
+                runtime->loader = loader_create();
+
+            if (runtime->loader != NULL)
+                loader_load(runtime->loader, (raw_p)entry[0], entry[2]);
+
+            entry[3] = 1;
+        }
+    }
+
+    drop_obj(fdmap);
+}
@@ -0,0 +1,62 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "rayforce.h"
+#include "thread.h"
+
+#define LOADER_THREADS 4
+#define LOADER_QUEUE 8192            // chunks waiting to be read in, the ones above are dropped
+#define LOADER_CHUNK (16ll << 20)  // mappings are read in by chunks of 16MB
+
+typedef struct loader_chunk_t {
+    raw_p addr;
+    i64_t size;
+} loader_chunk_t;
+
+/*
+ * Reads mapped files in ahead of the kernels on a few threads of its own, so a query faults in
+ * cold columns in parallel while it computes over the ones already loaded.
+ */
+typedef struct loader_t {
+    mutex_t mutex;
+    cond_t work;                            // chunks are queued or the loader stops
+    cond_t done;                            // a chunk has been read in
+    b8_t stop;
+    i64_t started;                          // threads started, each takes its busy slot
+    i64_t head;                             // queued chunks are queue[head..tail) modulo the size
+    i64_t tail;
+    loader_chunk_t queue[LOADER_QUEUE];
+    loader_chunk_t busy[LOADER_THREADS];    // chunks being read in, by thread
+    ray_thread_t threads[LOADER_THREADS];
+} *loader_p;
+
+loader_p loader_create(nil_t);
+nil_t loader_destroy(loader_p loader);
+nil_t loader_load(loader_p loader, raw_p addr, i64_t size);
+nil_t loader_forget(loader_p loader, raw_p addr, i64_t size);
+nil_t loader_prefetch(obj_p obj);
+
+#endif  // LOADER_H
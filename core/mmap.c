@@ -22,6 +22,7 @@
  */
 
 #include "mmap.h"
+#include "util.h"
 
 #if defined(OS_WINDOWS)
 
@@ -29,6 +30,22 @@ raw_p mmap_stack(i64_t size) { return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_
 
 raw_p mmap_alloc(i64_t size) { return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE); }
 
+raw_p mmap_alloc_large(i64_t size) { return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE); }
+
+// Large pages need a privilege the process usually lacks, the caller falls back to mmap_alloc_large
+raw_p mmap_alloc_huge(i64_t size) {
+    UNUSED(size);
+    return NULL;
+}
+
+// There is no way to resize a view in place, the caller copies
+raw_p mmap_remap(raw_p addr, i64_t old_size, i64_t new_size) {
+    UNUSED(addr);
+    UNUSED(old_size);
+    UNUSED(new_size);
+    return NULL;
+}
+
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     UNUSED(addr);  // Mark addr as intentionally unused on Windows
     HANDLE hMapping;
@@ -46,6 +63,15 @@ raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     return ptr;
 }
 
+// Private views at a fixed address inside a reservation are not supported
+raw_p mmap_file_private(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
+    UNUSED(fd);
+    UNUSED(addr);
+    UNUSED(size);
+    UNUSED(offset);
+    return NULL;
+}
+
 i64_t mmap_free(raw_p addr, i64_t size) {
     UNUSED(size);
     return VirtualFree(addr, 0, MEM_RELEASE);
@@ -69,8 +95,27 @@ i64_t mmap_commit(raw_p addr, i64_t size) {
     return 0;
 }
 
+i64_t mmap_node(raw_p addr) {
+    UNUSED(addr);
+    return -1;
+}
+
+i64_t mmap_advise(raw_p addr, i64_t size, i64_t hints) {
+    UNUSED(addr);
+    UNUSED(size);
+    UNUSED(hints);
+    return 0;
+}
+
 #elif defined(OS_LINUX)
 
+#include <sys/syscall.h>
+
+#ifndef MPOL_F_NODE
+#define MPOL_F_NODE (1 << 0)
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
 raw_p mmap_stack(i64_t size) {
     return mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE | MAP_STACK, -1, 0);
 }
@@ -86,6 +131,44 @@ raw_p mmap_alloc(i64_t size) {
     return ptr;
 }
 
+// Private mapping of a large object, faulted on first touch with transparent huge pages if enabled
+raw_p mmap_alloc_large(i64_t size) {
+    raw_p ptr;
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+
+    return ptr;
+}
+
+// Explicit huge pages from the reserved hugetlb pool, size is a multiple of the huge page size
+raw_p mmap_alloc_huge(i64_t size) {
+    raw_p ptr;
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
+// Grows or shrinks a mapping, moving its pages rather than copying them if it can not grow in place
+raw_p mmap_remap(raw_p addr, i64_t old_size, i64_t new_size) {
+    raw_p ptr = mremap(addr, old_size, new_size, MREMAP_MAYMOVE);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     raw_p ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NONBLOCK | MAP_POPULATE, fd, offset);
 
@@ -95,6 +178,16 @@ raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     return ptr;
 }
 
+// Copy-on-write view of a file, placed exactly at addr (over a reservation) unless addr is NULL
+raw_p mmap_file_private(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
+    raw_p ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | (addr ? MAP_FIXED : 0), fd, offset);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
 i64_t mmap_free(raw_p addr, i64_t size) { return munmap(addr, size); }
 
 i64_t mmap_sync(raw_p addr, i64_t size) { return msync(addr, size, MS_SYNC); }
@@ -112,6 +205,50 @@ raw_p mmap_reserve(raw_p addr, i64_t size) {
 
 i64_t mmap_commit(raw_p addr, i64_t size) { return mprotect(addr, size, PROT_READ | PROT_WRITE); }
 
+// NUMA node the page at addr is placed on, -1 if it is not known
+i64_t mmap_node(raw_p addr) {
+    i32_t node = -1;
+
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) != 0)
+        return -1;
+
+    return node;
+}
+
+// addr is the page aligned start of a mapping
+i64_t mmap_advise(raw_p addr, i64_t size, i64_t hints) {
+    i64_t i, res = 0;
+    volatile u8_t sink;
+
+    if (hints == 0)
+        return madvise(addr, size, MADV_NORMAL);
+
+    if (hints & MMAP_SEQUENTIAL)
+        res |= madvise(addr, size, MADV_SEQUENTIAL);
+
+    if (hints & MMAP_WILLNEED)
+        res |= madvise(addr, size, MADV_WILLNEED);
+
+#ifdef MADV_HUGEPAGE
+    // most file systems can not back a shared file mapping with huge pages, that is not an error
+    if (hints & MMAP_HUGEPAGE)
+        madvise(addr, size, MADV_HUGEPAGE);
+#endif
+
+    if (hints & MMAP_POPULATE) {
+#ifdef MADV_POPULATE_READ
+        if (madvise(addr, size, MADV_POPULATE_READ) == 0)
+            return res;
+#endif
+        for (i = 0; i < size; i += RAY_PAGE_SIZE)
+            sink = ((u8_t *)addr)[i];
+
+        UNUSED(sink);
+    }
+
+    return res;
+}
+
 #elif defined(OS_MACOS)
 
 #define MAP_ANON 0x1000
@@ -132,6 +269,31 @@ raw_p mmap_alloc(i64_t size) {
     return ptr;
 }
 
+raw_p mmap_alloc_large(i64_t size) {
+    raw_p ptr;
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
+// Superpages are not exposed for anonymous mappings here, the caller falls back to mmap_alloc_large
+raw_p mmap_alloc_huge(i64_t size) {
+    UNUSED(size);
+    return NULL;
+}
+
+// No mremap, the caller copies
+raw_p mmap_remap(raw_p addr, i64_t old_size, i64_t new_size) {
+    UNUSED(addr);
+    UNUSED(old_size);
+    UNUSED(new_size);
+    return NULL;
+}
+
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     raw_p ptr;
 
@@ -143,6 +305,17 @@ raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
     return ptr;
 }
 
+raw_p mmap_file_private(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
+    raw_p ptr;
+
+    ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | (addr ? MAP_FIXED : 0), fd, offset);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
 i64_t mmap_free(raw_p addr, i64_t size) { return munmap(addr, size); }
 
 i64_t mmap_sync(raw_p addr, i64_t size) { return msync(addr, size, MS_SYNC); }
@@ -160,4 +333,32 @@ raw_p mmap_reserve(raw_p addr, i64_t size) {
 
 i64_t mmap_commit(raw_p addr, i64_t size) { return mprotect(addr, size, PROT_READ | PROT_WRITE); }
 
+i64_t mmap_node(raw_p addr) {
+    UNUSED(addr);
+    return -1;
+}
+
+i64_t mmap_advise(raw_p addr, i64_t size, i64_t hints) {
+    i64_t i, res = 0;
+    volatile u8_t sink;
+
+    if (hints == 0)
+        return madvise(addr, size, MADV_NORMAL);
+
+    if (hints & MMAP_SEQUENTIAL)
+        res |= madvise(addr, size, MADV_SEQUENTIAL);
+
+    if (hints & MMAP_WILLNEED)
+        res |= madvise(addr, size, MADV_WILLNEED);
+
+    if (hints & MMAP_POPULATE) {
+        for (i = 0; i < size; i += RAY_PAGE_SIZE)
+            sink = ((u8_t *)addr)[i];
+
+        UNUSED(sink);
+    }
+
+    return res;
+}
+
 #endif
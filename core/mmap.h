@@ -26,12 +26,24 @@
 
 #include "rayforce.h"
 
+// Access hints for mapped files, no hint restores the default paging
+#define MMAP_SEQUENTIAL 1  // read ahead of the cursor aggressively
+#define MMAP_WILLNEED 2    // start reading the whole range in, asynchronously
+#define MMAP_POPULATE 4    // fault the range in before returning
+#define MMAP_HUGEPAGE 8    // back with huge pages where the file system allows it
+
 raw_p mmap_stack(i64_t size);
 raw_p mmap_alloc(i64_t size);
+raw_p mmap_alloc_large(i64_t size);
+raw_p mmap_alloc_huge(i64_t size);
+raw_p mmap_remap(raw_p addr, i64_t old_size, i64_t new_size);
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset);
+raw_p mmap_file_private(i64_t fd, raw_p addr, i64_t size, i64_t offset);
 i64_t mmap_free(raw_p addr, i64_t size);
 i64_t mmap_sync(raw_p addr, i64_t size);
 raw_p mmap_reserve(raw_p addr, i64_t size);
 i64_t mmap_commit(raw_p addr, i64_t size);
+i64_t mmap_node(raw_p addr);
+i64_t mmap_advise(raw_p addr, i64_t size, i64_t hints);
 
 #endif  // MMAP_H
@@ -0,0 +1,978 @@
+/*
+ *   Copyright (c) 2023 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#include <math.h>
+#include "moving.h"
+#include "ops.h"
+#include "util.h"
+#include "error.h"
+#include "heap.h"
+#include "aggr.h"
+#include "pool.h"
+#include "runtime.h"
+#include "serde.h"
+
+typedef enum moving_kind_t {
+    MOVING_SUM,
+    MOVING_AVG,
+    MOVING_MIN,
+    MOVING_MAX,
+    MOVING_DEV,
+    MOVING_EMA,
+} moving_kind_t;
+
+static lit_p MOVING_NAMES[] = {"msum", "mavg", "mmin", "mmax", "mdev", "ema"};
+
+// Nulls are skipped: they add nothing to a window and are not counted
+#define MOVING_NIL_i32(v) ((v) == NULL_I32)
+#define MOVING_NIL_i64(v) ((v) == NULL_I64)
+#define MOVING_NIL_f64(v) ISNANF64(v)
+#define MOVING_NUM_i32(v) (MOVING_NIL_i32(v) ? 0 : (i64_t)(v))
+#define MOVING_NUM_i64(v) (MOVING_NIL_i64(v) ? 0 : (v))
+#define MOVING_NUM_f64(v) (MOVING_NIL_f64(v) ? 0.0 : (v))
+
+// Each kernel fills out[offset, offset + len), warming the window up on the
+// w - 1 items before offset, so a vector can be cut into independent chunks
+#define MOVING_START(w, offset) (((offset) >= (w)) ? (offset) - (w) + 1 : 0)
+
+#define MOVING_SUM_ITER(x, out, w, len, offset, t, acc)        \
+    ({                                                         \
+        i64_t $i, $s, $m, $e;                                  \
+        acc##_t $sum = 0;                                      \
+        t##_t *$in = __AS_##t(x);                              \
+        acc##_t *$out = __AS_##acc(out);                       \
+        $s = MOVING_START(w, offset);                          \
+        $e = (offset) + (len);                                 \
+        $m = ($s + (w) < $e) ? $s + (w) : $e;                  \
+        for ($i = $s; $i < $m; $i++) {                         \
+            $sum += MOVING_NUM_##t($in[$i]);                   \
+            if ($i >= (offset))                                \
+                $out[$i] = $sum;                               \
+        }                                                      \
+        for (; $i < $e; $i++) {                                \
+            $sum += MOVING_NUM_##t($in[$i]);                   \
+            $sum -= MOVING_NUM_##t($in[$i - (w)]);             \
+            $out[$i] = $sum;                                   \
+        }                                                      \
+    })
+
+#define MOVING_AVG_ITER(x, out, w, len, offset, t, acc)                      \
+    ({                                                                       \
+        i64_t $i, $s, $e, $cnt = 0;                                          \
+        acc##_t $sum = 0;                                                    \
+        t##_t *$in = __AS_##t(x);                                            \
+        f64_t *$out = AS_F64(out);                                           \
+        $s = MOVING_START(w, offset);                                        \
+        $e = (offset) + (len);                                               \
+        for ($i = $s; $i < $e; $i++) {                                       \
+            $sum += MOVING_NUM_##t($in[$i]);                                 \
+            $cnt += !MOVING_NIL_##t($in[$i]);                                \
+            if ($i - (w) >= $s) {                                            \
+                $sum -= MOVING_NUM_##t($in[$i - (w)]);                       \
+                $cnt -= !MOVING_NIL_##t($in[$i - (w)]);                      \
+            }                                                                \
+            if ($i >= (offset))                                              \
+                $out[$i] = $cnt ? (f64_t)$sum / (f64_t)$cnt : NULL_F64;      \
+        }                                                                    \
+    })
+
+// Sums are shifted by the first item of the run to keep the variance from
+// cancelling out on series far away from zero
+#define MOVING_DEV_ITER(x, out, w, len, offset, t)                                   \
+    ({                                                                               \
+        i64_t $i, $s, $e, $cnt = 0;                                                  \
+        f64_t $k, $d, $sum = 0.0, $sq = 0.0, $avg, $var;                             \
+        t##_t *$in = __AS_##t(x);                                                    \
+        f64_t *$out = AS_F64(out);                                                   \
+        $s = MOVING_START(w, offset);                                                \
+        $e = (offset) + (len);                                                       \
+        $k = ($s < $e) ? (f64_t)MOVING_NUM_##t($in[$s]) : 0.0;                       \
+        for ($i = $s; $i < $e; $i++) {                                               \
+            if (!MOVING_NIL_##t($in[$i])) {                                          \
+                $d = (f64_t)$in[$i] - $k;                                            \
+                $sum += $d;                                                          \
+                $sq += $d * $d;                                                      \
+                $cnt++;                                                              \
+            }                                                                        \
+            if ($i - (w) >= $s && !MOVING_NIL_##t($in[$i - (w)])) {                  \
+                $d = (f64_t)$in[$i - (w)] - $k;                                      \
+                $sum -= $d;                                                          \
+                $sq -= $d * $d;                                                      \
+                $cnt--;                                                              \
+            }                                                                        \
+            if ($i >= (offset)) {                                                    \
+                if ($cnt == 0) {                                                     \
+                    $out[$i] = NULL_F64;                                             \
+                    continue;                                                        \
+                }                                                                    \
+                $avg = $sum / (f64_t)$cnt;                                           \
+                $var = $sq / (f64_t)$cnt - $avg * $avg;                              \
+                $out[$i] = ($var > 0.0) ? sqrt($var) : 0.0;                          \
+            }                                                                        \
+        }                                                                            \
+    })
+
+// Monotonic deque of the indices still in the window: the front is the extreme,
+// every item is pushed and popped at most once
+#define MOVING_EXT_ITER(x, out, w, len, offset, t, cmp)                                \
+    ({                                                                                 \
+        i64_t $i, $s, $e, $h, $tl, $c, *$q;                                            \
+        t##_t *$in = __AS_##t(x);                                                      \
+        t##_t *$out = __AS_##t(out);                                                   \
+        $s = MOVING_START(w, offset);                                                  \
+        $e = (offset) + (len);                                                         \
+        for ($c = 1; $c <= (w) && $c <= $e - $s; $c <<= 1)                             \
+            ;                                                                          \
+        $q = (i64_t *)heap_alloc($c * sizeof(i64_t));                                  \
+        $c -= 1;                                                                       \
+        for ($i = $s, $h = 0, $tl = 0; $i < $e; $i++) {                                \
+            if ($h < $tl && $q[$h & $c] <= $i - (w))                                   \
+                $h++;                                                                  \
+            if (!MOVING_NIL_##t($in[$i])) {                                            \
+                while ($h < $tl && $in[$q[($tl - 1) & $c]] cmp $in[$i])                \
+                    $tl--;                                                             \
+                $q[$tl++ & $c] = $i;                                                   \
+            }                                                                          \
+            if ($i >= (offset))                                                        \
+                $out[$i] = ($h < $tl) ? $in[$q[$h & $c]] : __NULL_##t;                 \
+        }                                                                              \
+        heap_free($q);                                                                 \
+    })
+
+#define MOVING_EMA_ITER(x, out, a, t)                                       \
+    ({                                                                      \
+        i64_t $i, $l;                                                       \
+        f64_t $ema = NULL_F64;                                              \
+        b8_t $seen = B8_FALSE;                                              \
+        t##_t *$in = __AS_##t(x);                                           \
+        f64_t *$out = AS_F64(out);                                          \
+        $l = (x)->len;                                                      \
+        for ($i = 0; $i < $l; $i++) {                                       \
+            if (!MOVING_NIL_##t($in[$i])) {                                 \
+                $ema = $seen ? (a) * $in[$i] + (1.0 - (a)) * $ema : $in[$i]; \
+                $seen = B8_TRUE;                                            \
+            }                                                               \
+            $out[$i] = $ema;                                                \
+        }                                                                   \
+    })
+
+// Result type of a kernel over a vector of the given type, TYPE_ERR if not supported
+static i8_t moving_type(moving_kind_t kind, i8_t type) {
+    switch (type) {
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_F64:
+            break;
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_TIMESTAMP:
+            if (kind == MOVING_MIN || kind == MOVING_MAX)
+                return type;
+            return TYPE_ERR;
+        default:
+            return TYPE_ERR;
+    }
+
+    switch (kind) {
+        case MOVING_SUM:
+            return (type == TYPE_F64) ? TYPE_F64 : TYPE_I64;
+        case MOVING_MIN:
+        case MOVING_MAX:
+            return type;
+        default:
+            return TYPE_F64;
+    }
+}
+
+static f64_t moving_alpha(obj_p w) { return (w->type == -TYPE_F64) ? w->f64 : 2.0 / (f64_t)(w->i64 + 1); }
+
+static obj_p moving_partial(i64_t kind, obj_p x, obj_p w, i64_t len, i64_t offset, obj_p out) {
+    i64_t n = w->i64;
+    f64_t a;
+
+    switch (kind) {
+        case MOVING_SUM:
+            switch (x->type) {
+                case TYPE_I32:
+                    MOVING_SUM_ITER(x, out, n, len, offset, i32, i64);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                    MOVING_SUM_ITER(x, out, n, len, offset, i64, i64);
+                    return NULL_OBJ;
+                default:
+                    MOVING_SUM_ITER(x, out, n, len, offset, f64, f64);
+                    return NULL_OBJ;
+            }
+        case MOVING_AVG:
+            switch (x->type) {
+                case TYPE_I32:
+                    MOVING_AVG_ITER(x, out, n, len, offset, i32, i64);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                    MOVING_AVG_ITER(x, out, n, len, offset, i64, i64);
+                    return NULL_OBJ;
+                default:
+                    MOVING_AVG_ITER(x, out, n, len, offset, f64, f64);
+                    return NULL_OBJ;
+            }
+        case MOVING_DEV:
+            switch (x->type) {
+                case TYPE_I32:
+                    MOVING_DEV_ITER(x, out, n, len, offset, i32);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                    MOVING_DEV_ITER(x, out, n, len, offset, i64);
+                    return NULL_OBJ;
+                default:
+                    MOVING_DEV_ITER(x, out, n, len, offset, f64);
+                    return NULL_OBJ;
+            }
+        case MOVING_MIN:
+            switch (x->type) {
+                case TYPE_I32:
+                case TYPE_DATE:
+                case TYPE_TIME:
+                    MOVING_EXT_ITER(x, out, n, len, offset, i32, >=);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                case TYPE_TIMESTAMP:
+                    MOVING_EXT_ITER(x, out, n, len, offset, i64, >=);
+                    return NULL_OBJ;
+                default:
+                    MOVING_EXT_ITER(x, out, n, len, offset, f64, >=);
+                    return NULL_OBJ;
+            }
+        case MOVING_MAX:
+            switch (x->type) {
+                case TYPE_I32:
+                case TYPE_DATE:
+                case TYPE_TIME:
+                    MOVING_EXT_ITER(x, out, n, len, offset, i32, <=);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                case TYPE_TIMESTAMP:
+                    MOVING_EXT_ITER(x, out, n, len, offset, i64, <=);
+                    return NULL_OBJ;
+                default:
+                    MOVING_EXT_ITER(x, out, n, len, offset, f64, <=);
+                    return NULL_OBJ;
+            }
+        case MOVING_EMA:
+            a = moving_alpha(w);
+            switch (x->type) {
+                case TYPE_I32:
+                    MOVING_EMA_ITER(x, out, a, i32);
+                    return NULL_OBJ;
+                case TYPE_I64:
+                    MOVING_EMA_ITER(x, out, a, i64);
+                    return NULL_OBJ;
+                default:
+                    MOVING_EMA_ITER(x, out, a, f64);
+                    return NULL_OBJ;
+            }
+    }
+
+    return NULL_OBJ;
+}
+
+// Runs the kernel over whole groups [offset, offset + len) of a list of group vectors
+static obj_p moving_groups_partial(i64_t kind, obj_p x, obj_p w, i64_t len, i64_t offset, obj_p out) {
+    i64_t i;
+    obj_p v;
+
+    for (i = offset; i < offset + len; i++) {
+        v = AS_LIST(x)[i];
+        moving_partial(kind, v, w, v->len, 0, AS_LIST(out)[i]);
+    }
+
+    return NULL_OBJ;
+}
+
+static obj_p moving_vector(moving_kind_t kind, obj_p w, obj_p x) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, chunk;
+    obj_p v, out;
+    raw_p argv[6];
+
+    l = x->len;
+    out = vector(moving_type(kind, x->type), l);
+
+    // A window is only cut where the warm up of a chunk is small against its length,
+    // the ema carries its state through the whole vector
+    n = (kind == MOVING_EMA) ? 1 : pool_split_by(pool, l, 0);
+    if (n > 1 && w->i64 > l / (n * 4))
+        n = 1;
+
+    if (n == 1) {
+        argv[0] = (raw_p)(i64_t)kind;
+        argv[1] = x;
+        argv[2] = w;
+        argv[3] = (raw_p)l;
+        argv[4] = (raw_p)0;
+        argv[5] = out;
+        pool_call_task_fn((raw_p)moving_partial, 6, argv);
+        return out;
+    }
+
+    pool_prepare(pool);
+    chunk = l / n;
+
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)moving_partial, 6, (i64_t)kind, x, w, chunk, i * chunk, out);
+
+    pool_add_task(pool, (raw_p)moving_partial, 6, (i64_t)kind, x, w, l - i * chunk, i * chunk, out);
+
+    v = pool_run(pool);
+    if (IS_ERR(v)) {
+        drop_obj(out);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return out;
+}
+
+// Groups are independent, so they are spread over the executors as a whole
+static obj_p moving_list(moving_kind_t kind, obj_p w, obj_p x) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, rows, chunk;
+    i8_t type;
+    obj_p v, out;
+    raw_p argv[6];
+
+    l = x->len;
+    out = LIST(l);
+
+    for (i = 0, rows = 0; i < l; i++) {
+        v = AS_LIST(x)[i];
+        type = moving_type(kind, v->type);
+        if (type == TYPE_ERR) {
+            out->len = i;
+            drop_obj(out);
+            THROW(ERR_TYPE, "%s: unsupported type: '%s", MOVING_NAMES[kind], type_name(v->type));
+        }
+
+        AS_LIST(out)[i] = vector(type, v->len);
+        rows += v->len;
+    }
+
+    n = pool_split_by(pool, rows, 0);
+    if (n > l)
+        n = l;
+
+    if (n <= 1) {
+        argv[0] = (raw_p)(i64_t)kind;
+        argv[1] = x;
+        argv[2] = w;
+        argv[3] = (raw_p)l;
+        argv[4] = (raw_p)0;
+        argv[5] = out;
+        pool_call_task_fn((raw_p)moving_groups_partial, 6, argv);
+        return out;
+    }
+
+    pool_prepare(pool);
+    chunk = l / n;
+
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)moving_groups_partial, 6, (i64_t)kind, x, w, chunk, i * chunk, out);
+
+    pool_add_task(pool, (raw_p)moving_groups_partial, 6, (i64_t)kind, x, w, l - i * chunk, i * chunk, out);
+
+    v = pool_run(pool);
+    if (IS_ERR(v)) {
+        drop_obj(out);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return out;
+}
+
+static obj_p moving_map(moving_kind_t kind, obj_p x, obj_p y) {
+    obj_p v, res;
+
+    if (kind == MOVING_EMA) {
+        if (x->type == -TYPE_F64) {
+            if (!(x->f64 > 0.0 && x->f64 <= 1.0))
+                THROW(ERR_LENGTH, "ema: smoothing factor must be in (0, 1]");
+        } else if (x->type == -TYPE_I64) {
+            if (x->i64 < 1)
+                THROW(ERR_LENGTH, "ema: span must be positive");
+        } else
+            THROW(ERR_TYPE, "ema: expected 'F64 or 'I64 as first argument, got '%s", type_name(x->type));
+    } else {
+        if (x->type != -TYPE_I64)
+            THROW(ERR_TYPE, "%s: expected 'I64 as window, got '%s", MOVING_NAMES[kind], type_name(x->type));
+        if (x->i64 < 1)
+            THROW(ERR_LENGTH, "%s: window must be positive", MOVING_NAMES[kind]);
+    }
+
+    switch (y->type) {
+        case TYPE_MAPGROUP:
+            v = aggr_collect(AS_LIST(y)[0], AS_LIST(y)[1]);
+            if (IS_ERR(v))
+                return v;
+            res = moving_list(kind, x, v);
+            drop_obj(v);
+            return res;
+        case TYPE_LIST:
+            return moving_list(kind, x, y);
+        default:
+            if (moving_type(kind, y->type) == TYPE_ERR)
+                THROW(ERR_TYPE, "%s: unsupported type: '%s", MOVING_NAMES[kind], type_name(y->type));
+            return moving_vector(kind, x, y);
+    }
+}
+
+typedef enum scan_kind_t {
+    SCAN_SUM,
+    SCAN_PRD,
+    SCAN_MIN,
+    SCAN_MAX,
+    SCAN_DELTA,
+    SCAN_RATIO,
+    SCAN_FILL,
+} scan_kind_t;
+
+static lit_p SCAN_NAMES[] = {"sums", "prds", "mins", "maxs", "deltas", "ratios", "fills"};
+
+// A scan folds the items of type t into a state of type st: chunks of a vector (or
+// of the rows of a group index) are folded first, their states are joined into the
+// carries each chunk starts from, then every chunk is scanned again in parallel
+#define SCAN_INIT_SUM(st) 0
+#define SCAN_INIT_PRD(st) 1
+#define SCAN_INIT_MIN(st) __NULL_##st
+#define SCAN_INIT_MAX(st) __NULL_##st
+#define SCAN_INIT_DELTA(st) __NULL_##st
+#define SCAN_INIT_RATIO(st) __NULL_##st
+#define SCAN_INIT_FILL(st) __NULL_##st
+
+// Folds the item v into the state s and sets the output o, f is set on the first
+// item of a vector or of a group
+#define SCAN_STEP_SUM(s, v, o, f, t, st) \
+    {                                    \
+        s += MOVING_NUM_##t(v);          \
+        o = s;                           \
+    }
+#define SCAN_STEP_PRD(s, v, o, f, t, st)          \
+    {                                             \
+        s *= MOVING_NIL_##t(v) ? 1 : (st##_t)(v); \
+        o = s;                                    \
+    }
+#define SCAN_STEP_MIN(s, v, o, f, t, st)                           \
+    {                                                              \
+        if (!MOVING_NIL_##t(v) && (MOVING_NIL_##st(s) || (v) < s)) \
+            s = v;                                                 \
+        o = s;                                                     \
+    }
+#define SCAN_STEP_MAX(s, v, o, f, t, st)                           \
+    {                                                              \
+        if (!MOVING_NIL_##t(v) && (MOVING_NIL_##st(s) || (v) > s)) \
+            s = v;                                                 \
+        o = s;                                                     \
+    }
+#define SCAN_STEP_DELTA(s, v, o, f, t, st)                                                      \
+    {                                                                                           \
+        o = (f) ? (v) : (MOVING_NIL_##t(v) || MOVING_NIL_##t(s)) ? __NULL_##t : (t##_t)((v) - s); \
+        s = v;                                                                                  \
+    }
+#define SCAN_STEP_RATIO(s, v, o, f, t, st)                                                         \
+    {                                                                                              \
+        o = MOVING_NIL_##t(v) ? NULL_F64                                                           \
+            : (f)             ? (f64_t)(v)                                                         \
+            : MOVING_NIL_##t(s) ? NULL_F64                                                         \
+                                : (f64_t)(v) / (f64_t)s;                                           \
+        s = v;                                                                                     \
+    }
+#define SCAN_STEP_FILL(s, v, o, f, t, st) \
+    {                                     \
+        if (!MOVING_NIL_##t(v))           \
+            s = v;                        \
+        o = s;                            \
+    }
+
+// Joins the state v of a chunk of k items into the carry s
+#define SCAN_JOIN_SUM(s, v, k, st) s += v
+#define SCAN_JOIN_PRD(s, v, k, st) s *= v
+#define SCAN_JOIN_MIN(s, v, k, st)                                   \
+    if (!MOVING_NIL_##st(v) && (MOVING_NIL_##st(s) || (v) < s)) \
+    s = v
+#define SCAN_JOIN_MAX(s, v, k, st)                                   \
+    if (!MOVING_NIL_##st(v) && (MOVING_NIL_##st(s) || (v) > s)) \
+    s = v
+#define SCAN_JOIN_DELTA(s, v, k, st) \
+    if (k)                           \
+    s = v
+#define SCAN_JOIN_RATIO(s, v, k, st) \
+    if (k)                           \
+    s = v
+#define SCAN_JOIN_FILL(s, v, k, st) \
+    if (!MOVING_NIL_##st(v))        \
+    s = v
+
+// Expands Iter(op, t, st, ot, ...) for the kind and the item type
+#define SCAN_TYPES_ACC(op, type, Iter, ...)                \
+    switch (type) {                                        \
+        case TYPE_I32:                                     \
+            Iter(op, i32, i64, i64, __VA_ARGS__);          \
+            break;                                         \
+        case TYPE_I64:                                     \
+            Iter(op, i64, i64, i64, __VA_ARGS__);          \
+            break;                                         \
+        default:                                           \
+            Iter(op, f64, f64, f64, __VA_ARGS__);          \
+            break;                                         \
+    }
+
+#define SCAN_TYPES_SAME(op, type, Iter, ...)               \
+    switch (type) {                                        \
+        case TYPE_I32:                                     \
+        case TYPE_DATE:                                    \
+        case TYPE_TIME:                                    \
+            Iter(op, i32, i32, i32, __VA_ARGS__);          \
+            break;                                         \
+        case TYPE_I64:                                     \
+        case TYPE_SYMBOL:                                  \
+        case TYPE_TIMESTAMP:                               \
+            Iter(op, i64, i64, i64, __VA_ARGS__);          \
+            break;                                         \
+        default:                                           \
+            Iter(op, f64, f64, f64, __VA_ARGS__);          \
+            break;                                         \
+    }
+
+#define SCAN_TYPES_RATIO(op, type, Iter, ...)              \
+    switch (type) {                                        \
+        case TYPE_I32:                                     \
+            Iter(op, i32, i32, f64, __VA_ARGS__);          \
+            break;                                         \
+        case TYPE_I64:                                     \
+            Iter(op, i64, i64, f64, __VA_ARGS__);          \
+            break;                                         \
+        default:                                           \
+            Iter(op, f64, f64, f64, __VA_ARGS__);          \
+            break;                                         \
+    }
+
+#define SCAN_SWITCH(kind, type, Iter, ...)                          \
+    switch (kind) {                                                 \
+        case SCAN_SUM:                                              \
+            SCAN_TYPES_ACC(SUM, type, Iter, __VA_ARGS__);           \
+            break;                                                  \
+        case SCAN_PRD:                                              \
+            SCAN_TYPES_ACC(PRD, type, Iter, __VA_ARGS__);           \
+            break;                                                  \
+        case SCAN_MIN:                                              \
+            SCAN_TYPES_SAME(MIN, type, Iter, __VA_ARGS__);          \
+            break;                                                  \
+        case SCAN_MAX:                                              \
+            SCAN_TYPES_SAME(MAX, type, Iter, __VA_ARGS__);          \
+            break;                                                  \
+        case SCAN_DELTA:                                            \
+            SCAN_TYPES_SAME(DELTA, type, Iter, __VA_ARGS__);        \
+            break;                                                  \
+        case SCAN_RATIO:                                            \
+            SCAN_TYPES_RATIO(RATIO, type, Iter, __VA_ARGS__);       \
+            break;                                                  \
+        case SCAN_FILL:                                             \
+            SCAN_TYPES_SAME(FILL, type, Iter, __VA_ARGS__);         \
+            break;                                                  \
+    }
+
+#define SCAN_FOLD(op, t, st, ot, x, len, offset, carry, c)                     \
+    ({                                                                         \
+        i64_t $i;                                                              \
+        st##_t $s = SCAN_INIT_##op(st);                                        \
+        ot##_t $v = 0;                                                         \
+        t##_t *$in = __AS_##t(x);                                              \
+        for ($i = (offset); $i < (offset) + (len); $i++)                       \
+            SCAN_STEP_##op($s, $in[$i], $v, $i == 0, t, st);                   \
+        UNUSED($v);                                                            \
+        __AS_##st(carry)[c] = $s;                                              \
+    })
+
+#define SCAN_RUN(op, t, st, ot, x, out, len, offset, carry, c)                 \
+    ({                                                                         \
+        i64_t $i;                                                              \
+        st##_t $s;                                                             \
+        t##_t *$in = __AS_##t(x);                                              \
+        ot##_t *$out = __AS_##ot(out);                                         \
+        $s = ((carry) == NULL_OBJ) ? SCAN_INIT_##op(st) : __AS_##st(carry)[c]; \
+        for ($i = (offset); $i < (offset) + (len); $i++)                       \
+            SCAN_STEP_##op($s, $in[$i], $out[$i], $i == 0, t, st);             \
+    })
+
+// Replaces the chunk states by the carries each chunk starts from
+#define SCAN_CARRY(op, t, st, ot, carry, n)      \
+    ({                                           \
+        i64_t $c;                                \
+        st##_t $s = SCAN_INIT_##op(st), $v;      \
+        for ($c = 0; $c < (n); $c++) {           \
+            $v = __AS_##st(carry)[$c];           \
+            __AS_##st(carry)[$c] = $s;           \
+            SCAN_JOIN_##op($s, $v, 1, st);       \
+        }                                        \
+    })
+
+#define SCAN_GROUP_FOLD(op, t, st, ot, val, index, len, offset, state, count)                        \
+    ({                                                                                               \
+        i64_t *$cnt = AS_I64(count);                                                                 \
+        ot##_t $v = 0;                                                                               \
+        AGGR_ITER(index, len, offset, val, state, t, st,                                             \
+                  {                                                                                  \
+                      $out[$y] = SCAN_INIT_##op(st);                                                 \
+                      $cnt[$y] = 0;                                                                  \
+                  },                                                                                 \
+                  {                                                                                  \
+                      SCAN_STEP_##op($out[$y], $in[$x], $v, $cnt[$y] == 0, t, st);                   \
+                      $cnt[$y]++;                                                                    \
+                  }, );                                                                              \
+        UNUSED($v);                                                                                  \
+    })
+
+#define SCAN_GROUP_RUN(op, t, st, ot, val, index, len, offset, state, pos, res)                      \
+    ({                                                                                               \
+        i64_t $p, *$pos = AS_I64(pos);                                                               \
+        obj_p *$res = AS_LIST(res);                                                                  \
+        AGGR_ITER(index, len, offset, val, state, t, st, ,                                           \
+                  {                                                                                  \
+                      $p = $pos[$y]++;                                                               \
+                      SCAN_STEP_##op($out[$y], $in[$x], __AS_##ot($res[$y])[$p], $p == 0, t, st);    \
+                  }, );                                                                              \
+    })
+
+// Turns the chunk states and counts of every group into the carries and the
+// positions each chunk starts from, the totals are the group sizes
+#define SCAN_GROUP_CARRY(op, t, st, ot, states, counts, groups, sizes)                               \
+    ({                                                                                               \
+        i64_t $c, $y, $k, $p;                                                                        \
+        st##_t $s, $v;                                                                               \
+        for ($y = 0; $y < (groups); $y++) {                                                          \
+            $s = SCAN_INIT_##op(st);                                                                 \
+            for ($c = 0, $p = 0; $c < (states)->len; $c++) {                                         \
+                $v = __AS_##st(AS_LIST(states)[$c])[$y];                                             \
+                $k = AS_I64(AS_LIST(counts)[$c])[$y];                                                \
+                __AS_##st(AS_LIST(states)[$c])[$y] = $s;                                             \
+                AS_I64(AS_LIST(counts)[$c])[$y] = $p;                                                \
+                SCAN_JOIN_##op($s, $v, $k, st);                                                      \
+                $p += $k;                                                                            \
+            }                                                                                        \
+            (sizes)[$y] = $p;                                                                        \
+        }                                                                                            \
+    })
+
+// Result type of a scan over a vector of the given type, TYPE_ERR if not supported
+static i8_t scan_type(scan_kind_t kind, i8_t type) {
+    switch (type) {
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_F64:
+            break;
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_TIMESTAMP:
+            if (kind == SCAN_MIN || kind == SCAN_MAX || kind == SCAN_FILL)
+                return type;
+            return TYPE_ERR;
+        case TYPE_SYMBOL:
+            if (kind == SCAN_FILL)
+                return type;
+            return TYPE_ERR;
+        default:
+            return TYPE_ERR;
+    }
+
+    switch (kind) {
+        case SCAN_SUM:
+        case SCAN_PRD:
+            return (type == TYPE_F64) ? TYPE_F64 : TYPE_I64;
+        case SCAN_RATIO:
+            return TYPE_F64;
+        default:
+            return type;
+    }
+}
+
+// Type of the state carried between chunks
+static i8_t scan_state_type(scan_kind_t kind, i8_t type) {
+    if (kind == SCAN_SUM || kind == SCAN_PRD)
+        return (type == TYPE_F64) ? TYPE_F64 : TYPE_I64;
+
+    return type;
+}
+
+static obj_p scan_fold_partial(i64_t kind, obj_p x, i64_t len, i64_t offset, obj_p carry, i64_t c) {
+    SCAN_SWITCH(kind, x->type, SCAN_FOLD, x, len, offset, carry, c);
+    return NULL_OBJ;
+}
+
+static obj_p scan_partial(i64_t kind, obj_p x, i64_t len, i64_t offset, obj_p out, obj_p carry, i64_t c) {
+    SCAN_SWITCH(kind, x->type, SCAN_RUN, x, out, len, offset, carry, c);
+    return NULL_OBJ;
+}
+
+static obj_p scan_group_fold_partial(i64_t kind, obj_p val, obj_p index, i64_t len, i64_t offset, obj_p state,
+                                     obj_p count) {
+    SCAN_SWITCH(kind, val->type, SCAN_GROUP_FOLD, val, index, len, offset, state, count);
+    return NULL_OBJ;
+}
+
+static obj_p scan_group_partial(i64_t kind, obj_p val, obj_p index, i64_t len, i64_t offset, obj_p state, obj_p pos,
+                                obj_p res) {
+    SCAN_SWITCH(kind, val->type, SCAN_GROUP_RUN, val, index, len, offset, state, pos, res);
+    return NULL_OBJ;
+}
+
+static obj_p scan_vector(scan_kind_t kind, obj_p x) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, chunk, size;
+    obj_p v, out, carry;
+    raw_p argv[7];
+
+    l = x->len;
+    out = vector(scan_type(kind, x->type), l);
+    n = pool_split_by(pool, l, 0);
+
+    if (n == 1) {
+        argv[0] = (raw_p)(i64_t)kind;
+        argv[1] = x;
+        argv[2] = (raw_p)l;
+        argv[3] = (raw_p)0;
+        argv[4] = out;
+        argv[5] = NULL_OBJ;
+        argv[6] = (raw_p)0;
+        pool_call_task_fn((raw_p)scan_partial, 7, argv);
+        return out;
+    }
+
+    chunk = l / n;
+    carry = vector(scan_state_type(kind, x->type), n);
+
+    // Deltas and ratios only need the item before the chunk
+    if (kind == SCAN_DELTA || kind == SCAN_RATIO) {
+        size = size_of_type(x->type);
+        memset(AS_C8(carry), 0, size);
+        for (i = 1; i < n; i++)
+            memcpy(AS_C8(carry) + i * size, AS_C8(x) + (i * chunk - 1) * size, size);
+    } else {
+        pool_prepare(pool);
+        for (i = 0; i < n - 1; i++)
+            pool_add_task(pool, (raw_p)scan_fold_partial, 6, (i64_t)kind, x, chunk, i * chunk, carry, i);
+
+        v = pool_run(pool);
+        if (IS_ERR(v)) {
+            drop_obj(carry);
+            drop_obj(out);
+            return v;
+        }
+
+        drop_obj(v);
+        SCAN_SWITCH(kind, x->type, SCAN_CARRY, carry, n);
+    }
+
+    pool_prepare(pool);
+
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)scan_partial, 7, (i64_t)kind, x, chunk, i * chunk, out, carry, i);
+
+    pool_add_task(pool, (raw_p)scan_partial, 7, (i64_t)kind, x, l - i * chunk, i * chunk, out, carry, i);
+
+    v = pool_run(pool);
+    drop_obj(carry);
+    if (IS_ERR(v)) {
+        drop_obj(out);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return out;
+}
+
+static obj_p scan_list(scan_kind_t kind, obj_p x) {
+    i64_t i, l;
+    obj_p v, res;
+
+    l = x->len;
+    res = LIST(l);
+
+    for (i = 0; i < l; i++) {
+        v = AS_LIST(x)[i];
+        if (scan_type(kind, v->type) == TYPE_ERR) {
+            res->len = i;
+            drop_obj(res);
+            THROW(ERR_TYPE, "%s: unsupported type: '%s", SCAN_NAMES[kind], type_name(v->type));
+        }
+
+        AS_LIST(res)[i] = scan_vector(kind, v);
+    }
+
+    return res;
+}
+
+// Scans every group in the order of its rows straight over the group index: a pass
+// over the row chunks counts and folds the groups, a second one writes the results
+static obj_p scan_groups(scan_kind_t kind, obj_p val, obj_p index) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, groups, chunk, *sizes;
+    i8_t otype, stype;
+    obj_p v, states, counts, sizes_obj, res;
+    raw_p argv[8];
+
+    groups = index_group_count(index);
+    l = index_group_len(index);
+    otype = scan_type(kind, val->type);
+    stype = scan_state_type(kind, val->type);
+
+    n = pool_split_by(pool, l, groups);
+
+    states = LIST(n);
+    counts = LIST(n);
+    for (i = 0; i < n; i++) {
+        AS_LIST(states)[i] = vector(stype, groups);
+        AS_LIST(counts)[i] = vector(TYPE_I64, groups);
+    }
+
+    chunk = l / n;
+
+    if (n == 1) {
+        argv[0] = (raw_p)(i64_t)kind;
+        argv[1] = val;
+        argv[2] = index;
+        argv[3] = (raw_p)l;
+        argv[4] = (raw_p)0;
+        argv[5] = AS_LIST(states)[0];
+        argv[6] = AS_LIST(counts)[0];
+        pool_call_task_fn((raw_p)scan_group_fold_partial, 7, argv);
+    } else {
+        pool_prepare(pool);
+        for (i = 0; i < n - 1; i++)
+            pool_add_task(pool, (raw_p)scan_group_fold_partial, 7, (i64_t)kind, val, index, chunk, i * chunk,
+                          AS_LIST(states)[i], AS_LIST(counts)[i]);
+
+        pool_add_task(pool, (raw_p)scan_group_fold_partial, 7, (i64_t)kind, val, index, l - i * chunk, i * chunk,
+                      AS_LIST(states)[i], AS_LIST(counts)[i]);
+
+        v = pool_run(pool);
+        if (IS_ERR(v)) {
+            drop_obj(states);
+            drop_obj(counts);
+            return v;
+        }
+
+        drop_obj(v);
+    }
+
+    sizes_obj = vector(TYPE_I64, groups);
+    sizes = AS_I64(sizes_obj);
+    SCAN_SWITCH(kind, val->type, SCAN_GROUP_CARRY, states, counts, groups, sizes);
+
+    res = LIST(groups);
+    for (i = 0; i < groups; i++)
+        AS_LIST(res)[i] = vector(otype, sizes[i]);
+
+    drop_obj(sizes_obj);
+
+    if (n == 1) {
+        argv[0] = (raw_p)(i64_t)kind;
+        argv[1] = val;
+        argv[2] = index;
+        argv[3] = (raw_p)l;
+        argv[4] = (raw_p)0;
+        argv[5] = AS_LIST(states)[0];
+        argv[6] = AS_LIST(counts)[0];
+        argv[7] = res;
+        pool_call_task_fn((raw_p)scan_group_partial, 8, argv);
+    } else {
+        pool_prepare(pool);
+        for (i = 0; i < n - 1; i++)
+            pool_add_task(pool, (raw_p)scan_group_partial, 8, (i64_t)kind, val, index, chunk, i * chunk,
+                          AS_LIST(states)[i], AS_LIST(counts)[i], res);
+
+        pool_add_task(pool, (raw_p)scan_group_partial, 8, (i64_t)kind, val, index, l - i * chunk, i * chunk,
+                      AS_LIST(states)[i], AS_LIST(counts)[i], res);
+
+        v = pool_run(pool);
+        if (IS_ERR(v)) {
+            drop_obj(states);
+            drop_obj(counts);
+            drop_obj(res);
+            return v;
+        }
+
+        drop_obj(v);
+    }
+
+    drop_obj(states);
+    drop_obj(counts);
+
+    return res;
+}
+
+static obj_p scan_map(scan_kind_t kind, obj_p x) {
+    obj_p v, res;
+
+    switch (x->type) {
+        case TYPE_MAPGROUP:
+            v = AS_LIST(x)[0];
+            if (scan_type(kind, v->type) == TYPE_ERR)
+                THROW(ERR_TYPE, "%s: unsupported type: '%s", SCAN_NAMES[kind], type_name(v->type));
+
+            switch (index_group_type(AS_LIST(x)[1])) {
+                case INDEX_TYPE_IDS:
+                case INDEX_TYPE_SHIFT:
+                    return scan_groups(kind, v, AS_LIST(x)[1]);
+                default:
+                    v = aggr_collect(v, AS_LIST(x)[1]);
+                    if (IS_ERR(v))
+                        return v;
+                    res = scan_list(kind, v);
+                    drop_obj(v);
+                    return res;
+            }
+        case TYPE_LIST:
+            return scan_list(kind, x);
+        default:
+            if (scan_type(kind, x->type) == TYPE_ERR)
+                THROW(ERR_TYPE, "%s: unsupported type: '%s", SCAN_NAMES[kind], type_name(x->type));
+            return scan_vector(kind, x);
+    }
+}
+
+obj_p ray_msum(obj_p x, obj_p y) { return moving_map(MOVING_SUM, x, y); }
+obj_p ray_mavg(obj_p x, obj_p y) { return moving_map(MOVING_AVG, x, y); }
+obj_p ray_mmin(obj_p x, obj_p y) { return moving_map(MOVING_MIN, x, y); }
+obj_p ray_mmax(obj_p x, obj_p y) { return moving_map(MOVING_MAX, x, y); }
+obj_p ray_mdev(obj_p x, obj_p y) { return moving_map(MOVING_DEV, x, y); }
+obj_p ray_ema(obj_p x, obj_p y) { return moving_map(MOVING_EMA, x, y); }
+
+obj_p ray_sums(obj_p x) { return scan_map(SCAN_SUM, x); }
+obj_p ray_prds(obj_p x) { return scan_map(SCAN_PRD, x); }
+obj_p ray_mins(obj_p x) { return scan_map(SCAN_MIN, x); }
+obj_p ray_maxs(obj_p x) { return scan_map(SCAN_MAX, x); }
+obj_p ray_deltas(obj_p x) { return scan_map(SCAN_DELTA, x); }
+obj_p ray_ratios(obj_p x) { return scan_map(SCAN_RATIO, x); }
+obj_p ray_fills(obj_p x) { return scan_map(SCAN_FILL, x); }
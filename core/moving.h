@@ -0,0 +1,49 @@
+/*
+ *   Copyright (c) 2023 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef MOVING_H
+#define MOVING_H
+
+#include "rayforce.h"
+
+// Sliding window aggregates over the last x items (the current one included),
+// applied per group when y is a grouped column of a select/update by
+obj_p ray_msum(obj_p x, obj_p y);
+obj_p ray_mavg(obj_p x, obj_p y);
+obj_p ray_mmin(obj_p x, obj_p y);
+obj_p ray_mmax(obj_p x, obj_p y);
+obj_p ray_mdev(obj_p x, obj_p y);
+
+// Exponential moving average, x is either the smoothing factor or the span
+obj_p ray_ema(obj_p x, obj_p y);
+
+// Running scans, per group in the order of the rows for a grouped column
+obj_p ray_sums(obj_p x);
+obj_p ray_prds(obj_p x);
+obj_p ray_mins(obj_p x);
+obj_p ray_maxs(obj_p x);
+obj_p ray_deltas(obj_p x);
+obj_p ray_ratios(obj_p x);
+obj_p ray_fills(obj_p x);
+
+#endif  // MOVING_H
@@ -135,6 +135,9 @@ b8_t ops_eq_idx(obj_p a, i64_t ai, obj_p b, i64_t bi) {
         case MTYPE2(TYPE_LIST, TYPE_LIST):
             return cmp_obj(AS_LIST(a)[ai], AS_LIST(b)[bi]) == 0;
         case MTYPE2(TYPE_ENUM, TYPE_ENUM):
+            // codes over the same domain are compared as they are
+            if (a == b || strcmp(ENUM_KEY(a), ENUM_KEY(b)) == 0)
+                return AS_I64(ENUM_VAL(a))[ai] == AS_I64(ENUM_VAL(b))[bi];
             lv = at_idx(a, ai);
             rv = at_idx(b, bi);
             eq = lv->i64 == rv->i64;
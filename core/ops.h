@@ -76,6 +76,7 @@ extern struct obj_t __NULL_OBJECT;
 #define EQF64(x, y) (ISNANF64(x) ? ISNANF64(y) : ISNANF64(y) ? 0 : (x) == (y))
 #define EQGUID(x, y) (memcmp((x), (y), sizeof(guid_t)) == 0)
 #define EQSTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) == 0)
+#define EQSYM(x, y) ((x) == (y))
 #define NEI8(x, y) ((x) != (y))
 #define NEC8(x, y) ((x) != (y))
 #define NEI16(x, y) ((x) != (y))
@@ -84,6 +85,7 @@ extern struct obj_t __NULL_OBJECT;
 #define NEF64(x, y) (!EQF64((x), (y)))
 #define NEGUID(x, y) (memcmp((x), (y), sizeof(guid_t)) != 0)
 #define NESTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) != 0)
+#define NESYM(x, y) ((x) != (y))
 #define LTI8(x, y) ((x) < (y))
 #define LTC8(x, y) ((x) < (y))
 #define LTI16(x, y) ((x) < (y))
@@ -92,6 +94,7 @@ extern struct obj_t __NULL_OBJECT;
 #define LTF64(x, y) (ISNANF64(x) ? !ISNANF64(y) : ISNANF64(y) ? 0 : (x) < (y))
 #define LTGUID(x, y) (memcmp((x), (y), sizeof(guid_t)) < 0)
 #define LTSTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) < 0)
+#define LTSYM(x, y) (symbols_cmp(runtime_get()->symbols, (x), (y)) < 0)
 #define GTI8(x, y) ((x) > (y))
 #define GTC8(x, y) ((x) > (y))
 #define GTI16(x, y) ((x) > (y))
@@ -100,6 +103,7 @@ extern struct obj_t __NULL_OBJECT;
 #define GTF64(x, y) (ISNANF64(y) ? !ISNANF64(x) : ISNANF64(x) ? 0 : (x) > (y))
 #define GTGUID(x, y) (memcmp((x), (y), sizeof(guid_t)) > 0)
 #define GTSTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) > 0)
+#define GTSYM(x, y) (symbols_cmp(runtime_get()->symbols, (x), (y)) > 0)
 #define LEI8(x, y) ((x) <= (y))
 #define LEC8(x, y) ((x) <= (y))
 #define LEI16(x, y) ((x) <= (y))
@@ -108,6 +112,7 @@ extern struct obj_t __NULL_OBJECT;
 #define LEF64(x, y) (!GTF64((x), (y)))
 #define LEGUID(x, y) (!GTGUID((x), (y)))
 #define LESTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) <= 0)
+#define LESYM(x, y) (symbols_cmp(runtime_get()->symbols, (x), (y)) <= 0)
 #define GEI8(x, y) ((x) >= (y))
 #define GEC8(x, y) ((x) >= (y))
 #define GEI16(x, y) ((x) >= (y))
@@ -116,6 +121,7 @@ extern struct obj_t __NULL_OBJECT;
 #define GEF64(x, y) (!LTF64((x), (y)))
 #define GEGUID(x, y) (!LTGUID((x), (y)))
 #define GESTR(x, xl, y, yl) (str_cmp((x), (xl), (y), (yl)) >= 0)
+#define GESYM(x, y) (symbols_cmp(runtime_get()->symbols, (x), (y)) >= 0)
 #define ABSI8(x) ((x) < 0 ? -(x) : (x))
 #define ABSI32(x) ((x) == NULL_I32 ? NULL_I32 : (((x) < 0 ? -(x) : (x))))
 #define ABSI64(x) ((x) == NULL_I64 ? NULL_I64 : (((x) < 0 ? -(x) : (x))))
@@ -242,5 +248,6 @@ static inline i32_t timestamp_to_time(i64_t x) {
     return (x == NULL_I64) ? NULL_I32 : (i32_t)(x % NANOS_FROM_DAY / NANOS_FROM_MILLIS);
 }
 static inline i64_t timestamp_to_timestamp(i64_t x) { return x; }
+static inline i64_t symbol_to_symbol(i64_t x) { return x; }
 
 #endif  // OPS_H
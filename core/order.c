@@ -27,6 +27,7 @@
 #include "error.h"
 #include "compose.h"
 #include "string.h"
+#include "items.h"
 
 obj_p ray_iasc(obj_p x) {
     switch (x->type) {
@@ -42,6 +43,7 @@ obj_p ray_iasc(obj_p x) {
         case TYPE_F64:
         case TYPE_LIST:
         case TYPE_SYMBOL:
+        case TYPE_ENUM:
         case TYPE_DICT:
             return ray_sort_asc(x);
         default:
@@ -63,6 +65,7 @@ obj_p ray_idesc(obj_p x) {
         case TYPE_F64:
         case TYPE_LIST:
         case TYPE_SYMBOL:
+        case TYPE_ENUM:
         case TYPE_DICT:
             return ray_sort_desc(x);
         default:
@@ -248,6 +251,93 @@ obj_p ray_desc(obj_p x) {
     }
 }
 
+// Collects the key columns of a table
+static obj_p xsort_keys(obj_p x, obj_p y) {
+    i64_t c, n;
+    obj_p keys, name, col;
+
+    n = y->len;
+    keys = LIST(n);
+    for (c = 0; c < n; c++) {
+        name = at_idx(y, c);
+        col = at_obj(x, name);
+        drop_obj(name);
+        if (IS_ERR(col)) {
+            keys->len = c;
+            drop_obj(keys);
+            return col;
+        }
+        AS_LIST(keys)[c] = col;
+    }
+
+    return keys;
+}
+
+// Sorts table rows by packed radix keys, or by stable passes over the columns (last key first)
+static obj_p xsort_by_keys(obj_p x, obj_p y, i64_t asc) {
+    i64_t c, i, n, nrow, *indices, *local, *tmp;
+    obj_p keys, reordered, idx, local_idx, obj_tmp, res;
+
+    n = y->len;
+
+    // Handle empty symbol vector - return original table
+    if (n == 0)
+        return clone_obj(x);
+
+    keys = xsort_keys(x, y);
+    if (IS_ERR(keys))
+        return keys;
+
+    idx = sort_multi_packed(keys, asc);
+
+    if (idx == NULL) {
+        nrow = AS_LIST(AS_LIST(x)[1])[0]->len;
+        idx = I64(nrow);
+        indices = AS_I64(idx);
+        for (i = 0; i < nrow; i++)
+            indices[i] = i;
+
+        for (c = n - 1; c >= 0; c--) {
+            reordered = at_obj(AS_LIST(keys)[c], idx);
+            if (IS_ERR(reordered)) {
+                drop_obj(keys);
+                drop_obj(idx);
+                return reordered;
+            }
+
+            local_idx = (asc > 0) ? ray_iasc(reordered) : ray_idesc(reordered);
+            drop_obj(reordered);
+            if (IS_ERR(local_idx)) {
+                drop_obj(keys);
+                drop_obj(idx);
+                return local_idx;
+            }
+
+            // Reorder indices according to local_idx
+            local = AS_I64(local_idx);
+            obj_tmp = I64(nrow);
+            tmp = AS_I64(obj_tmp);
+            for (i = 0; i < nrow; i++)
+                tmp[i] = indices[local[i]];
+
+            memcpy(indices, tmp, sizeof(i64_t) * nrow);
+
+            drop_obj(obj_tmp);
+            drop_obj(local_idx);
+        }
+    }
+
+    drop_obj(keys);
+
+    if (IS_ERR(idx))
+        return idx;
+
+    res = at_obj(x, idx);
+    drop_obj(idx);
+
+    return res;
+}
+
 obj_p ray_xasc(obj_p x, obj_p y) {
     obj_p idx, col, res;
 
@@ -268,62 +358,8 @@ obj_p ray_xasc(obj_p x, obj_p y) {
 
             return res;
 
-        case MTYPE2(TYPE_TABLE, TYPE_SYMBOL): {
-            i64_t n = y->len;
-
-            // Handle empty symbol vector - return original table
-            if (n == 0) {
-                return clone_obj(x);
-            }
-
-            i64_t nrow = AS_LIST(AS_LIST(x)[1])[0]->len;
-            obj_p idx = I64(nrow);
-            i64_t* indices = AS_I64(idx);
-            for (i64_t i = 0; i < nrow; i++)
-                indices[i] = i;
-
-            // Stable sort by each column from last to first, extracting only one column at a time
-            for (i64_t c = n - 1; c >= 0; c--) {
-                obj_p col_name = at_idx(y, c);
-                obj_p col = at_obj(x, col_name);
-                drop_obj(col_name);
-                if (IS_ERR(col)) {
-                    drop_obj(idx);
-                    return col;
-                }
-
-                obj_p col_reordered = at_obj(col, idx);
-                if (IS_ERR(col_reordered)) {
-                    drop_obj(col);
-                    drop_obj(idx);
-                    return col_reordered;
-                }
-                obj_p local_idx = ray_iasc(col_reordered);
-                drop_obj(col);
-                if (IS_ERR(local_idx)) {
-                    drop_obj(col_reordered);
-                    drop_obj(idx);
-                    return local_idx;
-                }
-
-                // Reorder indices according to local_idx
-                i64_t* local = AS_I64(local_idx);
-                obj_p obj_tmp = I64(nrow);
-                i64_t* tmp = AS_I64(obj_tmp);
-                for (i64_t i = 0; i < nrow; i++)
-                    tmp[i] = indices[local[i]];
-
-                memcpy(indices, tmp, sizeof(i64_t) * nrow);
-
-                drop_obj(obj_tmp);
-                drop_obj(col_reordered);
-                drop_obj(local_idx);
-            }
-
-            obj_p res = at_obj(x, idx);
-            drop_obj(idx);
-            return res;
-        }
+        case MTYPE2(TYPE_TABLE, TYPE_SYMBOL):
+            return xsort_by_keys(x, y, 1);
 
         case MTYPE2(TYPE_TABLE, TYPE_I64):
             // Handle empty vector [] (which has type I64 with length 0)
@@ -356,62 +392,8 @@ obj_p ray_xdesc(obj_p x, obj_p y) {
 
             return res;
 
-        case MTYPE2(TYPE_TABLE, TYPE_SYMBOL): {
-            i64_t n = y->len;
-
-            // Handle empty symbol vector - return original table
-            if (n == 0) {
-                return clone_obj(x);
-            }
-
-            i64_t nrow = AS_LIST(AS_LIST(x)[1])[0]->len;
-            obj_p idx = I64(nrow);
-            i64_t* indices = AS_I64(idx);
-            for (i64_t i = 0; i < nrow; i++)
-                indices[i] = i;
-
-            // Stable sort by each column from last to first, extracting only one column at a time
-            for (i64_t c = n - 1; c >= 0; c--) {
-                obj_p col_name = at_idx(y, c);
-                obj_p col = at_obj(x, col_name);
-                drop_obj(col_name);
-                if (IS_ERR(col)) {
-                    drop_obj(idx);
-                    return col;
-                }
-
-                obj_p col_reordered = at_obj(col, idx);
-                if (IS_ERR(col_reordered)) {
-                    drop_obj(col);
-                    drop_obj(idx);
-                    return col_reordered;
-                }
-                obj_p local_idx = ray_idesc(col_reordered);
-                drop_obj(col);
-                if (IS_ERR(local_idx)) {
-                    drop_obj(col_reordered);
-                    drop_obj(idx);
-                    return local_idx;
-                }
-
-                // Reorder indices according to local_idx
-                i64_t* local = AS_I64(local_idx);
-                obj_p obj_tmp = I64(nrow);
-                i64_t* tmp = AS_I64(obj_tmp);
-                for (i64_t i = 0; i < nrow; i++)
-                    tmp[i] = indices[local[i]];
-                for (i64_t i = 0; i < nrow; i++)
-                    indices[i] = tmp[i];
-
-                drop_obj(obj_tmp);
-                drop_obj(col_reordered);
-                drop_obj(local_idx);
-            }
-
-            obj_p res = at_obj(x, idx);
-            drop_obj(idx);
-            return res;
-        }
+        case MTYPE2(TYPE_TABLE, TYPE_SYMBOL):
+            return xsort_by_keys(x, y, -1);
 
         case MTYPE2(TYPE_TABLE, TYPE_I64):
             // Handle empty vector [] (which has type I64 with length 0)
@@ -424,6 +406,58 @@ obj_p ray_xdesc(obj_p x, obj_p y) {
     }
 }
 
+// First k rows of a table sorted by the columns: the same as (take k (xasc t cols))
+// but only the surviving rows are ordered and gathered
+static obj_p xsort_take(obj_p* x, i64_t n, i64_t asc) {
+    i64_t k, nrow;
+    obj_p cols, keys, idx, res, sorted;
+    lit_p name = (asc > 0) ? "xasc-take" : "xdesc-take";
+
+    if (n != 3)
+        THROW(ERR_LENGTH, "%s: expected 3 arguments, got %lld", name, n);
+
+    if (x[0]->type != TYPE_TABLE || (x[1]->type != -TYPE_SYMBOL && x[1]->type != TYPE_SYMBOL) ||
+        x[2]->type != -TYPE_I64)
+        THROW(ERR_TYPE, "%s: unsupported types: '%s, '%s, '%s", name, type_name(x[0]->type), type_name(x[1]->type),
+              type_name(x[2]->type));
+
+    k = x[2]->i64;
+    nrow = ops_count(x[0]);
+    idx = NULL;
+
+    if (k > 0 && k < nrow && ops_count(x[1]) > 0) {
+        cols = (x[1]->type == -TYPE_SYMBOL) ? ray_enlist(&x[1], 1) : clone_obj(x[1]);
+        keys = xsort_keys(x[0], cols);
+        drop_obj(cols);
+        if (IS_ERR(keys))
+            return keys;
+
+        idx = sort_multi_topk(keys, asc, k);
+        drop_obj(keys);
+    }
+
+    // Not packable or wrapping take: sort everything
+    if (idx == NULL) {
+        sorted = (asc > 0) ? ray_xasc(x[0], x[1]) : ray_xdesc(x[0], x[1]);
+        if (IS_ERR(sorted))
+            return sorted;
+
+        res = ray_take(x[2], sorted);
+        drop_obj(sorted);
+
+        return res;
+    }
+
+    res = at_obj(x[0], idx);
+    drop_obj(idx);
+
+    return res;
+}
+
+obj_p ray_xasc_take(obj_p* x, i64_t n) { return xsort_take(x, n, 1); }
+
+obj_p ray_xdesc_take(obj_p* x, i64_t n) { return xsort_take(x, n, -1); }
+
 obj_p ray_not(obj_p x) {
     i32_t i;
     i64_t l;
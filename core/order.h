@@ -32,6 +32,8 @@ obj_p ray_asc(obj_p x);
 obj_p ray_desc(obj_p x);
 obj_p ray_xasc(obj_p x, obj_p y);
 obj_p ray_xdesc(obj_p x, obj_p y);
+obj_p ray_xasc_take(obj_p *x, i64_t n);
+obj_p ray_xdesc_take(obj_p *x, i64_t n);
 obj_p ray_not(obj_p x);
 obj_p ray_neg(obj_p x);
 
@@ -34,6 +34,7 @@
 #define DEFAULT_MPMC_SIZE 2048
 #define POOL_SPLIT_THRESHOLD (RAY_PAGE_SIZE * 4)
 #define GROUP_SPLIT_THRESHOLD 100000
+#define BOUND_TASKS_MAX DEFAULT_MPMC_SIZE
 
 mpmc_p mpmc_create(i64_t size) {
     size = next_power_of_two_u64(size);
@@ -164,10 +165,39 @@ obj_p pool_call_task_fn(raw_p fn, i64_t argc, raw_p argv[]) {
     }
 }
 
+// Runs the bound task if nobody has taken it yet, returns whether it did
+static i64_t pool_run_bound(pool_p pool, i64_t id) {
+    task_data_t data;
+
+    if (__atomic_exchange_n(&pool->claims[id], 1, __ATOMIC_ACQ_REL))
+        return 0;
+
+    data = pool->tasks[id];
+    data.result = pool_call_task_fn(data.fn, data.argc, data.argv);
+    mpmc_push(pool->result_queue, data);
+
+    return 1;
+}
+
+// Task i is run by thread i modulo the threads first (the main thread is 0), so chunks split by offset
+// are processed on the node which has first touched their pages. Then the tasks left are taken by anyone.
+static i64_t pool_execute_bound(pool_p pool, i64_t slot, i64_t tasks_count) {
+    i64_t i, n = 0;
+
+    for (i = slot; i < tasks_count; i += pool->executors_count + 1)
+        n += pool_run_bound(pool, i);
+
+    for (i = 0; i < tasks_count; i++)
+        n += pool_run_bound(pool, i);
+
+    return n;
+}
+
 raw_p executor_run(raw_p arg) {
     executor_t *executor = (executor_t *)arg;
     task_data_t data;
     i64_t i, tasks_count;
+    b8_t bound;
     obj_p res;
     interpreter_p interpreter;
     heap_p heap;
@@ -175,6 +205,8 @@ raw_p executor_run(raw_p arg) {
     rc_sync_set(B8_TRUE);
 
     heap = heap_create(executor->id + 1);
+    if (thread_numa_nodes() > 1)
+        heap_set_node(thread_cpu_node(executor->id + 1));
     interpreter = interpreter_create(executor->id + 1);
 
     __atomic_store_n(&executor->heap, heap, __ATOMIC_RELAXED);
@@ -182,7 +214,10 @@ raw_p executor_run(raw_p arg) {
 
     for (;;) {
         mutex_lock(&executor->pool->mutex);
-        cond_wait(&executor->pool->run, &executor->pool->mutex);
+
+        // The stop may have been broadcast while this executor was still busy with the previous run
+        if (executor->pool->state != RUN_STATE_STOPPED)
+            cond_wait(&executor->pool->run, &executor->pool->mutex);
 
         if (executor->pool->state == RUN_STATE_STOPPED) {
             mutex_unlock(&executor->pool->mutex);
@@ -190,20 +225,25 @@ raw_p executor_run(raw_p arg) {
         }
 
         tasks_count = executor->pool->tasks_count;
+        bound = executor->pool->bound;
         mutex_unlock(&executor->pool->mutex);
 
         // process tasks
-        for (i = 0; i < tasks_count; i++) {
-            data = mpmc_pop(executor->pool->task_queue);
-
-            // Nothing to do
-            if (data.id == -1)
-                break;
-
-            // execute task
-            res = pool_call_task_fn(data.fn, data.argc, data.argv);
-            data.result = res;
-            mpmc_push(executor->pool->result_queue, data);
+        if (bound)
+            i = pool_execute_bound(executor->pool, executor->id + 1, tasks_count);
+        else {
+            for (i = 0; i < tasks_count; i++) {
+                data = mpmc_pop(executor->pool->task_queue);
+
+                // Nothing to do
+                if (data.id == -1)
+                    break;
+
+                // execute task
+                res = pool_call_task_fn(data.fn, data.argc, data.argv);
+                data.result = res;
+                mpmc_push(executor->pool->result_queue, data);
+            }
         }
 
         if (i > 0) {
@@ -230,6 +270,18 @@ pool_p pool_create(i64_t executors_count) {
     pool->tasks_count = 0;
     pool->task_queue = mpmc_create(DEFAULT_MPMC_SIZE);
     pool->result_queue = mpmc_create(DEFAULT_MPMC_SIZE);
+    pool->tasks = NULL;
+    pool->claims = NULL;
+    pool->bound = B8_FALSE;
+
+    // On a NUMA box tasks are bound to the threads. Every slot is taken until a run hands it out.
+    if (thread_numa_nodes() > 1) {
+        pool->tasks = (task_data_t *)heap_mmap(BOUND_TASKS_MAX * sizeof(task_data_t));
+        pool->claims = (i64_t *)heap_mmap(BOUND_TASKS_MAX * sizeof(i64_t));
+        for (i = 0; i < BOUND_TASKS_MAX; i++)
+            pool->claims[i] = 1;
+    }
+
     pool->state = RUN_STATE_RUNNING;
     pool->mutex = mutex_create();
     pool->run = cond_create();
@@ -249,6 +301,9 @@ pool_p pool_create(i64_t executors_count) {
     if (thread_pin(thread_self(), 0) != 0)
         printf("Pool create: failed to pin main thread\n");
 
+    if (pool->tasks != NULL)
+        heap_set_node(thread_cpu_node(0));
+
     mutex_unlock(&pool->mutex);
 
     // Now ensure that all threads are running
@@ -280,6 +335,11 @@ nil_t pool_destroy(pool_p pool) {
     mpmc_destroy(pool->task_queue);
     mpmc_destroy(pool->result_queue);
 
+    if (pool->tasks != NULL) {
+        heap_unmap(pool->tasks, BOUND_TASKS_MAX * sizeof(task_data_t));
+        heap_unmap(pool->claims, BOUND_TASKS_MAX * sizeof(i64_t));
+    }
+
     heap_unmap(pool, sizeof(struct pool_t) + sizeof(executor_t) * pool->executors_count);
 }
 
@@ -371,6 +431,18 @@ obj_p pool_run(pool_p pool) {
     tasks_count = pool->tasks_count;
     executors_count = pool->executors_count;
 
+    // lay the tasks out by id, a slot is handed out once its task is in place
+    pool->bound = (pool->tasks != NULL && tasks_count <= BOUND_TASKS_MAX);
+    if (pool->bound) {
+        for (i = 0; i < tasks_count; i++) {
+            data = mpmc_pop(pool->task_queue);
+            pool->tasks[data.id] = data;
+        }
+
+        for (i = 0; i < tasks_count; i++)
+            __atomic_store_n(&pool->claims[i], 0, __ATOMIC_RELEASE);
+    }
+
     // wake up needed executors
     if (executors_count < tasks_count) {
         for (i = 0; i < executors_count; i++)
@@ -381,17 +453,21 @@ obj_p pool_run(pool_p pool) {
     mutex_unlock(&pool->mutex);
 
     // process tasks on self too
-    for (i = 0; i < tasks_count; i++) {
-        data = mpmc_pop(pool->task_queue);
+    if (pool->bound)
+        i = pool_execute_bound(pool, 0, tasks_count);
+    else {
+        for (i = 0; i < tasks_count; i++) {
+            data = mpmc_pop(pool->task_queue);
 
-        // Nothing to do
-        if (data.id == -1)
-            break;
+            // Nothing to do
+            if (data.id == -1)
+                break;
 
-        // execute task
-        res = pool_call_task_fn(data.fn, data.argc, data.argv);
-        data.result = res;
-        mpmc_push(pool->result_queue, data);
+            // execute task
+            res = pool_call_task_fn(data.fn, data.argc, data.argv);
+            data.result = res;
+            mpmc_push(pool->result_queue, data);
+        }
     }
 
     mutex_lock(&pool->mutex);
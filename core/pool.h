@@ -89,6 +89,9 @@ typedef struct pool_t {
     i64_t tasks_count;       // Number of tasks
     mpmc_p task_queue;       // Pool's task queue
     mpmc_p result_queue;     // Pool's result queue
+    task_data_t *tasks;      // Tasks of the run by id, when they are bound to the threads (NUMA)
+    i64_t *claims;           // Whether a bound task is taken
+    b8_t bound;              // Whether the run goes through the bound tasks rather than the queue
     executor_t executors[];  // Array of executors
 } *pool_p;
 
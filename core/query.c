@@ -203,6 +203,84 @@ nil_t query_ctx_destroy(query_ctx_p ctx) {
     drop_obj(ctx->group_index);
 }
 
+// Marks the table columns an expression refers to
+static nil_t select_mark_refs(obj_p expr, obj_p keys, b8_t *mask) {
+    i64_t i, l, j;
+
+    switch (expr->type) {
+        case -TYPE_SYMBOL:
+            j = find_raw(keys, &expr->i64);
+            if (j != NULL_I64)
+                mask[j] = B8_TRUE;
+            return;
+        case TYPE_SYMBOL:
+            l = expr->len;
+            for (i = 0; i < l; i++) {
+                j = find_raw(keys, &AS_SYMBOL(expr)[i]);
+                if (j != NULL_I64)
+                    mask[j] = B8_TRUE;
+            }
+            return;
+        case TYPE_LIST:
+            l = expr->len;
+            for (i = 0; i < l; i++)
+                select_mark_refs(AS_LIST(expr)[i], keys, mask);
+            return;
+        case TYPE_DICT:
+            select_mark_refs(AS_LIST(expr)[1], keys, mask);
+            return;
+        default:
+            return;
+    }
+}
+
+// Hands the mapped columns the query refers to over to the loader, which reads them in (partition by
+// partition, in order) while the query computes over what is loaded already
+static nil_t select_prefetch(obj_p obj, query_ctx_p ctx) {
+    i64_t i, l, n;
+    b8_t all = B8_TRUE;
+    lit_p name;
+    obj_p cols, mask, col, v;
+
+    cols = AS_LIST(ctx->table)[1];
+    l = cols->len;
+
+    for (i = 0; i < l; i++) {
+        col = AS_LIST(cols)[i];
+        if (IS_EXTERNAL_SIMPLE(col) || IS_EXTERNAL_COMPOUND(col) ||
+            (col->type >= TYPE_PARTEDLIST && col->type <= TYPE_PARTEDENUM))
+            break;
+    }
+
+    if (i == l)
+        return;
+
+    mask = B8(l);
+    memset(AS_B8(mask), 0, l);
+
+    // with no fields to compute every column makes it into the result
+    n = AS_LIST(obj)[0]->len;
+    for (i = 0; i < n; i++) {
+        name = str_from_symbol(AS_SYMBOL(AS_LIST(obj)[0])[i]);
+        if (strcmp(name, "from") == 0 || strcmp(name, "take") == 0)
+            continue;
+
+        if (strcmp(name, "where") != 0 && strcmp(name, "by") != 0)
+            all = B8_FALSE;
+
+        v = at_idx(AS_LIST(obj)[1], i);
+        select_mark_refs(v, AS_LIST(ctx->table)[0], AS_B8(mask));
+        drop_obj(v);
+    }
+
+    for (i = 0; i < l; i++) {
+        if (all || AS_B8(mask)[i])
+            loader_prefetch(AS_LIST(cols)[i]);
+    }
+
+    drop_obj(mask);
+}
+
 obj_p select_fetch_table(obj_p obj, query_ctx_p ctx) {
     obj_p prm, val;
 
@@ -225,6 +303,8 @@ obj_p select_fetch_table(obj_p obj, query_ctx_p ctx) {
     ctx->tablen = AS_LIST(val)[0]->len;
     ctx->table = val;
 
+    select_prefetch(obj, ctx);
+
     prm = at_sym(obj, "take", 4);
 
     if (!is_null(prm)) {
@@ -40,6 +40,7 @@
 #include "time.h"
 #include "timestamp.h"
 #include "cmp.h"
+#include "join.h"
 
 RAYASSERT(sizeof(struct obj_t) == 16, rayforce_h)
 
@@ -123,6 +124,16 @@ obj_p nullv(i8_t type, i64_t len) {
         case TYPE_C8:
             memset(vec->raw, 0, len);
             break;
+        case TYPE_I16:
+            for (i = 0; i < len; i++)
+                AS_I16(vec)[i] = NULL_I16;
+            break;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            for (i = 0; i < len; i++)
+                AS_I32(vec)[i] = NULL_I32;
+            break;
         case TYPE_I64:
         case TYPE_SYMBOL:
         case TYPE_TIMESTAMP:
@@ -441,6 +452,21 @@ obj_p push_obj(obj_p* obj, obj_p val) {
             res = push_raw(obj, &val->f64);
             drop_obj(val);
             return res;
+        case MTYPE2(TYPE_I32, -TYPE_I32):
+        case MTYPE2(TYPE_DATE, -TYPE_DATE):
+        case MTYPE2(TYPE_TIME, -TYPE_TIME):
+            res = push_raw(obj, &val->i32);
+            drop_obj(val);
+            return res;
+        case MTYPE2(TYPE_I16, -TYPE_I16):
+            res = push_raw(obj, &val->i16);
+            drop_obj(val);
+            return res;
+        case MTYPE2(TYPE_B8, -TYPE_B8):
+        case MTYPE2(TYPE_U8, -TYPE_U8):
+            res = push_raw(obj, &val->u8);
+            drop_obj(val);
+            return res;
         case MTYPE2(TYPE_C8, -TYPE_C8):
             res = push_raw(obj, &val->c8);
             drop_obj(val);
@@ -476,11 +502,17 @@ obj_p append_list(obj_p* obj, obj_p vals) {
             res = resize_obj(obj, (*obj)->len + vals->len);
             memcpy((*obj)->raw + size1, AS_F64(vals), size2);
             return res;
+        case MTYPE2(TYPE_I32, TYPE_I32):
+        case MTYPE2(TYPE_DATE, TYPE_DATE):
+        case MTYPE2(TYPE_TIME, TYPE_TIME):
+        case MTYPE2(TYPE_I16, TYPE_I16):
+        case MTYPE2(TYPE_B8, TYPE_B8):
+        case MTYPE2(TYPE_U8, TYPE_U8):
         case MTYPE2(TYPE_C8, TYPE_C8):
             size1 = size_of(*obj) - sizeof(struct obj_t);
             size2 = size_of(vals) - sizeof(struct obj_t);
             res = resize_obj(obj, (*obj)->len + vals->len);
-            memcpy((*obj)->raw + size1, AS_C8(vals), size2);
+            memcpy((*obj)->raw + size1, vals->raw, size2);
             return res;
         case MTYPE2(TYPE_GUID, TYPE_GUID):
             size1 = size_of(*obj) - sizeof(struct obj_t);
@@ -2142,9 +2174,9 @@ obj_p cast_obj(i8_t type, obj_p obj) {
     obj_p v, res, err, msg;
     u8_t* g;
     i32_t num_i32;
-    i64_t i, l, num_i64;
+    i64_t i, l, num_i64, *lens;
     f64_t num_f64;
-    lit_p str;
+    lit_p str, *strs;
 
     // Do nothing if the type is the same
     if (type == obj->type)
@@ -2447,6 +2479,30 @@ obj_p cast_obj(i8_t type, obj_p obj) {
                 if (l == 0)
                     return vector(type, 0);
 
+                // A list of strings is interned in bulk
+                if (type == TYPE_SYMBOL) {
+                    for (i = 0; i < l; i++) {
+                        if (AS_LIST(obj)[i]->type != TYPE_C8)
+                            break;
+                    }
+
+                    if (i == l) {
+                        res = SYMBOL(l);
+                        strs = (lit_p*)heap_alloc(l * ISIZEOF(lit_p));
+                        lens = (i64_t*)heap_alloc(l * ISIZEOF(i64_t));
+                        for (i = 0; i < l; i++) {
+                            strs[i] = AS_C8(AS_LIST(obj)[i]);
+                            lens[i] = AS_LIST(obj)[i]->len;
+                        }
+
+                        symbols_intern_bulk(strs, lens, l, AS_SYMBOL(res));
+                        heap_free(strs);
+                        heap_free(lens);
+
+                        return res;
+                    }
+                }
+
                 v = cast_obj(-type, AS_LIST(obj)[0]);
                 if (IS_ERR(v))
                     return v;
@@ -2499,8 +2555,12 @@ nil_t __attribute__((hot)) drop_obj(obj_p obj) {
     } else
         rc = __atomic_sub_fetch(&obj->rc, 1, __ATOMIC_RELAXED);
 
-    if (rc > 0)
+    if (rc > 0) {
+        // the cached join sides may hold the last references of a table
+        if (obj->type == TYPE_TABLE && !__RC_SYNC)
+            join_sides_evict(obj, rc);
         return;
+    }
 
     switch (obj->type) {
         case TYPE_LIST:
@@ -2555,6 +2615,7 @@ nil_t __attribute__((hot)) drop_obj(obj_p obj) {
             drop_obj(AS_LAMBDA(obj)->args);
             drop_obj(AS_LAMBDA(obj)->body);
             drop_obj(AS_LAMBDA(obj)->nfo);
+            drop_obj(AS_LAMBDA(obj)->slots);
             heap_free(obj);
             return;
         case TYPE_NULL:
@@ -2611,6 +2672,8 @@ obj_p copy_obj(obj_p obj) {
         case TYPE_C8:
         case TYPE_I16:
         case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
         case TYPE_I64:
         case TYPE_SYMBOL:
         case TYPE_TIMESTAMP:
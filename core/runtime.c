@@ -132,6 +132,8 @@ runtime_p runtime_create(i32_t argc, str_p argv[]) {
     __RUNTIME->query_ctx = NULL;
     __RUNTIME->pool = NULL;
     __RUNTIME->dynlibs = I64(0);
+    __RUNTIME->loader = NULL;
+    __RUNTIME->joins = LIST(0);
 
     interpreter_create(0);
 
@@ -226,6 +228,7 @@ i32_t runtime_run(nil_t) {
 
 nil_t runtime_destroy(nil_t) {
     i64_t i, l;
+    obj_p joins;
     dynlib_p dl;
 
     drop_obj(__RUNTIME->args);
@@ -234,7 +237,15 @@ nil_t runtime_destroy(nil_t) {
     symbols_destroy(__RUNTIME->symbols);
     heap_unmap(__RUNTIME->symbols, sizeof(struct symbols_t));
     env_destroy(&__RUNTIME->env);
+    if (__RUNTIME->loader) {
+        loader_destroy(__RUNTIME->loader);
+        __RUNTIME->loader = NULL;
+    }
     drop_obj(__RUNTIME->fdmaps);
+    // the sides must not be looked up while they are dropped
+    joins = __RUNTIME->joins;
+    __RUNTIME->joins = NULL_OBJ;
+    drop_obj(joins);
     // destroy dynamic libraries
     l = __RUNTIME->dynlibs->len;
     for (i = 0; i < l; i++) {
@@ -34,6 +34,7 @@
 #include "sys.h"
 #include "query.h"
 #include "thread.h"
+#include "loader.h"
 
 /*
  * Runtime structure.
@@ -48,6 +49,8 @@ typedef struct runtime_t {
     query_ctx_p query_ctx;  // Query context stack.
     pool_p pool;            // Executors pool.
     obj_p dynlibs;          // Dynamic libraries.
+    loader_p loader;        // Readahead of mapped columns, started on the first use.
+    obj_p joins;            // Sorted right sides of asof/window joins, reused while the table is alive.
 } *runtime_p;
 
 extern runtime_p __RUNTIME;
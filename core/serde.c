@@ -23,6 +23,7 @@
 
 #include "serde.h"
 #include "symbols.h"
+#include "heap.h"
 #include "string.h"
 #include "lambda.h"
 #include "env.h"
@@ -358,8 +359,9 @@ obj_p ser_obj(obj_p obj) {
 
 obj_p de_raw(u8_t *buf, i64_t *len) {
     i8_t code;
-    i64_t i, l, c, id;
+    i64_t i, l, c;
     obj_p obj, k, v;
+    lit_p *strs;
     i8_t type;
 
     if (*len == 0)
@@ -543,23 +545,28 @@ obj_p de_raw(u8_t *buf, i64_t *len) {
                     obj = SYMBOL(l);
                     if (IS_ERR(obj))
                         return obj;
+                    // Collect the strings first and intern them in bulk
+                    strs = (lit_p *)heap_alloc(l * ISIZEOF(lit_p) + 1);
                     for (i = 0; i < l; i++) {
                         if (*len < 1) {
-                            obj->len = i;
+                            heap_free(strs);
+                            obj->len = 0;
                             drop_obj(obj);
                             return error_str(ERR_IO, "de_raw: buffer underflow");
                         }
                         c = str_len((str_p)buf, *len);
                         if (c >= *len) {
-                            obj->len = i;
+                            heap_free(strs);
+                            obj->len = 0;
                             drop_obj(obj);
                             return error_str(ERR_IO, "de_raw: invalid symbol length");
                         }
-                        id = symbols_intern((str_p)buf, c);
-                        AS_SYMBOL(obj)[i] = id;
+                        strs[i] = (lit_p)buf;
                         buf += c + 1;
                         (*len) -= c + 1;
                     }
+                    symbols_intern_bulk(strs, NULL, l, AS_SYMBOL(obj));
+                    heap_free(strs);
                     return obj;
                 case TYPE_GUID:
                     if (*len < l * ISIZEOF(guid_t))
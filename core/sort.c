@@ -26,6 +26,9 @@
 #include "ops.h"
 #include "error.h"
 #include "symbols.h"
+#include "pool.h"
+#include "items.h"
+#include "runtime.h"
 
 // Maximum range for counting sort - configurable constant
 #define COUNTING_SORT_MAX_RANGE 1000000
@@ -36,6 +39,7 @@ typedef i64_t (*compare_func_t)(obj_p vec, i64_t idx_i, i64_t idx_j);
 // Forward declarations for optimized sorting functions
 static obj_p ray_iasc_optimized(obj_p x);
 static obj_p ray_idesc_optimized(obj_p x);
+static obj_p counting_sort_i64(obj_p vec, i64_t asc);
 
 static i64_t compare_symbols(obj_p vec, i64_t idx_i, i64_t idx_j) {
     i64_t sym_i = AS_I64(vec)[idx_i];
@@ -261,121 +265,355 @@ static inline u64_t f64_to_sortable_u64(f64_t value) {
     return u.u;
 }
 
-obj_p ray_sort_asc_i64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i64_t* iv = AS_I64(vec);
-    i64_t* t = AS_I64(temp);
+// LSD radix sort of u64 keys carrying row ids, parallel over the pool
 
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
 
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        pos1[(u & 0xffff) + 1]++;
-        pos2[((u >> 16) & 0xffff) + 1]++;
-        pos3[((u >> 32) & 0xffff) + 1]++;
-        pos4[(u >> 48) + 1]++;
-    }
+static i64_t radix_chunk_size(i64_t len, i64_t n) {
+    i64_t chunk, elems_per_page;
 
-    // Calculate cumulative positions for each pass
-    for (i = 2; i <= 65536; i++) {
-        pos1[i] += pos1[i - 1];
-        pos2[i] += pos2[i - 1];
-        pos3[i] += pos3[i - 1];
-        pos4[i] += pos4[i - 1];
-    }
+    elems_per_page = RAY_PAGE_SIZE / sizeof(u64_t);
+    chunk = (len + n - 1) / n;
 
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        t[pos1[u & 0xffff]++] = i;
+    return ((chunk + elems_per_page - 1) / elems_per_page) * elems_per_page;
+}
+
+static obj_p radix_hist_partial(u64_t* keys, i64_t from, i64_t to, i64_t shift, i64_t* hist) {
+    i64_t i;
+
+    memset(hist, 0, RADIX_SIZE * sizeof(i64_t));
+    for (i = from; i < to; i++)
+        hist[(keys[i] >> shift) & RADIX_MASK]++;
+
+    return NULL_OBJ;
+}
+
+static obj_p radix_scatter_partial(u64_t* src, i64_t* isrc, u64_t* dst, i64_t* idst, i64_t from, i64_t to,
+                                   i64_t shift, i64_t* offs) {
+    i64_t i, p;
+    u64_t k;
+
+    if (isrc == NULL) {
+        for (i = from; i < to; i++) {
+            k = src[i];
+            p = offs[(k >> shift) & RADIX_MASK]++;
+            dst[p] = k;
+            idst[p] = i;
+        }
+    } else {
+        for (i = from; i < to; i++) {
+            k = src[i];
+            p = offs[(k >> shift) & RADIX_MASK]++;
+            dst[p] = k;
+            idst[p] = isrc[i];
+        }
     }
 
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos2[(u >> 16) & 0xffff]++] = t[i];
+    return NULL_OBJ;
+}
+
+// Sorts keys ascending by their lower `bits` bits (stable), returns the permutation.
+// Digits which are the same for every key are skipped. The keys are clobbered.
+obj_p radix_sort_u64(obj_p keys, i64_t bits) {
+    i64_t i, j, d, n, len, chunk, shift, sum, *hist, *isrc, *idst, *ibuf[2];
+    u64_t *src, *dst, *t;
+    obj_p idx, tidx, tkeys, v;
+    pool_p pool;
+
+    len = keys->len;
+    if (len == 0)
+        return I64(0);
+
+    pool = pool_get();
+    n = pool_split_by(pool, len, 0);
+    chunk = radix_chunk_size(len, n);
+    n = (len + chunk - 1) / chunk;
+
+    idx = I64(len);
+    tidx = I64(len);
+    tkeys = I64(len);
+    hist = (i64_t*)heap_alloc(n * RADIX_SIZE * sizeof(i64_t));
+
+    src = (u64_t*)AS_I64(keys);
+    dst = (u64_t*)AS_I64(tkeys);
+    ibuf[0] = AS_I64(idx);
+    ibuf[1] = AS_I64(tidx);
+    isrc = NULL;
+    idst = ibuf[0];
+
+    for (shift = 0; shift < bits; shift += RADIX_BITS) {
+        if (n > 1) {
+            pool_prepare(pool);
+            for (i = 0; i < n; i++)
+                pool_add_task(pool, (raw_p)radix_hist_partial, 5, src, i * chunk,
+                              ((i + 1) * chunk < len) ? (i + 1) * chunk : len, shift, hist + i * RADIX_SIZE);
+            v = pool_run(pool);
+            drop_obj(v);
+        } else
+            radix_hist_partial(src, 0, len, shift, hist);
+
+        // Exclusive prefix sums (digit major, chunk minor keeps the pass stable)
+        for (d = 0, sum = 0; d < RADIX_SIZE; d++) {
+            j = sum;
+            for (i = 0; i < n; i++) {
+                j += hist[i * RADIX_SIZE + d];
+                hist[i * RADIX_SIZE + d] = j - hist[i * RADIX_SIZE + d];
+            }
+
+            // All the keys share this digit: the pass would not change the order
+            if (j - sum == len)
+                break;
+
+            sum = j;
+        }
+
+        if (d < RADIX_SIZE)
+            continue;
+
+        if (n > 1) {
+            pool_prepare(pool);
+            for (i = 0; i < n; i++)
+                pool_add_task(pool, (raw_p)radix_scatter_partial, 8, src, isrc, dst, idst, i * chunk,
+                              ((i + 1) * chunk < len) ? (i + 1) * chunk : len, shift, hist + i * RADIX_SIZE);
+            v = pool_run(pool);
+            drop_obj(v);
+        } else
+            radix_scatter_partial(src, isrc, dst, idst, 0, len, shift, hist);
+
+        t = src;
+        src = dst;
+        dst = t;
+        isrc = idst;
+        idst = (idst == ibuf[0]) ? ibuf[1] : ibuf[0];
     }
 
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[ov[i]] ^ 0x8000000000000000ULL;
-        t[pos3[(u >> 32) & 0xffff]++] = ov[i];
+    heap_free(hist);
+    drop_obj(tkeys);
+
+    // Every digit was constant: the identity permutation
+    if (isrc == NULL) {
+        for (i = 0; i < len; i++)
+            ibuf[0][i] = i;
+        isrc = ibuf[0];
     }
 
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos4[u >> 48]++] = t[i];
+    if (isrc == ibuf[0]) {
+        drop_obj(tidx);
+        return idx;
     }
 
-    drop_obj(temp);
-    return indices;
+    drop_obj(idx);
+    return tidx;
 }
 
-obj_p ray_sort_asc_f64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    f64_t* fv = AS_F64(vec);
-    i64_t* t = AS_I64(temp);
+// Maps a row of a key column into an unsigned integer with the same ordering
+static inline u64_t sort_key_raw(obj_p col, i64_t i) {
+    switch (col->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+            return AS_U8(col)[i];
+        case TYPE_I16:
+            return (u16_t)AS_I16(col)[i] ^ 0x8000u;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            return (u32_t)AS_I32(col)[i] ^ 0x80000000u;
+        case TYPE_F64:
+            return f64_to_sortable_u64(AS_F64(col)[i]);
+        default:
+            return (u64_t)AS_I64(col)[i] ^ 0x8000000000000000ull;
+    }
+}
 
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
+static obj_p radix_keys_partial(obj_p vec, i64_t asc, u64_t* keys, i64_t from, i64_t to, u64_t* scope) {
+    i64_t i;
+    u64_t u, lo, hi;
 
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
+    lo = UINT64_MAX;
+    hi = 0;
 
-        pos1[(u & 0xffff) + 1]++;
-        pos2[((u >> 16) & 0xffff) + 1]++;
-        pos3[((u >> 32) & 0xffff) + 1]++;
-        pos4[(u >> 48) + 1]++;
+    for (i = from; i < to; i++) {
+        u = sort_key_raw(vec, i);
+        u = (asc > 0) ? u : ~u;
+        keys[i] = u;
+        lo = (u < lo) ? u : lo;
+        hi = (u > hi) ? u : hi;
     }
 
-    // Calculate cumulative positions for each pass
-    for (i = 2; i <= 65536; i++) {
-        pos1[i] += pos1[i - 1];
-        pos2[i] += pos2[i - 1];
-        pos3[i] += pos3[i - 1];
-        pos4[i] += pos4[i - 1];
-    }
+    scope[0] = lo;
+    scope[1] = hi;
 
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        t[pos1[u & 0xffff]++] = i;
+    return NULL_OBJ;
+}
+
+// Key + payload radix sort of a 64-bit vector: only the bits below the highest
+// bit where the smallest and the largest keys differ take part in the passes.
+static obj_p radix_sort_vec(obj_p vec, i64_t asc) {
+    i64_t i, n, len, chunk;
+    u64_t lo, hi, *scope;
+    obj_p keys, idx, v;
+    pool_p pool;
+
+    len = vec->len;
+    if (len == 0)
+        return I64(0);
+
+    keys = I64(len);
+    pool = pool_get();
+    n = pool_split_by(pool, len, 0);
+    chunk = radix_chunk_size(len, n);
+    n = (len + chunk - 1) / chunk;
+    scope = (u64_t*)heap_alloc(n * 2 * sizeof(u64_t));
+
+    if (n > 1) {
+        pool_prepare(pool);
+        for (i = 0; i < n; i++)
+            pool_add_task(pool, (raw_p)radix_keys_partial, 6, vec, asc, AS_I64(keys), i * chunk,
+                          ((i + 1) * chunk < len) ? (i + 1) * chunk : len, scope + i * 2);
+        v = pool_run(pool);
+        drop_obj(v);
+    } else
+        radix_keys_partial(vec, asc, (u64_t*)AS_I64(keys), 0, len, scope);
+
+    lo = scope[0];
+    hi = scope[1];
+    for (i = 1; i < n; i++) {
+        lo = (scope[i * 2] < lo) ? scope[i * 2] : lo;
+        hi = (scope[i * 2 + 1] > hi) ? scope[i * 2 + 1] : hi;
     }
 
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos2[(u >> 16) & 0xffff]++] = t[i];
+    heap_free(scope);
+
+    idx = radix_sort_u64(keys, (lo == hi) ? 0 : 64 - __builtin_clzll(lo ^ hi));
+    drop_obj(keys);
+
+    return idx;
+}
+
+obj_p ray_sort_asc_i64(obj_p vec) { return radix_sort_vec(vec, 1); }
+
+obj_p ray_sort_asc_f64(obj_p vec) { return radix_sort_vec(vec, 1); }
+
+// Replaces symbols with their ranks in the lexical order of the symbol pool, squeezed into the
+// dense ranks of the column when they span a range no wider than the column. NULL_OBJ if a symbol
+// is not ranked yet (interned in a parallel section)
+static obj_p sort_symbol_ranks(obj_p col) {
+    i64_t i, r, l, lo, hi, *syms, *ranks, *dense;
+    obj_p map, res;
+
+    symbols_rank(runtime_get()->symbols);
+
+    l = col->len;
+    res = I64(l);
+    syms = AS_SYMBOL(col);
+    ranks = AS_I64(res);
+    lo = INT64_MAX;
+    hi = 0;
+
+    for (i = 0; i < l; i++) {
+        ranks[i] = SYMBOL_RANK(syms[i]);
+        if (ranks[i] == 0 && syms[i] != NULL_I64) {
+            drop_obj(res);
+            return NULL_OBJ;
+        }
+        lo = (ranks[i] < lo) ? ranks[i] : lo;
+        hi = (ranks[i] > hi) ? ranks[i] : hi;
     }
 
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[ov[i]]);
-        t[pos3[(u >> 32) & 0xffff]++] = ov[i];
+    if (l == 0 || hi - lo >= l)
+        return res;
+
+    map = I64(hi - lo + 1);
+    dense = AS_I64(map);
+    memset(dense, 0, (hi - lo + 1) * sizeof(i64_t));
+
+    for (i = 0; i < l; i++)
+        dense[ranks[i] - lo] = 1;
+
+    for (i = 0, r = 0; i <= hi - lo; i++)
+        dense[i] = (dense[i] == 0) ? r : r++;
+
+    for (i = 0; i < l; i++)
+        ranks[i] = dense[ranks[i] - lo];
+
+    drop_obj(map);
+
+    return res;
+}
+
+static obj_p sort_symbol(obj_p vec, i64_t asc) {
+    obj_p ranks, res;
+
+    ranks = sort_symbol_ranks(vec);
+    if (ranks == NULL_OBJ)
+        return mergesort_generic_obj(vec, asc);
+
+    res = counting_sort_i64(ranks, asc);
+    if (res == NULL)
+        res = radix_sort_vec(ranks, asc);
+
+    drop_obj(ranks);
+
+    return res;
+}
+
+// Replaces the codes of an enum with the ranks of their symbols, so only the dictionary is
+// sorted by strings. Codes outside the dictionary rank first, as null symbols do
+static obj_p sort_enum_ranks(obj_p col) {
+    i64_t i, n, l, *codes, *ids, *ranks, *out;
+    obj_p sym, idx, rank, res;
+
+    l = ops_count(col);
+    codes = AS_I64(ENUM_VAL(col));
+    res = I64(l);
+    out = AS_I64(res);
+
+    sym = enum_domain(col);
+    if (is_null(sym)) {
+        memcpy(out, codes, l * sizeof(i64_t));
+        return res;
     }
 
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos4[u >> 48]++] = t[i];
+    n = sym->len;
+    idx = ray_sort_asc(sym);
+    drop_obj(sym);
+    if (IS_ERR(idx)) {
+        drop_obj(res);
+        return idx;
     }
 
-    drop_obj(temp);
-    return indices;
+    rank = I64(n);
+    ids = AS_I64(idx);
+    ranks = AS_I64(rank);
+    for (i = 0; i < n; i++)
+        ranks[ids[i]] = i + 1;
+
+    for (i = 0; i < l; i++)
+        out[i] = ((u64_t)codes[i] < (u64_t)n) ? ranks[codes[i]] : 0;
+
+    drop_obj(idx);
+    drop_obj(rank);
+
+    return res;
+}
+
+static obj_p sort_enum(obj_p vec, i64_t asc) {
+    obj_p ranks, res;
+
+    ranks = sort_enum_ranks(vec);
+    if (IS_ERR(ranks))
+        return ranks;
+
+    res = counting_sort_i64(ranks, asc);
+    if (res == NULL)
+        res = radix_sort_vec(ranks, asc);
+
+    drop_obj(ranks);
+
+    return res;
 }
 
 obj_p ray_sort_asc(obj_p vec) {
@@ -421,6 +659,8 @@ obj_p ray_sort_asc(obj_p vec) {
         case TYPE_SYMBOL:
             // Use optimized sorting
             return ray_iasc_optimized(vec);
+        case TYPE_ENUM:
+            return sort_enum(vec, 1);
         case TYPE_LIST:
             return mergesort_generic_obj(vec, 1);
         case TYPE_DICT:
@@ -503,109 +743,9 @@ obj_p ray_sort_desc_i32(obj_p vec) {
     return indices;
 }
 
-obj_p ray_sort_desc_i64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i64_t* iv = AS_I64(vec);
-    i64_t* t = AS_I64(temp);
-
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
-
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;  // invert bits for descending order
-        pos1[u & 0xffff]++;
-        pos2[(u >> 16) & 0xffff]++;
-        pos3[(u >> 32) & 0xffff]++;
-        pos4[u >> 48]++;
-    }
-    for (i = 65534; i >= 0; i--) {
-        pos1[i] += pos1[i + 1];
-        pos2[i] += pos2[i + 1];
-        pos3[i] += pos3[i + 1];
-        pos4[i] += pos4[i + 1];
-    }
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        t[pos1[(u & 0xffff) + 1]++] = i;
-    }
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos2[((u >> 16) & 0xffff) + 1]++] = t[i];
-    }
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[ov[i]] ^ 0x8000000000000000ULL;
-        t[pos3[((u >> 32) & 0xffff) + 1]++] = ov[i];
-    }
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos4[(u >> 48) + 1]++] = t[i];
-    }
-
-    drop_obj(temp);
-    return indices;
-}
-
-obj_p ray_sort_desc_f64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    f64_t* fv = AS_F64(vec);
-    i64_t* t = AS_I64(temp);
-
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
-
-    // Count occurrences for each 16-bit chunk (descending)
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        pos1[u & 0xffff]++;
-        pos2[(u >> 16) & 0xffff]++;
-        pos3[(u >> 32) & 0xffff]++;
-        pos4[u >> 48]++;
-    }
-    for (i = 65534; i >= 0; i--) {
-        pos1[i] += pos1[i + 1];
-        pos2[i] += pos2[i + 1];
-        pos3[i] += pos3[i + 1];
-        pos4[i] += pos4[i + 1];
-    }
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        t[pos1[(u & 0xffff) + 1]++] = i;
-    }
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos2[((u >> 16) & 0xffff) + 1]++] = t[i];
-    }
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[ov[i]]);
-        t[pos3[((u >> 32) & 0xffff) + 1]++] = ov[i];
-    }
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos4[(u >> 48) + 1]++] = t[i];
-    }
+obj_p ray_sort_desc_i64(obj_p vec) { return radix_sort_vec(vec, -1); }
 
-    drop_obj(temp);
-    return indices;
-}
+obj_p ray_sort_desc_f64(obj_p vec) { return radix_sort_vec(vec, -1); }
 
 obj_p ray_sort_desc(obj_p vec) {
     i64_t i, len = vec->len;
@@ -650,6 +790,8 @@ obj_p ray_sort_desc(obj_p vec) {
         case TYPE_SYMBOL:
             // Use optimized sorting
             return ray_idesc_optimized(vec);
+        case TYPE_ENUM:
+            return sort_enum(vec, -1);
         case TYPE_LIST:
             return mergesort_generic_obj(vec, -1);
         case TYPE_DICT:
@@ -738,64 +880,39 @@ static obj_p counting_sort_i64(obj_p vec, i64_t asc) {
     if (range > len || range > COUNTING_SORT_MAX_RANGE)
         return NULL;  // Fall back to other sorting
 
-    // Allocate counting array
+    // Count occurrences, then turn counts into starting offsets of each value
     i64_t* counts = (i64_t*)heap_alloc(range * sizeof(i64_t));
     if (!counts)
         return NULL;
     memset(counts, 0, range * sizeof(i64_t));
 
-    // Create buckets to store indices for each symbol
-    i64_t** buckets = (i64_t**)heap_alloc(range * sizeof(i64_t*));
-    if (!buckets) {
-        heap_free(counts);
-        return NULL;
-    }
-
-    // Count occurrences and allocate buckets
     for (i64_t i = 0; i < len; i++)
         counts[data[i] - min_sym]++;
 
-    // Allocate memory for each bucket
-    for (i64_t i = 0; i < range; i++)
-        buckets[i] = (counts[i] > 0) ? (i64_t*)heap_alloc(counts[i] * sizeof(i64_t)) : NULL;
-
-    // Reset counts to use as bucket indices
-    memset(counts, 0, range * sizeof(i64_t));
-
-    // Fill buckets with indices
-    for (i64_t i = 0; i < len; i++) {
-        i64_t bucket_idx = data[i] - min_sym;
-        buckets[bucket_idx][counts[bucket_idx]++] = i;
-    }
-
-    // Create result indices array
-    obj_p indices = I64(len);
-    i64_t* result = AS_I64(indices);
-    i64_t pos = 0;
-
+    i64_t pos = 0, count;
     if (asc > 0) {
-        // Ascending: iterate symbols from min to max
+        // Ascending: offsets run from min to max
         for (i64_t sym = 0; sym < range; sym++) {
-            i64_t count = counts[sym];
-            for (i64_t i = 0; i < count; i++) {
-                result[pos++] = buckets[sym][i];
-            }
+            count = counts[sym];
+            counts[sym] = pos;
+            pos += count;
         }
     } else {
-        // Descending: iterate symbols from max to min
+        // Descending: offsets run from max to min
         for (i64_t sym = range - 1; sym >= 0; sym--) {
-            i64_t count = counts[sym];
-            for (i64_t i = 0; i < count; i++) {
-                result[pos++] = buckets[sym][i];
-            }
+            count = counts[sym];
+            counts[sym] = pos;
+            pos += count;
         }
     }
 
-    // Cleanup buckets
-    for (i64_t i = 0; i < range; i++)
-        heap_free(buckets[i]);
+    // Scatter indices straight into the result (stable)
+    obj_p indices = I64(len);
+    i64_t* result = AS_I64(indices);
+
+    for (i64_t i = 0; i < len; i++)
+        result[counts[data[i] - min_sym]++] = i;
 
-    heap_free(buckets);
     heap_free(counts);
     return indices;
 }
@@ -830,15 +947,16 @@ static obj_p optimized_sort(obj_p vec, i64_t asc) {
         }
     }
 
-    // For larger arrays: try counting sort first for integer types
+    // For larger arrays: try counting sort first for integer types, symbols are sorted by their ranks
     switch (vec->type) {
         case TYPE_I64:
         case TYPE_TIME:
-        case TYPE_SYMBOL:
             res = counting_sort_i64(vec, asc);
             if (res)
                 return res;
             break;
+        case TYPE_SYMBOL:
+            return sort_symbol(vec, asc);
         default:
             break;
     }
@@ -850,3 +968,306 @@ static obj_p optimized_sort(obj_p vec, i64_t asc) {
 // Optimized sorting functions
 static obj_p ray_iasc_optimized(obj_p x) { return optimized_sort(x, 1); }
 static obj_p ray_idesc_optimized(obj_p x) { return optimized_sort(x, -1); }
+
+
+// Multi-key sort: every key column is normalized into an order preserving unsigned
+// integer of minimal width, the widths are packed into a single u64 per row and the
+// packed keys are sorted with one (parallel) LSD radix sort carrying row ids.
+
+static obj_p sort_pack_partial(obj_p cols, i64_t* bits, u64_t* base, i64_t asc, u64_t* keys, i64_t from, i64_t to) {
+    i64_t c, i, n;
+    obj_p col;
+
+    n = cols->len;
+    memset(keys + from, 0, (to - from) * sizeof(u64_t));
+
+    for (c = 0; c < n; c++) {
+        if (bits[c] == 0)
+            continue;
+
+        col = AS_LIST(cols)[c];
+
+        // a column spanning all the 64 bits is packed alone: its keys are assigned, a 64-bit shift is undefined
+        if (bits[c] == 64) {
+            if (asc > 0) {
+                for (i = from; i < to; i++)
+                    keys[i] = sort_key_raw(col, i) - base[c];
+            } else {
+                for (i = from; i < to; i++)
+                    keys[i] = base[c] - sort_key_raw(col, i);
+            }
+
+            continue;
+        }
+
+        if (asc > 0) {
+            for (i = from; i < to; i++)
+                keys[i] = (keys[i] << bits[c]) | (sort_key_raw(col, i) - base[c]);
+        } else {
+            for (i = from; i < to; i++)
+                keys[i] = (keys[i] << bits[c]) | (base[c] - sort_key_raw(col, i));
+        }
+    }
+
+    return NULL_OBJ;
+}
+
+// Packs key columns (first column is the most significant) into one u64 per row.
+// Returns NULL if the keys can not be packed into 64 bits.
+static obj_p sort_pack_keys(obj_p keys, i64_t asc, i64_t* width) {
+    i64_t c, i, n, l, total, chunk, tasks, *bits;
+    u64_t u, lo, hi, *base;
+    obj_p cols, col, packed, v;
+    pool_p pool;
+
+    n = keys->len;
+    if (n == 0)
+        return NULL;
+
+    l = ops_count(AS_LIST(keys)[0]);
+    cols = LIST(n);
+    bits = (i64_t*)heap_alloc(n * sizeof(i64_t));
+    base = (u64_t*)heap_alloc(n * sizeof(u64_t));
+    total = 0;
+
+    for (c = 0; c < n; c++) {
+        col = AS_LIST(keys)[c];
+
+        switch (col->type) {
+            case TYPE_B8:
+            case TYPE_U8:
+            case TYPE_C8:
+            case TYPE_I16:
+            case TYPE_I32:
+            case TYPE_DATE:
+            case TYPE_TIME:
+            case TYPE_I64:
+            case TYPE_TIMESTAMP:
+            case TYPE_F64:
+                col = clone_obj(col);
+                break;
+            case TYPE_SYMBOL:
+                col = sort_symbol_ranks(col);
+                break;
+            case TYPE_ENUM:
+                col = sort_enum_ranks(col);
+                break;
+            default:
+                col = NULL_OBJ;
+                break;
+        }
+
+        AS_LIST(cols)[c] = col;
+
+        if (col == NULL_OBJ || IS_ERR(col) || col->len != l) {
+            total = 65;
+            break;
+        }
+
+        lo = UINT64_MAX;
+        hi = 0;
+        for (i = 0; i < l; i++) {
+            u = sort_key_raw(col, i);
+            lo = (u < lo) ? u : lo;
+            hi = (u > hi) ? u : hi;
+        }
+
+        base[c] = (asc > 0) ? lo : hi;
+        bits[c] = (l == 0 || hi == lo) ? 0 : 64 - __builtin_clzll(hi - lo);
+        total += bits[c];
+
+        if (total > 64)
+            break;
+    }
+
+    if (total > 64) {
+        cols->len = (c < n) ? c + 1 : n;
+        drop_obj(cols);
+        heap_free(bits);
+        heap_free(base);
+        return NULL;
+    }
+
+    packed = I64(l);
+    pool = pool_get();
+    tasks = pool_split_by(pool, l, 0);
+
+    if (tasks > 1) {
+        chunk = radix_chunk_size(l, tasks);
+        pool_prepare(pool);
+        for (i = 0; i < l; i += chunk)
+            pool_add_task(pool, (raw_p)sort_pack_partial, 7, cols, bits, base, asc, AS_I64(packed), i,
+                          (i + chunk < l) ? i + chunk : l);
+        v = pool_run(pool);
+        drop_obj(v);
+    } else
+        sort_pack_partial(cols, bits, base, asc, (u64_t*)AS_I64(packed), 0, l);
+
+    drop_obj(cols);
+    heap_free(bits);
+    heap_free(base);
+
+    *width = total;
+
+    return packed;
+}
+
+// Sorts rows by several key columns at once (first column is the most significant).
+// Returns NULL if the keys can not be packed into 64 bits, so the caller falls back
+// to the column by column stable sort.
+obj_p sort_multi_packed(obj_p keys, i64_t asc) {
+    i64_t bits;
+    obj_p packed, idx;
+
+    packed = sort_pack_keys(keys, asc, &bits);
+    if (packed == NULL)
+        return NULL;
+
+    idx = radix_sort_u64(packed, bits);
+    drop_obj(packed);
+
+    return idx;
+}
+
+// Top-k: bounded max-heaps of (key, row) pairs, the row breaks ties so the
+// selection matches a stable sort followed by take.
+
+static inline b8_t topk_less(u64_t ka, i64_t ra, u64_t kb, i64_t rb) { return ka < kb || (ka == kb && ra < rb); }
+
+static nil_t topk_sift_down(u64_t* hk, i64_t* hr, i64_t m, i64_t j) {
+    i64_t c, r;
+    u64_t k;
+
+    k = hk[j];
+    r = hr[j];
+
+    for (;;) {
+        c = 2 * j + 1;
+        if (c >= m)
+            break;
+        if (c + 1 < m && topk_less(hk[c], hr[c], hk[c + 1], hr[c + 1]))
+            c++;
+        if (!topk_less(k, r, hk[c], hr[c]))
+            break;
+        hk[j] = hk[c];
+        hr[j] = hr[c];
+        j = c;
+    }
+
+    hk[j] = k;
+    hr[j] = r;
+}
+
+static i64_t topk_push(u64_t* hk, i64_t* hr, i64_t m, i64_t k, u64_t key, i64_t row) {
+    i64_t j, p;
+
+    if (m < k) {
+        for (j = m; j > 0; j = p) {
+            p = (j - 1) / 2;
+            if (!topk_less(hk[p], hr[p], key, row))
+                break;
+            hk[j] = hk[p];
+            hr[j] = hr[p];
+        }
+        hk[j] = key;
+        hr[j] = row;
+        return m + 1;
+    }
+
+    if (topk_less(key, row, hk[0], hr[0])) {
+        hk[0] = key;
+        hr[0] = row;
+        topk_sift_down(hk, hr, m, 0);
+    }
+
+    return m;
+}
+
+static obj_p topk_partial(u64_t* keys, i64_t from, i64_t to, i64_t k, u64_t* hk, i64_t* hr) {
+    i64_t i, m;
+
+    for (i = from, m = 0; i < to; i++)
+        m = topk_push(hk, hr, m, k, keys[i], i);
+
+    return i64(m);
+}
+
+// Row ids of the k smallest packed keys, in sorted order
+static obj_p topk_u64(obj_p keys, i64_t k) {
+    i64_t i, j, n, m, len, chunk, *hr, *cnt;
+    u64_t *hk, *ck;
+    obj_p ids, heap, parts, res;
+    pool_p pool;
+
+    len = keys->len;
+    pool = pool_get();
+    n = pool_split_by(pool, len, 0);
+    chunk = radix_chunk_size(len, n);
+    n = (len + chunk - 1) / chunk;
+
+    // one heap per chunk, the last slot is the merged one
+    heap = I64((n + 1) * k);
+    ids = I64((n + 1) * k);
+    hk = (u64_t*)AS_I64(heap);
+    hr = AS_I64(ids);
+    cnt = (i64_t*)heap_alloc(n * sizeof(i64_t));
+
+    if (n > 1) {
+        pool_prepare(pool);
+        for (i = 0; i < n; i++)
+            pool_add_task(pool, (raw_p)topk_partial, 6, AS_I64(keys), i * chunk,
+                          ((i + 1) * chunk < len) ? (i + 1) * chunk : len, k, hk + i * k, hr + i * k);
+        parts = pool_run(pool);
+        for (i = 0; i < n; i++)
+            cnt[i] = AS_LIST(parts)[i]->i64;
+        drop_obj(parts);
+    } else {
+        parts = topk_partial((u64_t*)AS_I64(keys), 0, len, k, hk, hr);
+        cnt[0] = parts->i64;
+        drop_obj(parts);
+    }
+
+    // merge candidates of every chunk
+    ck = hk + n * k;
+    for (i = 0, m = 0; i < n; i++)
+        for (j = 0; j < cnt[i]; j++)
+            m = topk_push(ck, hr + n * k, m, k, hk[i * k + j], hr[i * k + j]);
+
+    heap_free(cnt);
+
+    // pop the maximum into the tail: ascending order
+    res = I64(m);
+    for (j = m; j > 0; j--) {
+        AS_I64(res)[j - 1] = hr[n * k];
+        ck[0] = ck[j - 1];
+        hr[n * k] = hr[n * k + j - 1];
+        topk_sift_down(ck, hr + n * k, j - 1, 0);
+    }
+
+    drop_obj(heap);
+    drop_obj(ids);
+
+    return res;
+}
+
+// Row ids of the first k rows of the sort by several key columns, without sorting
+// the rest. Returns NULL if the keys can not be packed into 64 bits.
+obj_p sort_multi_topk(obj_p keys, i64_t asc, i64_t k) {
+    i64_t bits;
+    obj_p packed, idx;
+
+    packed = sort_pack_keys(keys, asc, &bits);
+    if (packed == NULL)
+        return NULL;
+
+    // A large k is cheaper to get from the full sort
+    if (k * 8 >= packed->len) {
+        idx = radix_sort_u64(packed, bits);
+        resize_obj(&idx, k);
+    } else
+        idx = topk_u64(packed, k);
+
+    drop_obj(packed);
+
+    return idx;
+}
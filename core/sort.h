@@ -32,4 +32,13 @@ obj_p ray_sort_desc(obj_p vec);
 // Internal merge sort function
 obj_p mergesort_generic_obj(obj_p vec, i64_t asc);
 
+// Radix sort of packed u64 keys, returns the permutation
+obj_p radix_sort_u64(obj_p keys, i64_t bits);
+
+// Multi-key sort over a list of columns, NULL if the keys do not fit into 64 bits
+obj_p sort_multi_packed(obj_p keys, i64_t asc);
+
+// First k rows of the multi-key sort order, NULL if the keys do not fit into 64 bits
+obj_p sort_multi_topk(obj_p keys, i64_t asc, i64_t k);
+
 #endif  // SORT_H
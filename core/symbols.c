@@ -32,14 +32,23 @@
 #include "util.h"
 #include "runtime.h"
 #include "atomic.h"
+#include "pool.h"
+#include "mmap.h"
+#include "fs.h"
+#include "ops.h"
+#include "sort.h"
 
+#define SYMBOLS_IMAGE_PAGES(x) (((x) + RAY_PAGE_SIZE - 1) / RAY_PAGE_SIZE * RAY_PAGE_SIZE)
+#define SYMBOLS_ENTRY_SIZE(len) ALIGNUP((i64_t)sizeof(u32_t) + (len) + 1, 8)
+
+// Every string of the pool is preceded by its length, the entries are padded to 8 bytes
 str_p string_intern(symbols_p symbols, lit_p str, i64_t len) {
     i64_t rounds = 0, cap;
     str_p curr, node;
 
     assert(len > 0);
 
-    cap = sizeof(u32_t) + len + 1;
+    cap = SYMBOLS_ENTRY_SIZE(len);
     curr = __atomic_fetch_add(&symbols->string_curr, cap, __ATOMIC_RELAXED);
     node = __atomic_load_n(&symbols->string_node, __ATOMIC_ACQUIRE);
 
@@ -75,27 +84,159 @@ str_p string_intern(symbols_p symbols, lit_p str, i64_t len) {
     return node;
 }
 
+static symbols_table_p symbols_table_create(i64_t size) {
+    symbols_table_p table;
+
+    // Fresh anonymous mapping is zeroed: no rebuild is running and all the buckets are empty
+    table = (symbols_table_p)heap_mmap(sizeof(struct symbols_table_t) + size * sizeof(symbol_p));
+
+    if (table == NULL) {
+        perror("symbols table mmap");
+        exit(1);
+    }
+
+    table->size = size;
+
+    return table;
+}
+
+// Nodes loaded from an image live in its mapping and are not freed one by one
+static b8_t symbols_arena_owns(symbols_p symbols, symbol_p node) {
+    symbol_p arena;
+
+    for (arena = symbols->arenas; arena != NULL; arena = arena->next) {
+        if ((str_p)node >= (str_p)arena && (str_p)node < (str_p)arena + (i64_t)arena->str)
+            return B8_TRUE;
+    }
+
+    return B8_FALSE;
+}
+
+static nil_t symbols_table_destroy(symbols_p symbols, symbols_table_p table) {
+    i64_t i;
+    symbol_p b, next;
+
+    for (i = 0; i < table->size; i++) {
+        b = table->syms[i];
+        if (b == SYMBOL_BUCKET_MOVED || b == SYMBOL_BUCKET_LOCKED)
+            continue;
+
+        while (b != NULL) {
+            next = b->next;
+            if (!symbols_arena_owns(symbols, b))
+                heap_free(b);
+            b = next;
+        }
+    }
+
+    mmap_free(table, sizeof(struct symbols_table_t) + table->size * sizeof(symbol_p));
+}
+
+// Spins until the bucket is locked by the caller, returns the chain it holds (or the moved mark)
+static symbol_p symbols_bucket_lock(symbol_p *bucket) {
+    i64_t rounds = 0;
+    symbol_p b;
+
+    for (;;) {
+        b = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
+
+        if (b == SYMBOL_BUCKET_MOVED)
+            return b;
+
+        if (b != SYMBOL_BUCKET_LOCKED &&
+            __atomic_compare_exchange_n(bucket, &b, SYMBOL_BUCKET_LOCKED, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return b;
+
+        backoff_spin(&rounds);
+    }
+}
+
+// Relinks the chain of one bucket into the next table. Readers still walking the old chain may
+// wander into a chain of the next table, which is harmless: they only ever compare strings and
+// fall back to the locked path, where the moved mark sends them to the next table.
+static nil_t symbols_move_bucket(symbols_table_p table, i64_t index) {
+    symbol_p b, next, head, *bucket;
+    symbols_table_p to = table->next;
+
+    b = symbols_bucket_lock(&table->syms[index]);
+
+    while (b != NULL) {
+        next = b->next;
+        bucket = &to->syms[str_hash(b->str, SYMBOL_STRLEN((i64_t)b->str)) % to->size];
+        head = symbols_bucket_lock(bucket);
+        __atomic_store_n(&b->next, head, __ATOMIC_RELAXED);
+        __atomic_store_n(bucket, b, __ATOMIC_RELEASE);
+        b = next;
+    }
+
+    __atomic_store_n(&table->syms[index], SYMBOL_BUCKET_MOVED, __ATOMIC_RELEASE);
+}
+
+// Moves the next step of buckets of a rebuild, the thread moving the last one publishes the new table
+static nil_t symbols_migrate(symbols_p symbols, symbols_table_p table, i64_t step) {
+    i64_t i, from, to;
+
+    from = __atomic_fetch_add(&table->cursor, step, __ATOMIC_RELAXED);
+    if (from >= table->size)
+        return;
+
+    to = (from + step < table->size) ? from + step : table->size;
+
+    for (i = from; i < to; i++)
+        symbols_move_bucket(table, i);
+
+    if (__atomic_add_fetch(&table->moved, to - from, __ATOMIC_ACQ_REL) == table->size) {
+        table->next->retired = table;
+        __atomic_store_n(&symbols->table, table->next, __ATOMIC_RELEASE);
+    }
+}
+
+// Starts a rebuild into a table of the double size unless one is already running
+static nil_t symbols_grow(symbols_table_p table) {
+    symbols_table_p next = NULL, new_table;
+
+    if (__atomic_load_n(&table->next, __ATOMIC_ACQUIRE) != NULL)
+        return;
+
+    new_table = symbols_table_create(table->size * 2);
+
+    if (!__atomic_compare_exchange_n(&table->next, &next, new_table, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        mmap_free(new_table, sizeof(struct symbols_table_t) + new_table->size * sizeof(symbol_p));
+}
+
 i64_t symbols_intern(lit_p str, i64_t len) {
-    i64_t l, index, rounds = 0;
+    i64_t l, rounds = 0;
+    u64_t hash;
     str_p intr;
     symbols_p symbols = runtime_get()->symbols;
-    symbol_p new_bucket, current_bucket, b, *syms;
+    symbols_table_p table;
+    symbol_p new_bucket, current_bucket, b, *bucket;
 
     if (len == 0)
         return NULL_I64;
 
-    syms = symbols->syms;
-    index = str_hash(str, len) % symbols->size;
+    hash = str_hash(str, len);
+    table = __atomic_load_n(&symbols->table, __ATOMIC_ACQUIRE);
+
+    // Every intern helps a running rebuild, so it never stalls the readers
+    if (__atomic_load_n(&table->next, __ATOMIC_ACQUIRE) != NULL)
+        symbols_migrate(symbols, table, SYMBOLS_MIGRATE_STEP);
 
 load:
-    current_bucket = __atomic_load_n(&syms[index], __ATOMIC_ACQUIRE);
+    bucket = &table->syms[hash % table->size];
+    current_bucket = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
     b = current_bucket;
 
-    if ((i64_t)b == NULL_I64) {
+    if (b == SYMBOL_BUCKET_LOCKED) {
         backoff_spin(&rounds);
         goto load;
     }
 
+    if (b == SYMBOL_BUCKET_MOVED) {
+        table = __atomic_load_n(&table->next, __ATOMIC_ACQUIRE);
+        goto load;
+    }
+
     while (b != NULL) {
         l = SYMBOL_STRLEN((i64_t)b->str);
         if (str_cmp(b->str, l, str, len) == 0)
@@ -104,7 +245,7 @@ load:
         b = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
     }
 
-    if (!__atomic_compare_exchange_n(&syms[index], &current_bucket, (symbol_p)NULL_I64, 1, __ATOMIC_ACQUIRE,
+    if (!__atomic_compare_exchange_n(bucket, &current_bucket, SYMBOL_BUCKET_LOCKED, 1, __ATOMIC_ACQUIRE,
                                      __ATOMIC_RELAXED)) {
         backoff_spin(&rounds);
         goto load;
@@ -115,7 +256,7 @@ load:
     while (b != NULL) {
         l = SYMBOL_STRLEN((i64_t)b->str);
         if (str_cmp(b->str, l, str, len) == 0) {
-            __atomic_store_n(&syms[index], current_bucket, __ATOMIC_RELEASE);
+            __atomic_store_n(bucket, current_bucket, __ATOMIC_RELEASE);
             return (i64_t)b->str;
         }
 
@@ -123,19 +264,60 @@ load:
     }
 
     new_bucket = (symbol_p)heap_alloc(sizeof(struct symbol_t));
-    if (new_bucket == NULL)
+    if (new_bucket == NULL) {
+        __atomic_store_n(bucket, current_bucket, __ATOMIC_RELEASE);
         return NULL_I64;
+    }
 
     intr = string_intern(symbols, str, len);
     new_bucket->str = intr;
     new_bucket->next = current_bucket;
 
-    __atomic_store_n(&syms[index], new_bucket, __ATOMIC_RELEASE);
-    __atomic_fetch_add(&symbols->count, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(bucket, new_bucket, __ATOMIC_RELEASE);
+
+    // Keep the chains short: double the table once there are more symbols than buckets
+    if (__atomic_add_fetch(&symbols->count, 1, __ATOMIC_RELAXED) > table->size)
+        symbols_grow(table);
 
     return (i64_t)intr;
 }
 
+static obj_p symbols_intern_partial(i64_t len, lit_p strs[], i64_t lens[], i64_t ids[]) {
+    i64_t i;
+
+    for (i = 0; i < len; i++)
+        ids[i] = symbols_intern(strs[i], (lens == NULL) ? (i64_t)strlen(strs[i]) : lens[i]);
+
+    return NULL_OBJ;
+}
+
+// Interns n strings in parallel, lens may be NULL for zero terminated strings
+nil_t symbols_intern_bulk(lit_p strs[], i64_t lens[], i64_t n, i64_t ids[]) {
+    pool_p pool = pool_get();
+    i64_t i, parts, chunk;
+    obj_p res;
+
+    parts = pool_split_by(pool, n, 0);
+
+    if (parts == 1) {
+        symbols_intern_partial(n, strs, lens, ids);
+        return;
+    }
+
+    pool_prepare(pool);
+    chunk = n / parts;
+
+    for (i = 0; i < parts - 1; i++)
+        pool_add_task(pool, (raw_p)symbols_intern_partial, 4, chunk, strs + i * chunk,
+                      (lens == NULL) ? NULL : lens + i * chunk, ids + i * chunk);
+
+    pool_add_task(pool, (raw_p)symbols_intern_partial, 4, n - i * chunk, strs + i * chunk,
+                  (lens == NULL) ? NULL : lens + i * chunk, ids + i * chunk);
+
+    res = pool_run(pool);
+    drop_obj(res);
+}
+
 symbols_p symbols_create(nil_t) {
     symbols_p symbols;
     raw_p pooladdr;
@@ -150,9 +332,9 @@ symbols_p symbols_create(nil_t) {
 
     // Allocate the string pool as close to the start of the address space as possible
     pooladdr = (raw_p)(RAY_PAGE_SIZE);
-    symbols->size = SYMBOLS_HT_SIZE;
     symbols->count = 0;
-    symbols->syms = (symbol_p *)heap_mmap(SYMBOLS_HT_SIZE * sizeof(symbol_p));
+    symbols->table = symbols_table_create(SYMBOLS_HT_SIZE);
+    symbols->arenas = NULL;
     string_pool = (str_p)mmap_reserve(pooladdr, STRING_POOL_SIZE);
 
     if (string_pool == NULL) {
@@ -163,6 +345,17 @@ symbols_p symbols_create(nil_t) {
     symbols->string_pool = string_pool;
     symbols->string_curr = symbols->string_pool;
     symbols->string_node = symbols->string_pool + STRING_NODE_SIZE;
+    symbols->rank_curr = symbols->string_pool;
+    symbols->ranks = (u32_t *)mmap_reserve(NULL, STRING_POOL_SIZE / 8 * sizeof(u32_t));
+    symbols->rank_size = 0;
+    symbols->rank_order = NULL;
+    symbols->rank_count = 0;
+    symbols->rank_cap = 0;
+
+    if (symbols->ranks == NULL) {
+        perror("symbols ranks mmap_reserve");
+        exit(1);
+    }
 
     if (mmap_commit(symbols->string_pool, STRING_NODE_SIZE) == -1) {
         perror("string_pool mmap_commit");
@@ -173,20 +366,31 @@ symbols_p symbols_create(nil_t) {
 }
 
 nil_t symbols_destroy(symbols_p symbols) {
-    i64_t i;
-    symbol_p b, next;
+    symbols_table_p table, retired;
+    symbol_p arena, next;
 
-    // free the symbol pool nodes
-    for (i = 0; i < symbols->size; i++) {
-        b = symbols->syms[i];
-        while (b != NULL) {
-            next = b->next;
-            heap_free(b);
-            b = next;
-        }
+    table = symbols->table;
+
+    // an unfinished rebuild holds a part of the chains
+    if (table->next != NULL)
+        symbols_table_destroy(symbols, table->next);
+
+    while (table != NULL) {
+        retired = table->retired;
+        symbols_table_destroy(symbols, table);
+        table = retired;
     }
 
-    mmap_free(symbols->syms, symbols->size * sizeof(symbol_p));
+    for (arena = symbols->arenas; arena != NULL; arena = next) {
+        next = arena->next;
+        mmap_free(arena, (i64_t)arena->str);
+    }
+
+    if (symbols->rank_order != NULL)
+        mmap_free(symbols->rank_order, symbols->rank_cap * ISIZEOF(i64_t));
+
+    mmap_free(symbols->ranks, STRING_POOL_SIZE / 8 * sizeof(u32_t));
+
     mmap_free(symbols->string_pool, STRING_POOL_SIZE);
     heap_unmap(symbols, sizeof(struct symbols_t));
 }
@@ -195,37 +399,315 @@ str_p str_from_symbol(i64_t key) { return (key == NULL_I64) ? (str_p) "" : (str_
 
 i64_t symbols_count(symbols_p symbols) { return symbols->count; }
 
-// TODO
+// Completes a running rebuild, if any
+static nil_t symbols_finish(symbols_p symbols) {
+    i64_t rounds = 0;
+    symbols_table_p table;
+
+    table = __atomic_load_n(&symbols->table, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&table->next, __ATOMIC_ACQUIRE) == NULL)
+        return;
+
+    while (__atomic_load_n(&table->moved, __ATOMIC_ACQUIRE) < table->size) {
+        if (__atomic_load_n(&table->cursor, __ATOMIC_RELAXED) < table->size)
+            symbols_migrate(symbols, table, SYMBOLS_MIGRATE_STEP);
+        else
+            backoff_spin(&rounds);
+    }
+}
+
+// Doubles the bucket table and moves all the symbols into it (or completes a running rebuild)
 nil_t symbols_rebuild(symbols_p symbols) {
-    UNUSED(symbols);
-    // i64_t i, size, new_size;
-    // symbol_p bucket, *syms, *new_syms;
-
-    // syms = symbols->syms;
-    // size = symbols->size;
-    // new_size = size * 2;
-    // new_syms = (symbol_p *)heap_mmap(new_size * sizeof(symbol_p));
-
-    // if (new_syms == NULL)
-    // {
-    //     DEBUG_PRINT("Memory allocation failed during symbols rebuild.");
-    //     return;
-    // }
-
-    // // Rehash all elements from the old table to the new table
-    // for (i = 0; i < size; ++i)
-    // {
-    //     bucket = syms[i];
-    //     while (bucket != NULL)
-    //     {
-    //         ht_bk_insert(new_ht, bucket->key, bucket->val);
-    //         bucket = bucket->next;
-    //     }
-    // }
-
-    // // Free the old hash table
-    // ht_bk_destroy(*ht);
-
-    // // Update the pointer to point to the new hash table
-    // *ht = new_ht;
-}
\ No newline at end of file
+    symbols_grow(__atomic_load_n(&symbols->table, __ATOMIC_ACQUIRE));
+    symbols_finish(symbols);
+}
+
+/*
+ * Ranks follow the lexical order of all the strings of the pool. They are kept apart from the strings,
+ * so neither the interned entries nor the pages of a mapped image are ever written. The pool only grows:
+ * the strings past the cursor the ranks were made at are sorted on their own and merged into the order
+ * kept from the last call, then the order is renumbered. The executors read the ranks while a parallel
+ * section runs, so they are only brought up to date by the main thread out of one; symbols interned
+ * since read as unranked and are compared by their strings. Image strings redirected to existing
+ * symbols are ranked as well, they are just never looked up. The gap between the pool and an image
+ * mapped past it reads as a zero length and is skipped up to the page the image starts at.
+ */
+nil_t symbols_rank(symbols_p symbols) {
+    i64_t i, j, k, m, n, cap, size, *fresh, *idx, *order;
+    str_p p, end;
+    obj_p syms, sorted;
+
+    end = __atomic_load_n(&symbols->string_curr, __ATOMIC_ACQUIRE);
+
+    if (symbols->rank_curr == end || rc_sync_get())
+        return;
+
+    for (p = symbols->rank_curr, m = 0; p < end; m++) {
+        n = *((u32_t *)p);
+        if (n == 0) {
+            p = (str_p)SYMBOLS_IMAGE_PAGES((i64_t)p + 1);
+            m--;
+            continue;
+        }
+        p += SYMBOLS_ENTRY_SIZE(n);
+    }
+
+    // the ranks of the slots up to the cursor
+    size = SYMBOLS_IMAGE_PAGES(SYMBOL_RANK_SLOT(symbols, (i64_t)end) * ISIZEOF(u32_t));
+    if (size > symbols->rank_size) {
+        if (mmap_commit((str_p)symbols->ranks + symbols->rank_size, size - symbols->rank_size) != 0) {
+            perror("symbols ranks mmap_commit");
+            exit(1);
+        }
+
+        symbols->rank_size = size;
+    }
+
+    if (m == 0) {
+        symbols->rank_curr = end;
+        return;
+    }
+
+    syms = SYMBOL(m);
+    fresh = AS_SYMBOL(syms);
+
+    for (p = symbols->rank_curr, i = 0; p < end;) {
+        n = *((u32_t *)p);
+        if (n == 0) {
+            p = (str_p)SYMBOLS_IMAGE_PAGES((i64_t)p + 1);
+            continue;
+        }
+        fresh[i++] = (i64_t)(p + sizeof(u32_t));
+        p += SYMBOLS_ENTRY_SIZE(n);
+    }
+
+    sorted = mergesort_generic_obj(syms, 1);
+    idx = AS_I64(sorted);
+
+    n = symbols->rank_count;
+    order = symbols->rank_order;
+
+    if (n + m > symbols->rank_cap) {
+        cap = (symbols->rank_cap > 0) ? symbols->rank_cap : RAY_PAGE_SIZE / ISIZEOF(i64_t);
+        while (cap < n + m)
+            cap *= 2;
+
+        order = (i64_t *)mmap_alloc(cap * ISIZEOF(i64_t));
+        if (order == NULL) {
+            perror("symbols rank mmap");
+            exit(1);
+        }
+
+        if (symbols->rank_order != NULL) {
+            memcpy(order, symbols->rank_order, n * sizeof(i64_t));
+            mmap_free(symbols->rank_order, symbols->rank_cap * ISIZEOF(i64_t));
+        }
+
+        symbols->rank_order = order;
+        symbols->rank_cap = cap;
+    }
+
+    // Merge from the back, so the order is extended in place
+    for (i = n - 1, j = m - 1, k = n + m - 1; j >= 0; k--) {
+        if (i >= 0 && strcmp((str_p)order[i], (str_p)fresh[idx[j]]) > 0)
+            order[k] = order[i--];
+        else
+            order[k] = fresh[idx[j--]];
+    }
+
+    for (i = 0; i < n + m; i++)
+        symbols->ranks[SYMBOL_RANK_SLOT(symbols, order[i])] = (u32_t)(i + 1);
+
+    symbols->rank_count = n + m;
+    symbols->rank_curr = end;
+
+    drop_obj(sorted);
+    drop_obj(syms);
+}
+
+/*
+ * Symbols image layout (node links are node indices, 0 stands for NULL):
+ *   page 0:           symbols_image_t header
+ *   page 1..:         string pool bytes, padded to a page
+ *   nodes + 1 nodes:  {string pool offset, string hash}, node 0 is reserved for the arena header
+ *   syms:             node of each symbol of the sym vector saved along
+ * The pool is mapped copy-on-write right past the current pool cursor and the rest of the file
+ * becomes the nodes arena, so loading is a single relocation pass with no string hashed or copied.
+ */
+obj_p symbols_save(lit_p path, obj_p sym, i64_t source, u64_t hash) {
+    i64_t i, k, c, fd, slot, size, *nodes, *ids;
+    obj_p links, set, res;
+    symbols_image_t image;
+    symbols_table_p table;
+    symbol_p b;
+    symbols_p symbols = runtime_get()->symbols;
+
+    symbols_finish(symbols);
+    table = symbols->table;
+
+    c = 0;
+    for (i = 0; i < table->size; i++) {
+        for (b = table->syms[i]; b != NULL; b = b->next)
+            c++;
+    }
+
+    size = 2 * (c + 1) + sym->len;
+    links = I64(size);
+    set = ht_oa_create(c, TYPE_I64);
+    nodes = AS_I64(links);
+    ids = nodes + 2 * (c + 1);
+
+    nodes[0] = 0;
+    nodes[1] = 0;
+    k = 1;
+
+    for (i = 0; i < table->size; i++) {
+        for (b = table->syms[i]; b != NULL; b = b->next, k++) {
+            nodes[2 * k] = b->str - symbols->string_pool;
+            nodes[2 * k + 1] = (i64_t)str_hash(b->str, SYMBOL_STRLEN((i64_t)b->str));
+            slot = ht_oa_tab_next(&set, (i64_t)b->str);
+            AS_I64(AS_LIST(set)[0])[slot] = (i64_t)b->str;
+            AS_I64(AS_LIST(set)[1])[slot] = k;
+        }
+    }
+
+    for (i = 0; i < sym->len; i++) {
+        slot = (AS_SYMBOL(sym)[i] == NULL_I64) ? NULL_I64 : ht_oa_tab_get(set, AS_SYMBOL(sym)[i]);
+        ids[i] = (slot == NULL_I64) ? 0 : AS_I64(AS_LIST(set)[1])[slot];
+    }
+
+    drop_obj(set);
+
+    memset(&image, 0, sizeof(symbols_image_t));
+    memcpy(image.magic, SYMBOLS_IMAGE_MAGIC, sizeof(SYMBOLS_IMAGE_MAGIC));
+    image.version = SYMBOLS_IMAGE_VERSION;
+    image.source = source;
+    image.hash = hash;
+    image.pool = symbols->string_curr - symbols->string_pool;
+    image.nodes = c;
+    image.syms = sym->len;
+
+    fd = fs_fopen(path, ATTR_WRONLY | ATTR_CREAT | ATTR_TRUNC);
+    if (fd == -1) {
+        drop_obj(links);
+        return sys_error(ERROR_TYPE_SYS, path);
+    }
+
+    // The header and the pool are padded to a page to be mapped on load
+    res = NULL_OBJ;
+    if (fs_fwrite(fd, (str_p)&image, sizeof(symbols_image_t)) == -1 || fs_file_extend(fd, RAY_PAGE_SIZE) == -1 ||
+        fs_fwrite(fd, symbols->string_pool, image.pool) == -1 ||
+        fs_file_extend(fd, RAY_PAGE_SIZE + SYMBOLS_IMAGE_PAGES(image.pool)) == -1 ||
+        fs_fwrite(fd, (str_p)nodes, size * ISIZEOF(i64_t)) == -1)
+        res = sys_error(ERROR_TYPE_SYS, path);
+
+    fs_fclose(fd);
+    drop_obj(links);
+
+    return res;
+}
+
+obj_p symbols_load(lit_p path, i64_t source, u64_t hash) {
+    i64_t i, l, fd, size, pool, offset, *ids;
+    str_p base, dst;
+    obj_p res;
+    symbol_p arena, s, *bucket;
+    symbols_image_t image;
+    symbols_table_p table;
+    symbols_p symbols = runtime_get()->symbols;
+
+    fd = fs_fopen(path, ATTR_RDONLY);
+    if (fd == -1)
+        return NULL_OBJ;
+
+    size = fs_fsize(fd);
+    base = (size < RAY_PAGE_SIZE) ? NULL : (str_p)mmap_file_private(fd, NULL, size, 0);
+
+    if (base == NULL) {
+        fs_fclose(fd);
+        return NULL_OBJ;
+    }
+
+    // Validate the header against the file and the sym file it was saved with
+    memcpy(&image, base, sizeof(symbols_image_t));
+    pool = SYMBOLS_IMAGE_PAGES(image.pool);
+    offset = RAY_PAGE_SIZE + pool;
+    symbols_finish(symbols);
+    dst = (str_p)SYMBOLS_IMAGE_PAGES((i64_t)symbols->string_curr);
+
+    if (memcmp(image.magic, SYMBOLS_IMAGE_MAGIC, sizeof(SYMBOLS_IMAGE_MAGIC)) != 0 ||
+        image.version != SYMBOLS_IMAGE_VERSION || image.source != source || image.hash != hash || image.pool < 0 || image.nodes < 0 ||
+        image.syms < 0 || size != offset + (2 * (image.nodes + 1) + image.syms) * ISIZEOF(i64_t) ||
+        dst + pool > symbols->string_pool + STRING_POOL_SIZE) {
+        mmap_free(base, size);
+        fs_fclose(fd);
+        return NULL_OBJ;
+    }
+
+    arena = (symbol_p)(base + offset);
+    ids = (i64_t *)(arena + image.nodes + 1);
+
+    for (i = 1; i <= image.nodes; i++) {
+        if ((i64_t)arena[i].str < ISIZEOF(u32_t) || (i64_t)arena[i].str >= image.pool)
+            break;
+    }
+
+    for (l = 0; l < image.syms; l++) {
+        if (ids[l] < 0 || ids[l] > image.nodes)
+            break;
+    }
+
+    if (i <= image.nodes || l < image.syms || (pool > 0 && mmap_file_private(fd, dst, pool, RAY_PAGE_SIZE) == NULL)) {
+        mmap_free(base, size);
+        fs_fclose(fd);
+        return NULL_OBJ;
+    }
+
+    fs_fclose(fd);
+
+    while (symbols->table->size < symbols->count + image.nodes)
+        symbols_rebuild(symbols);
+
+    // Link the nodes in with their saved hashes. Symbols interned so far keep their ids, so an image
+    // node of the same string is redirected to them, only the chain part before the image is compared.
+    table = symbols->table;
+
+    for (i = 1; i <= image.nodes; i++) {
+        arena[i].str = dst + (i64_t)arena[i].str;
+        bucket = &table->syms[(u64_t)arena[i].next % table->size];
+        l = SYMBOL_STRLEN((i64_t)arena[i].str);
+
+        for (s = *bucket; s != NULL && s >= arena && s <= arena + image.nodes; s = s->next)
+            ;
+
+        for (; s != NULL; s = s->next) {
+            if (str_cmp(s->str, SYMBOL_STRLEN((i64_t)s->str), arena[i].str, l) == 0)
+                break;
+        }
+
+        if (s != NULL) {
+            arena[i].str = s->str;
+            arena[i].next = NULL;
+        } else {
+            arena[i].next = *bucket;
+            *bucket = &arena[i];
+            symbols->count++;
+        }
+    }
+
+    res = SYMBOL(image.syms);
+    for (i = 0; i < image.syms; i++)
+        AS_SYMBOL(res)[i] = (ids[i] == 0) ? NULL_I64 : (i64_t)arena[ids[i]].str;
+
+    // Keep the nodes as an arena, the header and the pool pages of the file mapping are not needed
+    arena[0].str = (lit_p)(size - offset);
+    arena[0].next = symbols->arenas;
+    symbols->arenas = arena;
+    mmap_free(base, offset);
+
+    symbols->string_curr = dst + image.pool;
+    if (symbols->string_node < dst + pool)
+        symbols->string_node = dst + pool;
+
+    return res;
+}
@@ -26,31 +26,95 @@
 
 #include "rayforce.h"
 #include "hash.h"
+#include "string.h"
 
 #define SYMBOLS_HT_SIZE RAY_PAGE_SIZE * 1024
+#define SYMBOLS_MIGRATE_STEP 64
 #define STRING_NODE_SIZE RAY_PAGE_SIZE
 #define STRING_POOL_SIZE (RAY_PAGE_SIZE * 1024ull * 1024ull)
 #define SYMBOL_STRLEN(x) ((x == NULL_I64) ? 0 : *((u32_t *)(x - sizeof(u32_t))))
+// Strings of the pool start 8 bytes apart at least, so the offset of a symbol / 8 indexes its rank
+#define SYMBOL_RANK_SLOT(s, x) (((x) - (i64_t)(s)->string_pool) >> 3)
+#define SYMBOL_RANK(x) (symbols_rank_of(runtime_get()->symbols, (x)))
+
+// Bucket states besides a chain: locked by a writer, or moved to the next table by a rebuild
+#define SYMBOL_BUCKET_LOCKED ((symbol_p)NULL_I64)
+#define SYMBOL_BUCKET_MOVED ((symbol_p)(NULL_I64 + 1))
 
 typedef struct symbol_t {
     lit_p str;
     struct symbol_t *next;
 } *symbol_p;
 
-typedef struct symbols_t {
+typedef struct symbols_table_t {
     i64_t size;
+    i64_t cursor;                    // next bucket to be moved by a rebuild
+    i64_t moved;                     // buckets already moved by a rebuild
+    struct symbols_table_t *next;    // table the buckets are moved to, NULL if no rebuild is running
+    struct symbols_table_t *retired; // tables replaced by this one, kept alive for the lock-free readers
+    symbol_p syms[];
+} *symbols_table_p;
+
+// Header of a symbols image: the string pool, the bucket chains and a sym vector saved for mmap
+#define SYMBOLS_IMAGE_MAGIC "RAYSYMS"
+#define SYMBOLS_IMAGE_VERSION 4
+
+typedef struct symbols_image_t {
+    c8_t magic[8];
+    i64_t version;
+    i64_t source;   // size of the sym file saved along with the image
+    u64_t hash;     // hash of the contents of that sym file
+    i64_t pool;     // bytes of the string pool
+    i64_t nodes;    // symbol nodes, stored with their hashes right after the page aligned pool
+    i64_t syms;     // sym vector as node indices
+} symbols_image_t;
+
+typedef struct symbols_t {
     i64_t count;
-    symbol_p *syms;
+    symbols_table_p table;
+    symbol_p arenas;    // nodes mapped from images, chained through their first (header) node
     str_p string_pool;  // string pool
     str_p string_node;  // string pool current node
     str_p string_curr;  // string pool cursor
+    str_p rank_curr;    // string pool cursor the ranks are up to date with
+    u32_t *ranks;       // ranks by pool slot, reserved along with the pool
+    i64_t rank_size;    // committed bytes of the ranks
+    i64_t *rank_order;  // ranked symbols in the lexical order
+    i64_t rank_count;   // ranked symbols
+    i64_t rank_cap;     // capacity of the order
 } *symbols_p;
 
 i64_t symbols_intern(lit_p s, i64_t len);
+nil_t symbols_intern_bulk(lit_p strs[], i64_t lens[], i64_t n, i64_t ids[]);
 symbols_p symbols_create(nil_t);
 nil_t symbols_destroy(symbols_p symbols);
 i64_t symbols_count(symbols_p symbols);
 str_p str_from_symbol(i64_t key);
 nil_t symbols_rebuild(symbols_p symbols);
+nil_t symbols_rank(symbols_p symbols);
+obj_p symbols_save(lit_p path, obj_p sym, i64_t source, u64_t hash);
+obj_p symbols_load(lit_p path, i64_t source, u64_t hash);
+
+// Position of a symbol in the lexical order of the pool as of the last symbols_rank(), 0 for null and
+// for the symbols interned since
+static inline u32_t symbols_rank_of(symbols_p symbols, i64_t x) {
+    if (x == NULL_I64 || (str_p)x >= symbols->rank_curr)
+        return 0;
+
+    return symbols->ranks[SYMBOL_RANK_SLOT(symbols, x)];
+}
+
+// Orders symbols by their ranks, or by their strings if one of them is not ranked yet (null first)
+static inline i64_t symbols_cmp(symbols_p symbols, i64_t x, i64_t y) {
+    i64_t rx, ry;
+
+    rx = symbols_rank_of(symbols, x);
+    ry = symbols_rank_of(symbols, y);
+
+    if ((rx != 0 || x == NULL_I64) && (ry != 0 || y == NULL_I64))
+        return rx - ry;
+
+    return str_cmp(str_from_symbol(x), SYMBOL_STRLEN(x), str_from_symbol(y), SYMBOL_STRLEN(y));
+}
 
 #endif  // SYMBOLS_H
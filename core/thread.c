@@ -102,6 +102,13 @@ i32_t thread_pin(ray_thread_t thread, i64_t core) {
     return 0;
 }
 
+i64_t thread_numa_nodes(nil_t) { return 1; }
+
+i64_t thread_cpu_node(i64_t core) {
+    UNUSED(core);
+    return 0;
+}
+
 #else
 
 mutex_t mutex_create() {
@@ -193,6 +200,59 @@ i32_t thread_pin(ray_thread_t thread, i64_t core) {
     return 0;
 }
 
+#define NUMA_MAX_NODES 64
+#define NUMA_MAX_CPUS 1024
+
+static i64_t NUMA_NODES = 0;
+static u8_t NUMA_CPU_NODE[NUMA_MAX_CPUS] = {0};
+
+// Reads the node of every cpu from the sysfs cpulists ("0-3,8-11"), once
+static nil_t numa_detect(nil_t) {
+    FILE *f;
+    c8_t path[64], buf[1024], *p;
+    i64_t node, lo, hi, nodes = 0;
+
+    for (node = 0; node < NUMA_MAX_NODES; node++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%lld/cpulist", node);
+        f = fopen(path, "r");
+        if (f == NULL)
+            continue;
+
+        nodes++;
+
+        if (fgets(buf, sizeof(buf), f) != NULL) {
+            for (p = buf; *p >= '0' && *p <= '9';) {
+                lo = strtoll(p, &p, 10);
+                hi = (*p == '-') ? strtoll(p + 1, &p, 10) : lo;
+
+                for (; lo <= hi && lo < NUMA_MAX_CPUS; lo++)
+                    NUMA_CPU_NODE[lo] = (u8_t)node;
+
+                if (*p == ',')
+                    p++;
+            }
+        }
+
+        fclose(f);
+    }
+
+    __atomic_store_n(&NUMA_NODES, (nodes > 0) ? nodes : 1, __ATOMIC_RELEASE);
+}
+
+i64_t thread_numa_nodes(nil_t) {
+    if (__atomic_load_n(&NUMA_NODES, __ATOMIC_ACQUIRE) == 0)
+        numa_detect();
+
+    return NUMA_NODES;
+}
+
+i64_t thread_cpu_node(i64_t core) {
+    if (core < 0 || core >= NUMA_MAX_CPUS || thread_numa_nodes() < 2)
+        return 0;
+
+    return NUMA_CPU_NODE[core];
+}
+
 #else
 
 i32_t thread_pin(ray_thread_t thread, i64_t core) {
@@ -216,6 +276,13 @@ i32_t thread_pin(ray_thread_t thread, i64_t core) {
     return 0;
 }
 
+i64_t thread_numa_nodes(nil_t) { return 1; }
+
+i64_t thread_cpu_node(i64_t core) {
+    UNUSED(core);
+    return 0;
+}
+
 #endif
 
 #endif
@@ -77,5 +77,7 @@ i32_t thread_detach(ray_thread_t thread);
 nil_t thread_exit(raw_p res);
 ray_thread_t thread_self();
 i32_t thread_pin(ray_thread_t thread, i64_t core);
+i64_t thread_numa_nodes(nil_t);
+i64_t thread_cpu_node(i64_t core);
 
 #endif  // THREAD_H
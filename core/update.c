@@ -35,6 +35,9 @@
 #include "query.h"
 #include "aggr.h"
 #include "compose.h"
+#include "pool.h"
+#include "heap.h"
+#include "serde.h"
 
 #define UNCOW_OBJ(o, v, r)            \
     {                                 \
@@ -48,6 +51,8 @@ obj_p __fetch(obj_p obj, obj_p **val) {
         *val = resolve(obj->i64);
         if (*val == NULL)
             THROW(ERR_NOT_FOUND, "fetch: symbol not found");
+        if (!resolve_writable(obj->i64, *val))
+            THROW(ERR_NOT_SUPPORTED, "fetch: globals can only be assigned in main thread");
 
         obj = cow_obj(**val);
     } else
@@ -94,6 +99,52 @@ b8_t __suitable_lengths(obj_p x, obj_p y) {
     return B8_TRUE;
 }
 
+static b8_t __fixed_width(i8_t type) {
+    switch (type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+        case TYPE_I16:
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_I64:
+        case TYPE_SYMBOL:
+        case TYPE_TIMESTAMP:
+        case TYPE_F64:
+        case TYPE_GUID:
+            return B8_TRUE;
+        default:
+            return B8_FALSE;
+    }
+}
+
+// Appends a value to a fixed width column. Once the block of the column is full, half as much again
+// is reserved, so a stream of single row inserts moves or remaps a column a logarithmic number of times.
+static obj_p __append_raw(obj_p *col, raw_p val) {
+    i64_t len, size, cap;
+
+    if (!IS_INTERNAL(*col))
+        return push_raw(col, val);
+
+    len = (*col)->len;
+    size = size_of_type((*col)->type);
+    cap = heap_cap(*col);
+
+    if (cap < ISIZEOF(struct obj_t) + (len + 1) * size) {
+        if (cap == 0)
+            return push_raw(col, val);
+
+        resize_obj(col, len + len / 2 + 1);
+        (*col)->len = len;
+    }
+
+    memcpy((*col)->raw + len * size, val, size);
+    (*col)->len++;
+
+    return *col;
+}
+
 obj_p *at_obj_ref(obj_p obj, obj_p idx) {
     i64_t j;
     obj_p v, *p;
@@ -209,6 +260,8 @@ obj_p ray_alter(obj_p *x, i64_t n) {
         cur = resolve(x[0]->i64);
         if (cur == NULL)
             THROW(ERR_NOT_FOUND, "alter: undefined symbol");
+        if (!resolve_writable(x[0]->i64, cur))
+            THROW(ERR_NOT_SUPPORTED, "alter: globals can only be assigned in main thread");
         obj = cow_obj(*cur);
     } else {
         obj = cow_obj(x[0]);
@@ -250,6 +303,8 @@ obj_p ray_modify(obj_p *x, i64_t n) {
         cur = resolve(x[0]->i64);
         if (cur == NULL)
             THROW(ERR_NOT_FOUND, "modify: undefined symbol");
+        if (!resolve_writable(x[0]->i64, cur))
+            THROW(ERR_NOT_SUPPORTED, "modify: globals can only be assigned in main thread");
         obj = cow_obj(*cur);
     } else {
         obj = cow_obj(x[0]);
@@ -285,7 +340,7 @@ obj_p ray_modify(obj_p *x, i64_t n) {
  */
 obj_p ray_insert(obj_p *x, i64_t n) {
     i64_t i, m, l;
-    obj_p lst, col, *val = NULL, obj, res;
+    obj_p lst, col, *val = NULL, obj, res, v;
     b8_t need_drop;
 
     if (n != 2)
@@ -323,11 +378,25 @@ insert:
                     }
                 }
 
-                // Insert the record now
+                // Insert the record now: atoms of the column type are appended in place
                 for (i = 0; i < l; i++) {
                     col = cow_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     need_drop = (col != AS_LIST(AS_LIST(obj)[1])[i]);
-                    push_obj(&col, clone_obj(AS_LIST(lst)[i]));
+                    if (IS_ERR(col))
+                        UNCOW_OBJ(obj, val, col);
+
+                    v = AS_LIST(lst)[i];
+                    if (__fixed_width(col->type) && v->type == -col->type)
+                        res = __append_raw(&col, (v->type == -TYPE_GUID) ? (raw_p)AS_GUID(v) : (raw_p)&v->i64);
+                    else
+                        res = push_obj(&col, clone_obj(v));
+
+                    if (IS_ERR(res)) {
+                        if (need_drop)
+                            drop_obj(col);
+                        UNCOW_OBJ(obj, val, res);
+                    }
+
                     if (need_drop)
                         drop_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     AS_LIST(AS_LIST(obj)[1])[i] = col;
@@ -360,7 +429,16 @@ insert:
                 for (i = 0; i < l; i++) {
                     col = cow_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     need_drop = (col != AS_LIST(AS_LIST(obj)[1])[i]);
-                    append_list(&col, AS_LIST(lst)[i]);
+                    if (IS_ERR(col))
+                        UNCOW_OBJ(obj, val, col);
+
+                    res = append_list(&col, AS_LIST(lst)[i]);
+                    if (IS_ERR(res)) {
+                        if (need_drop)
+                            drop_obj(col);
+                        UNCOW_OBJ(obj, val, res);
+                    }
+
                     if (need_drop)
                         drop_obj(AS_LIST(AS_LIST(obj)[1])[i]);
 
@@ -587,6 +665,83 @@ upsert:
     }
 }
 
+
+#define SCATTER_IDS(Type, As, Col, Ids, Vals, Len, Offset)            \
+    ({                                                                 \
+        i64_t $i;                                                      \
+        Type##_t *$c = As(Col), $a;                                    \
+        if (IS_VECTOR(Vals)) {                                         \
+            for ($i = Offset; $i < Offset + Len; $i++)                 \
+                $c[Ids[$i]] = As(Vals)[$i];                            \
+        } else {                                                       \
+            $a = (Vals)->Type;                                         \
+            for ($i = Offset; $i < Offset + Len; $i++)                 \
+                $c[Ids[$i]] = $a;                                      \
+        }                                                              \
+    })
+
+static obj_p __scatter_ids_partial(i64_t len, i64_t offset, obj_p col, i64_t ids[], obj_p vals) {
+    i64_t i;
+
+    switch (col->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+            SCATTER_IDS(u8, AS_U8, col, ids, vals, len, offset);
+            return NULL_OBJ;
+        case TYPE_I16:
+            SCATTER_IDS(i16, AS_I16, col, ids, vals, len, offset);
+            return NULL_OBJ;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            SCATTER_IDS(i32, AS_I32, col, ids, vals, len, offset);
+            return NULL_OBJ;
+        case TYPE_I64:
+        case TYPE_SYMBOL:
+        case TYPE_TIMESTAMP:
+            SCATTER_IDS(i64, AS_I64, col, ids, vals, len, offset);
+            return NULL_OBJ;
+        case TYPE_F64:
+            SCATTER_IDS(f64, AS_F64, col, ids, vals, len, offset);
+            return NULL_OBJ;
+        case TYPE_GUID:
+            for (i = offset; i < offset + len; i++)
+                memcpy(AS_GUID(col)[ids[i]], IS_VECTOR(vals) ? AS_GUID(vals)[i] : AS_GUID(vals)[0], sizeof(guid_t));
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "update: unsupported type: '%s", type_name(col->type));
+    }
+}
+
+// Writes vals (an atom or a vector of the column type) to the filtered rows of col in parallel
+static obj_p __scatter_ids(obj_p col, i64_t ids[], i64_t len, obj_p vals) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, n, chunk;
+    raw_p argv[5];
+
+    n = pool_split_by(pool, len, 0);
+
+    if (n == 1) {
+        argv[0] = (raw_p)len;
+        argv[1] = (raw_p)0;
+        argv[2] = col;
+        argv[3] = ids;
+        argv[4] = vals;
+        return pool_call_task_fn((raw_p)__scatter_ids_partial, 5, argv);
+    }
+
+    pool_prepare(pool);
+    chunk = len / n;
+
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)__scatter_ids_partial, 5, chunk, i * chunk, col, ids, vals);
+
+    pool_add_task(pool, (raw_p)__scatter_ids_partial, 5, len - i * chunk, i * chunk, col, ids, vals);
+
+    return pool_run(pool);
+}
+
 obj_p __update_table(obj_p tab, obj_p keys, obj_p vals, obj_p filters, obj_p groupby) {
     i64_t i, l, m, n;
     i64_t j, *ids;
@@ -615,55 +770,57 @@ obj_p __update_table(obj_p tab, obj_p keys, obj_p vals, obj_p filters, obj_p gro
 
         l = keys->len;
 
-        index = index_group(groupby, filters);
-        gids = aggr_row(groupby, index);
-        drop_obj(index);
-        drop_obj(groupby);
-        n = gids->len;
+        // groupby is the group index built over the filtered rows
+        index = groupby;
+        n = index_group_count(index);
+        gids = NULL_OBJ;
 
         // Check each column
         for (i = 0; i < l; i++) {
             j = find_raw(AS_LIST(obj)[0], AS_I64(keys) + i);
+            v = AS_LIST(vals)[i];
+
+            if (IS_VECTOR(v) && ops_count(v) != n) {
+                res = error(ERR_LENGTH, "update: expected %lld group values as %lldth element, got %lld", n, i,
+                            ops_count(v));
+                drop_obj(tab);
+                drop_obj(keys);
+                drop_obj(vals);
+                drop_obj(filters);
+                drop_obj(index);
+                UNCOW_OBJ(obj, val, res);
+            }
 
             // Add new column
             if (j == NULL_I64) {
                 push_raw(AS_LIST(obj), AS_SYMBOL(keys) + i);
-                push_obj(AS_LIST(obj) + 1, nullv(AS_LIST(vals)[i]->type, ops_count(obj)));
+                push_obj(AS_LIST(obj) + 1, nullv(v->type < 0 ? -v->type : v->type, ops_count(obj)));
+                continue;
             }
-            // Check existing column
-            else {
+
+            // Check existing column: once for a vector or an atom, per group for a list
+            col = AS_LIST(AS_LIST(obj)[1])[j];
+            if (v->type == TYPE_LIST) {
                 for (m = 0; m < n; m++) {
-                    v = at_idx(AS_LIST(vals)[i], m);
-                    if (!__suitable_types(AS_LIST(AS_LIST(obj)[1])[j], v)) {
-                        res = error(ERR_TYPE, "update: expected '%s as %lldth element, got '%s",
-                                    type_name(AS_LIST(AS_LIST(obj)[1])[j]->type), j, type_name(v->type));
-                        drop_obj(v);
-                        drop_obj(tab);
-                        drop_obj(keys);
-                        drop_obj(vals);
-                        drop_obj(filters);
-                        drop_obj(gids);
-                        UNCOW_OBJ(obj, val, res);
-                    }
+                    if (!__suitable_types(col, AS_LIST(v)[m]))
+                        break;
+                }
 
-                    if (!__suitable_lengths(AS_LIST(AS_LIST(obj)[1])[j], obj)) {
-                        res =
-                            error(ERR_LENGTH,
-                                  "update: expected '%s of length %lld, as %lldth element in a values, got '%s of %lld",
-                                  type_name(AS_LIST(AS_LIST(obj)[1])[j]->type), AS_LIST(AS_LIST(obj)[1])[j]->len, j,
-                                  type_name(v->type), ops_count(v));
-                        drop_obj(v);
-                        drop_obj(tab);
-                        drop_obj(keys);
-                        drop_obj(vals);
-                        drop_obj(filters);
-                        drop_obj(gids);
-                        UNCOW_OBJ(obj, val, res);
-                    }
+                if (m == n)
+                    continue;
 
-                    drop_obj(v);
-                }
-            }
+                v = AS_LIST(v)[m];
+            } else if (__suitable_types(col, v))
+                continue;
+
+            res = error(ERR_TYPE, "update: expected '%s as %lldth element, got '%s", type_name(col->type), j,
+                        type_name(v->type));
+            drop_obj(tab);
+            drop_obj(keys);
+            drop_obj(vals);
+            drop_obj(filters);
+            drop_obj(index);
+            UNCOW_OBJ(obj, val, res);
         }
 
         // Cow each column
@@ -680,13 +837,36 @@ obj_p __update_table(obj_p tab, obj_p keys, obj_p vals, obj_p filters, obj_p gro
         // Update by groups
         for (i = 0; i < l; i++) {
             j = find_raw(AS_LIST(obj)[0], AS_I64(keys) + i);
+            col = AS_LIST(AS_LIST(obj)[1])[j];
+            v = AS_LIST(vals)[i];
+
+            // One value per group of the same fixed width type: scatter it over the rows in parallel
+            if (v->type == col->type && __fixed_width(col->type)) {
+                res = aggr_scatter(v, index, col);
+                if (IS_ERR(res)) {
+                    drop_obj(tab);
+                    drop_obj(keys);
+                    drop_obj(vals);
+                    drop_obj(filters);
+                    drop_obj(index);
+                    drop_obj(gids);
+                    UNCOW_OBJ(obj, val, res);
+                }
+
+                drop_obj(res);
+                continue;
+            }
+
+            if (gids == NULL_OBJ)
+                gids = aggr_row(index, index);
 
             for (m = 0; m < n; m++) {
                 ids = AS_I64(AS_LIST(gids)[m]);
-                set_ids(AS_LIST(AS_LIST(obj)[1]) + j, ids, AS_LIST(gids)[m]->len, at_idx(AS_LIST(vals)[i], m));
+                set_ids(AS_LIST(AS_LIST(obj)[1]) + j, ids, AS_LIST(gids)[m]->len, at_idx(v, m));
             }
         }
 
+        drop_obj(index);
         drop_obj(keys);
         drop_obj(vals);
         drop_obj(filters);
@@ -761,6 +941,23 @@ obj_p __update_table(obj_p tab, obj_p keys, obj_p vals, obj_p filters, obj_p gro
 
         for (i = 0; i < l; i++) {
             j = find_raw(AS_LIST(obj)[0], AS_I64(keys) + i);
+            col = AS_LIST(AS_LIST(obj)[1])[j];
+            v = AS_LIST(vals)[i];
+
+            if (__fixed_width(col->type) && (v->type == col->type || v->type == -col->type)) {
+                res = __scatter_ids(col, ids, filters->len, v);
+                if (IS_ERR(res)) {
+                    drop_obj(tab);
+                    drop_obj(keys);
+                    drop_obj(vals);
+                    drop_obj(filters);
+                    UNCOW_OBJ(obj, val, res);
+                }
+
+                drop_obj(res);
+                continue;
+            }
+
             set_ids(AS_LIST(AS_LIST(obj)[1]) + j, ids, filters->len, at_idx(vals, i));
         }
 
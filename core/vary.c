@@ -214,6 +214,15 @@ obj_p ray_get_parted(obj_p *x, i64_t n) {
             drop_obj(sym);
             drop_obj(dir);
 
+            // Skip the symbols image saved along with the sym file
+            if (!IS_ERR(dirs)) {
+                dir = dirs;
+                sym = string_from_str("sym.idx", 7);
+                dirs = ray_except(dir, sym);
+                drop_obj(sym);
+                drop_obj(dir);
+            }
+
             if (IS_ERR(dirs))
                 return dirs;
 
@@ -21,4 +21,45 @@
  *   SOFTWARE.
  */
 
-test_result_t test_hash() { PASS(); }
\ No newline at end of file
+test_result_t test_hash() { PASS(); }
+
+test_result_t test_hash_sw() {
+    i64_t i, n = 100000, m = 1000000007, g, *keys, *out;
+    ht_sw_p ht;
+
+    // grows from the smallest table, the null key is an ordinary key
+    ht = ht_sw_create(0);
+    for (i = 0; i < n; i++)
+        TEST_ASSERT(ht_sw_insert(&ht, i * m, i) == i, "ht_sw_insert(&ht, i * m, i) == i");
+    TEST_ASSERT(ht_sw_insert(&ht, 5 * m, -1) == 5, "ht_sw_insert(&ht, 5 * m, -1) == 5");
+    TEST_ASSERT(ht_sw_get(ht, NULL_I64) == NULL_I64, "ht_sw_get(ht, NULL_I64) == NULL_I64");
+    TEST_ASSERT(ht_sw_insert(&ht, NULL_I64, 7) == 7, "ht_sw_insert(&ht, NULL_I64, 7) == 7");
+    TEST_ASSERT(ht_sw_get(ht, NULL_I64) == 7, "ht_sw_get(ht, NULL_I64) == 7");
+    TEST_ASSERT(ht->count == n + 1, "ht->count == n + 1");
+
+    keys = (i64_t *)heap_alloc(n * sizeof(i64_t));
+    out = (i64_t *)heap_alloc(n * sizeof(i64_t));
+
+    for (i = 0; i < n; i++)
+        keys[i] = (n - i) * m;
+    ht_sw_find(ht, keys, out, n);
+    TEST_ASSERT(out[0] == NULL_I64, "out[0] == NULL_I64");
+    for (i = 1; i < n; i++)
+        TEST_ASSERT(out[i] == n - i, "out[i] == n - i");
+    ht_sw_destroy(ht);
+
+    // groups are numbered by first appearance
+    for (i = 0; i < n; i++)
+        keys[i] = (i % 1000) << 40;
+    ht = ht_sw_create(16);
+    g = ht_sw_group(&ht, keys, NULL, out, n, 0);
+    TEST_ASSERT(g == 1000, "g == 1000");
+    for (i = 0; i < n; i++)
+        TEST_ASSERT(out[i] == i % 1000, "out[i] == i % 1000");
+    ht_sw_destroy(ht);
+
+    heap_free(keys);
+    heap_free(out);
+
+    PASS();
+}
\ No newline at end of file
@@ -238,4 +238,198 @@ test_result_t test_allocate_and_free_obj() {
     drop_obj(ht5);
 
     PASS();
-}
\ No newline at end of file
+}
+
+test_result_t test_heap_slab() {
+    i64_t i;
+    nil_t *ptr, *ptrs[300];
+
+    // a freed small block is handed out again before anything else
+    ptr = heap_alloc(16);
+    TEST_ASSERT(ptr != NULL, "ptr != NULL");
+    heap_free(ptr);
+    TEST_ASSERT(heap_alloc(16) == ptr, "slab block is not reused");
+    heap_free(ptr);
+
+    // more blocks than a single refill carves
+    for (i = 0; i < 300; i++) {
+        ptrs[i] = heap_alloc(40);
+        TEST_ASSERT(ptrs[i] != NULL, "ptrs[i] != NULL");
+        memset(ptrs[i], (u8_t)i, 40);
+    }
+
+    for (i = 0; i < 300; i++)
+        TEST_ASSERT(((u8_t *)ptrs[i])[0] == (u8_t)i && ((u8_t *)ptrs[i])[39] == (u8_t)i, "slab blocks overlap");
+
+    for (i = 0; i < 300; i++)
+        heap_free(ptrs[i]);
+
+    PASS();
+}
+
+test_result_t test_heap_large() {
+    i64_t i, size = (33ll << 20), system, free;
+    u8_t *ptr;
+
+    // exact page rounded mapping instead of a 64MB block
+    system = heap_memstat().system;
+    ptr = (u8_t *)heap_alloc(size);
+    TEST_ASSERT(ptr != NULL, "ptr != NULL");
+    TEST_ASSERT(heap_memstat().system - system == ALIGNUP(size + ISIZEOF(struct obj_t), RAY_PAGE_SIZE),
+                "large object is not mapped with its exact size");
+
+    for (i = 0; i < size; i += RAY_PAGE_SIZE)
+        ptr[i] = (u8_t)(i / RAY_PAGE_SIZE);
+
+    // grows by remapping, the content is kept
+    ptr = (u8_t *)heap_realloc(ptr, size * 2);
+    TEST_ASSERT(ptr != NULL, "ptr != NULL");
+    for (i = 0; i < size; i += RAY_PAGE_SIZE)
+        TEST_ASSERT(ptr[i] == (u8_t)(i / RAY_PAGE_SIZE), "content is lost on grow");
+
+    ptr[size * 2 - 1] = 1;
+    ptr[1000] = 7;
+
+    // small steps stay within the slack
+    TEST_ASSERT(heap_realloc(ptr, size * 2 + 8) == ptr, "large object is remapped on a small step");
+
+    // back into a pool block
+    ptr = (u8_t *)heap_realloc(ptr, 1024);
+    TEST_ASSERT(ptr != NULL && ptr[0] == 0 && ptr[1000] == 7, "content is lost on shrink");
+    heap_free(ptr);
+
+    // a freed mapping is cached and released by gc
+    ptr = (u8_t *)heap_alloc(size);
+    heap_free(ptr);
+    free = heap_memstat().free;
+    TEST_ASSERT(heap_gc() >= size, "cached mapping is not released");
+    TEST_ASSERT(heap_memstat().free <= free - size, "cached mapping is still counted as free");
+
+    PASS();
+}
+
+test_result_t test_heap_cap() {
+    i64_t cap, size = (33ll << 20);
+    raw_p ptr;
+
+    // a pool block is usable up to its order, a large object up to its mapping
+    ptr = heap_alloc(100);
+    cap = heap_cap(ptr);
+    TEST_ASSERT(cap >= 100 && cap < 256, "pool block capacity");
+    TEST_ASSERT(heap_realloc(ptr, cap) == ptr, "pool block moves within its capacity");
+    heap_free(ptr);
+
+    ptr = heap_alloc(size);
+    cap = heap_cap(ptr);
+    TEST_ASSERT(cap >= size && cap < size + RAY_PAGE_SIZE, "large object capacity");
+    TEST_ASSERT(heap_realloc(ptr, cap) == ptr, "large object moves within its capacity");
+    heap_free(ptr);
+
+    PASS();
+}
+
+static raw_p test_heap_remote_fn(raw_p arg) {
+    i64_t i;
+    raw_p *ptrs = (raw_p *)arg;
+
+    heap_create(MAX_HEAPS - 1);
+
+    for (i = 0; i < 256; i++)
+        heap_free(ptrs[i]);
+
+    heap_destroy();
+
+    return NULL;
+}
+
+test_result_t test_heap_remote() {
+    i64_t i;
+    raw_p ptrs[256];
+    ray_thread_t thread;
+
+    for (i = 0; i < 256; i++) {
+        ptrs[i] = heap_alloc(1024);
+        TEST_ASSERT(ptrs[i] != NULL, "ptrs[i] != NULL");
+    }
+
+    // blocks freed by another thread are handed back to this heap
+    thread = ray_thread_create(test_heap_remote_fn, ptrs);
+    TEST_ASSERT(thread_join(thread) == 0, "thread_join");
+    TEST_ASSERT(heap_get()->remote != NULL, "blocks freed by another thread are not handed back");
+
+    // and reused once this heap runs short of free blocks
+    heap_gc();
+    TEST_ASSERT(heap_get()->remote == NULL, "remote blocks are not drained");
+
+    ptrs[0] = heap_alloc(1024);
+    TEST_ASSERT(ptrs[0] != NULL, "ptrs[0] != NULL");
+    heap_free(ptrs[0]);
+
+    PASS();
+}
+
+typedef struct test_heap_merge_t {
+    heap_p heap;
+    raw_p ptr;
+    i64_t merged;
+} test_heap_merge_t;
+
+static raw_p test_heap_merge_fn(raw_p arg) {
+    i64_t rounds = 0;
+    heap_p heap;
+    test_heap_merge_t *t = (test_heap_merge_t *)arg;
+
+    // the block's buddy stays in this heap's free list
+    heap = heap_create(MAX_HEAPS - 1);
+    t->ptr = heap_alloc(1024);
+    __atomic_store_n(&t->heap, heap, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&t->merged, __ATOMIC_ACQUIRE) == 0)
+        backoff_spin(&rounds);
+
+    heap_destroy();
+
+    return NULL;
+}
+
+static int test_heap_block_cmp(const void *a, const void *b) {
+    block_p x = *(block_p *)a, y = *(block_p *)b;
+    return (x > y) - (x < y);
+}
+
+test_result_t test_heap_merge() {
+    i64_t i, n, rounds = 0;
+    block_p block, last, blocks[4096];
+    heap_p heap;
+    ray_thread_t thread;
+    test_heap_merge_t t = {NULL, NULL, 0};
+
+    thread = ray_thread_create(test_heap_merge_fn, &t);
+    while (__atomic_load_n(&t.heap, __ATOMIC_ACQUIRE) == NULL)
+        backoff_spin(&rounds);
+
+    // freed during a run: handed over to the executor, then freed back here by the merge
+    rc_sync_set(B8_TRUE);
+    heap_free(t.ptr);
+    rc_sync_set(B8_FALSE);
+    heap_merge(t.heap);
+
+    __atomic_store_n(&t.merged, 1, __ATOMIC_RELEASE);
+    TEST_ASSERT(thread_join(thread) == 0, "thread_join");
+
+    // no free block is listed twice or sits inside another one, and the tails are the lists' last blocks
+    heap = heap_get();
+    for (i = MIN_BLOCK_ORDER, n = 0; i <= MAX_POOL_ORDER; i++) {
+        for (block = heap->freelist[i], last = NULL; block != NULL && n < 4096; last = block, block = block->next) {
+            TEST_ASSERT(block->order == i && block->prev == last, "free list is inconsistent");
+            blocks[n++] = block;
+        }
+
+        TEST_ASSERT(block != NULL || heap->freetail[i] == last, "free list tail is not its last block");
+    }
+
+    qsort(blocks, n, sizeof(block_p), test_heap_block_cmp);
+    for (i = 1; i < n; i++)
+        TEST_ASSERT((i64_t)blocks[i - 1] + (1ll << blocks[i - 1]->order) <= (i64_t)blocks[i], "free blocks overlap");
+
+    PASS();
+}
@@ -2482,6 +2482,92 @@ test_result_t test_lang_math() {
     PASS();
 }
 
+test_result_t test_lang_resolve() {
+    i64_t i, j;
+    c8_t buf[64];
+    obj_p names, f;
+    env_t *env;
+
+    TEST_ASSERT_EQ("(set f (fn [x y] (- x y))) (list (f 5 3) (f 3 5))", "(list 2 -2)");
+    TEST_ASSERT_EQ("(set f (fn [x] (do (let x (* x 10)) (+ x 1)))) (f 2)", "21");
+    TEST_ASSERT_EQ("(set f (fn [x] (map (fn [y] (* y 2)) x))) (f [1 2 3])", "[2 4 6]");
+    TEST_ASSERT_EQ("(set f (fn [x] (list x 'x))) (set x 100) (f 1)", "(list 1 'x)");
+    TEST_ASSERT_EQ("(set f (fn [a] (+ a z))) (set z 1) (set z 2) (f 1)", "3");
+
+    for (i = 0; i < 5000; i++) {
+        snprintf(buf, sizeof(buf), "(set v%lld %lld)", i, i);
+        drop_obj(eval_str(buf));
+    }
+
+    TEST_ASSERT_EQ("(set v2500 -1) (list v0 v2500 v4999)", "(list 0 -1 4999)");
+    TEST_ASSERT_ER("(set f (fn [x] (+ x undefined_global))) (f 1)", "undefined symbol");
+
+    // Names replaced bypassing env_set: v0 and v1 swap their values, the stale index must not be used
+    env = &runtime_get()->env;
+    names = copy_obj(AS_LIST(env->variables)[0]);
+    i = find_raw(names, &(i64_t){symbols_intern("v0", 2)});
+    j = find_raw(names, &(i64_t){symbols_intern("v1", 2)});
+    AS_SYMBOL(names)[i] = symbols_intern("v1", 2);
+    AS_SYMBOL(names)[j] = symbols_intern("v0", 2);
+    drop_obj(AS_LIST(env->variables)[0]);
+    AS_LIST(env->variables)[0] = names;
+    TEST_ASSERT_EQ("(list v0 v1 v4999)", "(list 1 0 4999)");
+    TEST_ASSERT_EQ("(set v0 10) (set v5000 5000) (list v0 v1 v5000)", "(list 10 0 5000)");
+
+    // No argument limit, and locals still shadow the arguments
+    TEST_ASSERT_EQ("(set f (fn [a b c d e g h k m] (- m (* h a)))) (f 1 2 3 4 5 6 7 8 9)", "2");
+    TEST_ASSERT_EQ("(set f (fn [a b c d e g h k m] (do (let m 100) (- m k)))) (f 1 2 3 4 5 6 7 8 9)", "92");
+
+    // Argument references are bound in the lambda's own slots, the parse tree atoms are left as parsed
+    TEST_ASSERT_EQ("(set f (fn [x y] (+ x (* y x)))) (f 2 3)", "8");
+    f = *resolve(symbols_intern("f", 1));
+    TEST_ASSERT(AS_LAMBDA(f)->slots != NULL_OBJ, "AS_LAMBDA(f)->slots != NULL_OBJ");
+    TEST_ASSERT(AS_LIST(AS_LAMBDA(f)->body)[1]->attrs == 0, "AS_LIST(AS_LAMBDA(f)->body)[1]->attrs == 0");
+    TEST_ASSERT_EQ("(set f (fn [x] (+ 1 2))) (f 5)", "3");
+    f = *resolve(symbols_intern("f", 1));
+    TEST_ASSERT(AS_LAMBDA(f)->slots == NULL_OBJ, "AS_LAMBDA(f)->slots == NULL_OBJ");
+
+    PASS();
+}
+
+test_result_t test_lang_lambda_flow() {
+    TEST_ASSERT_EQ("(set fib (fn [x] (if (< x 2) x (+ (self (- x 1)) (self (- x 2)))))) (fib 15)", "610");
+    TEST_ASSERT_EQ("(set f (fn [x] (do (if (> x 0) (return 1) 0) 2))) (list (f 1) (f -1))", "(list 1 2)");
+    TEST_ASSERT_EQ("(set f (fn [x] (try (raise \"boom\") (fn [e] 7)))) (f 41)", "7");
+    TEST_ASSERT_EQ("(set f (fn [x y] (if (> x y) (- x y) (+ (* x 2.0) y)))) (list (f 5 3) (f 1.5 2.0))",
+                   "(list 2 5.0)");
+    TEST_ASSERT_EQ("(set f (fn [x] (do (set gg x) (+ gg 1)))) (list (f 3) gg)", "(list 4 3)");
+    TEST_ASSERT_EQ("(set f (fn [x] (+ x 1))) (map f [1 2 3])", "[2 3 4]");
+    TEST_ASSERT_ER("(set f (fn [x] (+ x 2024.03.20))) (f 1.0)", "add: unsupported types: 'f64, 'date");
+    TEST_ASSERT_ER("(fold (fn [x y z] (+ x y)) [1 2 3])", "wrong number of arguments");
+
+    PASS();
+}
+
+test_result_t test_lang_pmap() {
+    TEST_ASSERT_EQ("(set r (map (fn [x] (* x 2)) (til 100000))) (list (type r) (sum r) (at r 99999))",
+                   "(list 'I64 9999900000 199998)");
+    TEST_ASSERT_EQ("(set f (fn [x y] (- x y))) (pmap f [5 6 7] [1 2 3])", "[4 4 4]");
+    TEST_ASSERT_EQ("(pmap (fn [x] (as 'String x)) [1 2 3])", "(list \"1\" \"2\" \"3\")");
+    TEST_ASSERT_EQ("(set f (fn [x] (if (> x 2) x 0.5))) (== (type (map f (til 5))) (type (pmap f (til 5))))", "true");
+    TEST_ASSERT_EQ("(count (pmap (fn [x] (til x)) (til 1000)))", "1000");
+    TEST_ASSERT_EQ("(pmap + [1 2] [3 4])", "[4 6]");
+    TEST_ASSERT_ER("(pmap (fn [x] (+ x 2024.03.20)) [1.0 2.0])", "add: unsupported types");
+    TEST_ASSERT_EQ("(pmap (fn [x] (set gg x)) [1 2 3]) gg", "3");
+
+    // The executors only read globals, however the lambda gets to assign them
+    setup_executors(3);
+
+    TEST_ASSERT_ER("(pmap (fn [x] (set gg x)) (til 8))", "set: globals can only be assigned in main thread");
+    TEST_ASSERT_ER("(set g (fn [x] (set gg (+ x 1)))) (pmap (fn [x] (g x)) (til 10))",
+                   "set: globals can only be assigned in main thread");
+    TEST_ASSERT_ER("(set t (table [a] (list [1]))) (pmap (fn [x] (insert 't (list x))) (til 8))",
+                   "fetch: globals can only be assigned in main thread");
+    TEST_ASSERT_EQ("(set gg 10) (pmap (fn [x] (do (let y (* x 2)) (+ y gg))) (til 4))", "[10 12 14 16]");
+
+    PASS();
+}
+
 test_result_t test_lang_take() {
     TEST_ASSERT_EQ("(take 0h false)", "[]");
     TEST_ASSERT_EQ("(type (take 0i false))", "'B8");
@@ -2734,11 +2820,96 @@ test_result_t test_lang_query() {
         "(set t (table ['a 'b 'c] (list (take 25001 [false true]) (take 25001 [true false]) (take 25001 1)))) (count "
         "(select {c: c from: t where: (and a b)}))",
         "0");
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [1 1 2 2 1] ['x 'y 'x 'x 'y] [10 20 30 40 50])))"
+                   "(select {s: (sum c) from: t by: {a: a b: b} where: (> c 15)})",
+                   "(table [a b s] (list [1 2] ['y 'x] [70 70]))");
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [1 1 2 2 100000000000] ['x 'y 'x 'x 'y] [10 20 30 40 50])))"
+                   "(select {s: (sum c) from: t by: {b: b a: a} where: (> c 15)})",
+                   "(table [b a s] (list ['y 'x 'y] [1 2 100000000000] [20 70 50]))");
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [1.5 1.5 2.5 2.5 1.5] ['x 'y 'x 'x 'y] [10 20 30 40 50])))"
+                   "(select {s: (sum c) from: t by: {a: a b: b}})",
+                   "(table [a b s] (list [1.5 1.5 2.5] ['x 'y 'x] [10 70 70]))");
+    // Nulls next to large values: the span does not fit in i64
+    TEST_ASSERT_EQ("(set t (table [a c v] (list (concat 0Nl 9223372036854775807) [1.5 2.5] [1 2])))"
+                   "(set r (select {s: (sum v) from: t by: {a: a c: c}})) (list (at r 'a) (at r 'c) (at r 's))",
+                   "(list [0Nl 9223372036854775807] [1.5 2.5] [1 2])");
+    TEST_ASSERT_EQ("(set r (select {s: (sum v) from: t by: a})) (list (at r 'a) (at r 's))",
+                   "(list [0Nl 9223372036854775807] [1 2])");
+    TEST_ASSERT_EQ("(set t (table [a c v] (list [0Nl 3 0Nl 3 5] ['x 'x 'x 'y 'x] [1 2 3 4 5])))"
+                   "(set r (select {s: (sum v) from: t by: {a: a c: c}})) (list (at r 'a) (at r 'c) (at r 's))",
+                   "(list [0Nl 3 3 5] ['x 'x 'y 'x] [4 2 4 5])");
+    TEST_ASSERT_EQ("(set n 100000)"
+                   "(set t (table [a b c] (list (* 1000000000007 (% (til n) 36)) (* 60000000000 (% (til n) 1440)) "
+                   "(% (til n) 8))))"
+                   "(count (select {s: (count a) from: t by: {a: a b: b c: c}}))",
+                   "1440");
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [09:00:00.000 09:01:00.000 09:00:00.000 09:01:00.000 09:00:00.000]"
+                   " ['x 'y 'x 'x 'y] [10 20 30 40 50])))"
+                   "(select {s: (sum c) from: t by: {a: a b: b} where: (> c 15)})",
+                   "(table [a b s] (list [09:01:00.000 09:00:00.000 09:01:00.000 09:00:00.000] ['y 'x 'x 'y]"
+                   " [20 30 40 50]))");
+    TEST_ASSERT_EQ("(set t (table [a b c d] (list [2024.01.02 2024.01.01 2024.01.02 2024.01.02] [7i 7i 0Ni 7i]"
+                   " [3h 3h 3h -3h] [1 2 3 4])))"
+                   "(select {s: (sum d) from: t by: {a: a b: b c: c}})",
+                   "(table [a b c s] (list [2024.01.02 2024.01.01 2024.01.02 2024.01.02] [7i 7i 0Ni 7i] [3h 3h 3h -3h]"
+                   " [1 2 3 4]))");
+    TEST_ASSERT_EQ("(set n 100000)"
+                   "(set t (table [a b c] (list (as 'Time (* 60000 (% (til n) 1440))) (as 'I32 (* 1000000 (% (til n) 3)))"
+                   " (as 'Date (% (til n) 5)))))"
+                   "(count (select {s: (count a) from: t by: {a: a b: b c: c}}))",
+                   "1440");
+    TEST_ASSERT_EQ("(set t (table [a c] (list (* 1000000007 (% (til 100000) 3000)) (til 100000))))"
+                   "(set r (select {s: (sum c) n: (count c) from: t by: a}))"
+                   "(list (count r) (sum (at r 's)) (min (at r 'n)) (max (at r 'n)))",
+                   "(list 3000 4999950000 33 34)");
+
+    PASS();
+}
+
+test_result_t test_lang_update() {
+    TEST_ASSERT_EQ("(set t (table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 2 3 4 5])))"
+                   "(update {price: (avg price) from: t by: sym})",
+                   "(table [sym price size] (list ['a 'b 'a 'c 'b] [20.0 35.0 20.0 40.0 35.0] [1 2 3 4 5]))");
+    TEST_ASSERT_EQ("(set t (table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 2 3 4 5])))"
+                   "(update {size: (sum size) from: t where: (> price 15.0) by: sym})",
+                   "(table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 7 3 4 7]))");
+    TEST_ASSERT_EQ("(set t (table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 2 3 4 5])))"
+                   "(update {price: 0.0 from: t where: (> size 3)})",
+                   "(table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 0.0 0.0] [1 2 3 4 5]))");
+    TEST_ASSERT_EQ("(set t (table [sym price size] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 2 3 4 5])))"
+                   "(update {x: (* 2 size) from: t where: (> size 3)})",
+                   "(table [sym price size x] (list ['a 'b 'a 'c 'b] [10.0 20.0 30.0 40.0 50.0] [1 2 3 4 5]"
+                   "[0Nl 0Nl 0Nl 8 10]))");
+    TEST_ASSERT_EQ("(set t (table [g v] (list (% (til 100000) 7) (as 'F64 (til 100000)))))"
+                   "(sum (at (update {v: (max v) from: t by: g}) 'v))",
+                   "9999600000.0");
+    TEST_ASSERT_EQ("(set t (table [g v] (list (% (til 100000) 7) (as 'F64 (til 100000)))))"
+                   "(sum (at (update {w: (count v) from: t where: (> g 3) by: g}) 'w))",
+                   "612212246");
 
     PASS();
 }
 
-test_result_t test_lang_update() { PASS(); }
+test_result_t test_lang_insert() {
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [1] [1.0] ['x]))) (insert 't (list 2 2.0 'y)) t",
+                   "(table [a b c] (list [1 2] [1.0 2.0] ['x 'y]))");
+    TEST_ASSERT_EQ("(set t (table [a b c] (list [1] [1.0] ['x]))) (insert 't (list [2 3] [2.0 3.0] ['y 'z])) t",
+                   "(table [a b c] (list [1 2 3] [1.0 2.0 3.0] ['x 'y 'z]))");
+    TEST_ASSERT_EQ("(set t (table [a b] (list [1i] [2024.01.01]))) (insert 't (list 2i 2024.01.02)) t",
+                   "(table [a b] (list [1i 2i] [2024.01.01 2024.01.02]))");
+    TEST_ASSERT_EQ("(set t (table [a b] (list [1i] [2024.01.01]))) (insert 't (list [2i 3i] [2024.01.02 2024.01.03])) t",
+                   "(table [a b] (list [1i 2i 3i] [2024.01.01 2024.01.02 2024.01.03]))");
+    TEST_ASSERT_EQ("(set t (table [a b] (list [0] [0.0]))) (map (fn [i] (insert 't (list i 1.0))) (til 100000))"
+                   "(list (count t) (sum (at t 'a)) (sum (at t 'b)))",
+                   "(list 100001 4999950000 100000.0)");
+    // A column past the pool block sizes keeps the capacity reserved by previous inserts
+    TEST_ASSERT_EQ("(set t (table [a] (list (til 5000000)))) (map (fn [i] (insert 't (list i))) (til 10000))"
+                   "(list (count t) (sum (at t 'a)) (last (at t 'a)))",
+                   "(list 5010000 12500047495000 9999)");
+    TEST_ASSERT_ER("(set t (table [a b] (list [0] [0.0]))) (insert 't (list 1.0 1.0))", "insert: expected");
+
+    PASS();
+}
 
 test_result_t test_lang_serde() {
     TEST_ASSERT_EQ("(de (ser null))", "null");
@@ -3230,6 +3401,9 @@ test_result_t test_lang_distinct() {
     TEST_ASSERT_EQ("(distinct ['a 'b 'ab 'aa 'a 'aa])", "['a 'b 'ab 'aa]");
     TEST_ASSERT_EQ("(set l (guid 2)) (set l (concat l l)) (count (distinct l))", "2");
     TEST_ASSERT_EQ("(distinct (list [3i 3i] 2i [3i 3i] 2i))", "(list 2i [3i 3i])");
+    TEST_ASSERT_EQ("(distinct (* 1000000007 [3 1 3 2 1]))", "[3000000021 1000000007 2000000014]");
+    TEST_ASSERT_EQ("(set l (* 1000000007 (% (til 100000) 3000))) (list (count (distinct l)) (at (distinct l) 2999))",
+                   "(list 3000 2999000020993)");
 
     PASS();
 }
@@ -3394,6 +3568,38 @@ test_result_t test_lang_in() {
     TEST_ASSERT_EQ("(set l (guid 2)) (in (list (first l)) l)", "(list true)");
     TEST_ASSERT_EQ("(set l (guid 2)) (in (list (first l)) (list l))", "(list false)");
     TEST_ASSERT_EQ("(set l (guid 2)) (in (list (first l)) (list (first l)))", "(list true)");
+    TEST_ASSERT_EQ("(in (* 1000000007 [2 5 3 1]) (* 1000000007 [3 1 3 2]))", "[true false true true]");
+    TEST_ASSERT_EQ("(find (* 1000000007 [3 1 3 2 1]) (* 1000000007 [2 5 3]))", "[3 0Nl 0]");
+    PASS();
+}
+
+test_result_t test_lang_enum() {
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (== (enum 's ['b 'a 'c 'b 'a]) 'b)", "[true false false true false]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (!= 'b (enum 's ['b 'a 'c 'b 'a]))", "[false true true false true]");
+    // Ordering against symbols follows the strings, not the order the symbols were interned in
+    TEST_ASSERT_EQ("(set s ['zc 'za 'zb]) (> (enum 's ['zb 'za 'zc 'zb 'za]) 'zb)", "[false false true false false]");
+    TEST_ASSERT_EQ("(set s ['zc 'za 'zb]) (>= 'zb (enum 's ['zb 'za 'zc 'zb 'za]))", "[true true false true true]");
+    TEST_ASSERT_EQ("(set s ['zc 'za 'zb]) (< (enum 's ['zb 'za 'zc 'zb 'za]) ['za 'zb 'zb 'zc 'za])",
+                   "[false true false true false]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (== (enum 's ['b 'a 'c 'b 'a]) ['b 'b 'b 'a 'a])",
+                   "[true false false false true]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (in (enum 's ['b 'a 'c 'b 'a]) ['a 'c])", "[false true true false true]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (< (enum 's ['b 'a 'c 'b 'a]) 'b)", "[false true false false true]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (iasc (enum 's ['b 'a 'c 'b 'a]))", "[1 4 0 3 2]");
+    TEST_ASSERT_EQ("(set s ['c 'a 'b]) (idesc (enum 's ['b 'a 'c 'b 'a]))", "[2 0 3 1 4]");
+    TEST_ASSERT_EQ(
+        "(set s ['c 'a 'b]) (set t (table [k v] (list (enum 's ['b 'a 'c 'b 'a]) [1 2 3 4 5])))"
+        "(at (xasc t 'k) 'v)",
+        "[2 5 1 4 3]");
+    TEST_ASSERT_EQ(
+        "(set s ['c 'a 'b]) (set t (table [k v] (list (enum 's ['b 'a 'c 'b 'a]) [1 2 3 4 5])))"
+        "(at (select {v: (sum v) from: t by: k}) 'v)",
+        "[5 7 3]");
+    TEST_ASSERT_EQ(
+        "(set s ['c 'a 'b]) (set t (table [k v] (list (enum 's ['b 'a 'c 'b 'a]) [1 2 3 4 5])))"
+        "(at (select {from: t where: (== k 'a)}) 'v)",
+        "[2 5]");
+
     PASS();
 }
 
@@ -3466,3 +3672,150 @@ test_result_t test_lang_bin() {
     
     PASS();
 }
+
+test_result_t test_lang_advise() {
+    c8_t path[128], expr[160];
+
+    snprintf(path, sizeof(path), "\"%s/advise_vec\"", setup_tmpdir());
+    snprintf(expr, sizeof(expr), "(set p %s)", path);
+    TEST_ASSERT_EQ(expr, path);
+    snprintf(expr, sizeof(expr), "(set %s (til 10))", path);
+    TEST_ASSERT_EQ(expr, "p");
+    TEST_ASSERT_EQ("(advise (get p) 'willneed)", "(til 10)");
+    TEST_ASSERT_EQ("(advise (get p) [sequential populate])", "(til 10)");
+    TEST_ASSERT_EQ("(sum (advise (get p) 'huge))", "45");
+    TEST_ASSERT_EQ("(advise (table [a] (list (get p))) 'normal)", "(table [a] (list (til 10)))");
+    TEST_ASSERT_EQ("(advise [1 2 3] 'willneed)", "[1 2 3]");
+    TEST_ASSERT_ER("(advise [1 2 3] 'often)", "advise: unknown hint");
+    PASS();
+}
+test_result_t test_lang_select_mapped() {
+    c8_t path[128];
+
+    snprintf(path, sizeof(path), "(set p \"%s/loader_tab/\")", setup_tmpdir());
+    TEST_ASSERT_EQ(path, "p");
+    TEST_ASSERT_EQ("(set-splayed p (table [a b] (list (til 100000) (% (til 100000) 10))))", "p");
+    TEST_ASSERT_EQ("(set t (get-splayed p))", "(table [a b] (list (til 100000) (% (til 100000) 10)))");
+    TEST_ASSERT_EQ("(select {s: (sum a) from: t where: (== b 3)})", "(table [s] (list [499980000]))");
+    TEST_ASSERT_EQ("(count (select {from: t where: (< a 10)}))", "10");
+    TEST_ASSERT_EQ("(set t 0)", "0");
+    PASS();
+}
+
+test_result_t test_lang_moving() {
+    TEST_ASSERT_EQ("(msum 3 [1 2 3 4 5 6])", "[1 3 6 9 12 15]");
+    TEST_ASSERT_EQ("(msum 2 [1.0 0Nf 3.0 4.0])", "[1.0 1.0 3.0 7.0]");
+    TEST_ASSERT_EQ("(mavg 2 [1 0Nl 3 4])", "[1.0 1.0 3.0 3.5]");
+    TEST_ASSERT_EQ("(mmin 3 [5 3 4 1 2 6 7])", "[5 3 3 1 1 1 2]");
+    TEST_ASSERT_EQ("(mmax 3 [5 3 4 1 2 6 7])", "[5 5 5 4 4 6 7]");
+    TEST_ASSERT_EQ("(mmax 2 [0Nl 0Nl 3 0Nl 0Nl])", "[0Nl 0Nl 3 3 0Nl]");
+    TEST_ASSERT_EQ("(mdev 2 [1 3 3 7])", "[0.0 1.0 0.0 2.0]");
+    TEST_ASSERT_EQ("(ema 0.5 [1.0 2.0 3.0 4.0])", "[1.0 1.5 2.25 3.125]");
+    TEST_ASSERT_EQ("(ema 3 [0Nl 1 2 3 4])", "[0Nf 1.0 1.5 2.25 3.125]");
+    TEST_ASSERT_EQ("(msum 3 (list [1 2 3] [10 20 30 40]))", "(list [1 3 6] [10 30 60 90])");
+    TEST_ASSERT_EQ("(set t (table [s p] (list [a b a b a b] [1 10 2 20 3 30])))",
+                   "(table [s p] (list [a b a b a b] [1 10 2 20 3 30]))");
+    TEST_ASSERT_EQ("(select {m: (msum 2 p) x: (mmax 2 p) from: t by: s})",
+                   "(table [s m x] (list [a b] (list [1 3 5] [10 30 50]) (list [1 2 3] [10 20 30])))");
+    TEST_ASSERT_EQ("(set t 0)", "0");
+    TEST_ASSERT_EQ("(at (msum 10 (til 1000000)) 999999)", "9999945");
+    TEST_ASSERT_EQ("(at (mmin 10 (til 1000000)) 999999)", "999990");
+    TEST_ASSERT_ER("(msum 0 [1 2])", "msum: window must be positive");
+    TEST_ASSERT_ER("(mavg 2 ['a 'b])", "mavg: unsupported type");
+    TEST_ASSERT_ER("(ema 1.5 [1 2])", "ema: smoothing factor");
+
+    PASS();
+}
+
+test_result_t test_lang_scans() {
+    TEST_ASSERT_EQ("(sums [1 2 3 0Nl 4])", "[1 3 6 6 10]");
+    TEST_ASSERT_EQ("(prds [1.0 2.0 0Nf 4.0])", "[1.0 2.0 2.0 8.0]");
+    TEST_ASSERT_EQ("(mins [3 1 0Nl 2 0])", "[3 1 1 1 0]");
+    TEST_ASSERT_EQ("(maxs [0Nl 1 3 2 5])", "[0Nl 1 3 3 5]");
+    TEST_ASSERT_EQ("(deltas [1 4 9 0Nl 25])", "[1 3 5 0Nl 0Nl]");
+    TEST_ASSERT_EQ("(ratios [1 2 6 24])", "[1.0 2.0 3.0 4.0]");
+    TEST_ASSERT_EQ("(fills [0Nl 1 0Nl 0Nl 3 0Nl])", "[0Nl 1 1 1 3 3]");
+    TEST_ASSERT_EQ("(sums (list [1 2] [3 4]))", "(list [1 3] [3 7])");
+    TEST_ASSERT_EQ("(set t (table [s p] (list [a b a b a b c] [1 10 2 20 3 30 7])))",
+                   "(table [s p] (list [a b a b a b c] [1 10 2 20 3 30 7]))");
+    TEST_ASSERT_EQ("(select {c: (sums p) d: (deltas p) from: t by: s})",
+                   "(table [s c d] (list [a b c] (list [1 3 6] [10 30 60] [7]) (list [1 1 1] [10 10 10] [7])))");
+    TEST_ASSERT_EQ("(select {c: (sums p) from: t where: (> p 1) by: s})",
+                   "(table [s c] (list [b a c] (list [10 30 60] [2 5] [7])))");
+    TEST_ASSERT_EQ("(set t 0)", "0");
+    TEST_ASSERT_EQ("(at (sums (til 1000000)) 999999)", "499999500000");
+    TEST_ASSERT_EQ("(sum (deltas (til 1000000)))", "999999");
+    TEST_ASSERT_EQ("(at (fills (concat (take 600000 [1]) (take 400000 [0Nl]))) 999999)", "1");
+    TEST_ASSERT_ER("(sums ['a 'b])", "sums: unsupported type");
+
+    PASS();
+}
+
+test_result_t test_lang_join_sides() {
+    TEST_ASSERT_EQ(
+        "(set quotes (table [Sym Ts Bid] (list [AAPL MSFT AAPL MSFT AAPL]"
+        " [09:00:00.000 09:00:00.000 09:00:01.000 09:00:02.000 09:00:03.000] [1 2 3 4 5])))"
+        "(set trades (table [Sym Ts] (list [AAPL GOOG MSFT AAPL MSFT]"
+        " [08:00:00.000 09:00:00.001 09:00:01.500 09:00:05.000 09:00:09.000])))"
+        "(at (asof-join [Sym Ts] trades quotes) 'Bid)",
+        "[0Nl 0Nl 2 5 4]");
+    TEST_ASSERT_EQ("(set w (map-left + [-2000 0] (at trades 'Ts)))"
+                   "(set r (window-join [Sym Ts] w trades quotes {s: (sum Bid) c: (count Bid)}))"
+                   "(list (at r 's) (at r 'c))",
+                   "(list [0Nl 0Nl 2 5 4] [0 0 1 1 1])");
+    TEST_ASSERT_EQ("(set r (window-join1 [Sym Ts] w trades quotes {s: (sum Bid) c: (count Bid)}))"
+                   "(list (at r 's) (at r 'c))",
+                   "(list [0Nl 0Nl 2 5 0Nl] [0 0 1 1 0])");
+    // The sorted right side is reused while quotes is unchanged, and rebuilt once it changes
+    TEST_ASSERT_EQ("(insert 'quotes (list 'MSFT 09:00:08.000 6)) (at (asof-join [Sym Ts] trades quotes) 'Bid)",
+                   "[0Nl 0Nl 2 5 6]");
+    TEST_ASSERT_EQ("(set r (window-join [Sym Ts] w trades quotes {s: (sum Bid)})) (at r 's)", "[0Nl 0Nl 2 5 10]");
+    TEST_ASSERT_EQ("(set quotes (table [Sym Ts Bid] (list [MSFT AAPL] [09:00:00.000 09:00:00.000] [7 8])))"
+                   "(at (asof-join [Sym Ts] trades quotes) 'Bid)",
+                   "[0Nl 0Nl 7 8 7]");
+    // The side goes with the last reference to its table
+    TEST_ASSERT(runtime_get()->joins->len == 1, "runtime_get()->joins->len == 1");
+    TEST_ASSERT_EQ("(set quotes 0) (count trades)", "5");
+    TEST_ASSERT(runtime_get()->joins->len == 0, "runtime_get()->joins->len == 0");
+
+    PASS();
+}
+
+test_result_t test_lang_window_sliding() {
+    // Overlapping windows over unsorted trades, walked in window start order with executors
+    setup_executors(3);
+
+    TEST_ASSERT_EQ(
+        "(set quotes (table [Sym Ts Bid] (list [A B A B A B A]"
+        " [09:00:01.000 09:00:02.000 09:00:03.000 09:00:04.000 09:00:05.000 09:00:06.000 09:00:07.000]"
+        " [5 1 3 0Nl 2 4 7])))"
+        "(set trades (table [Sym Ts] (list [A B A B]"
+        " [09:00:06.500 09:00:04.500 09:00:03.500 09:00:07.500])))"
+        "(set w (map-left + [-3000 0] (at trades 'Ts)))"
+        "(set r (window-join [Sym Ts] w trades quotes {s: (sum Bid) a: (min Bid) b: (max Bid) c: (count Bid)}))"
+        "(list (at r 's) (at r 'a) (at r 'b) (at r 'c))",
+        "(list [5 0Nl 8 0Nl] [2 1 3 4] [3 1 5 4] [2 2 2 2])");
+    TEST_ASSERT_EQ("(set r (window-join1 [Sym Ts] w trades quotes {s: (sum Bid) a: (min Bid) b: (max Bid) c: (count Bid)}))"
+                   "(list (at r 's) (at r 'a) (at r 'b) (at r 'c))",
+                   "(list [2 0Nl 8 4] [2 1 3 4] [2 1 5 4] [1 2 2 1])");
+    TEST_ASSERT_ER("(window-join [Sym Ts] (list [09:00:00.000] [09:00:01.000]) trades quotes {s: (sum Bid)})",
+                   "window-join: windows must be two vectors of the join column type");
+
+    PASS();
+}
+
+test_result_t test_lang_group_ranged() {
+    // High-cardinality grouping with executors: rows are partitioned by group id range
+    setup_executors(3);
+
+    TEST_ASSERT_EQ("(set t (table [k p] (list (% (til 300000) 150000) (til 300000))))"
+                   "(set r (select {s: (sum p) m: (min p) x: (max p) c: (count p) from: t by: k}))"
+                   "(count r)",
+                   "150000");
+    TEST_ASSERT_EQ("(sum (at r 's))", "44999850000");
+    TEST_ASSERT_EQ("(count (where (== (at r 's) (+ 150000 (* 2 (at r 'k))))))", "150000");
+    TEST_ASSERT_EQ("(at r 123456)", "{k: 123456 s: 396912 m: 123456 x: 273456 c: 2}");
+    TEST_ASSERT_EQ("(sum (at (select {s: (sum p) from: t where: (> p 200000) by: k}) 's))", "24999750000");
+
+    PASS();
+}
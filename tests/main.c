@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <ftw.h>
 #include "../core/rayforce.h"
 #include "../core/format.h"
 #include "../core/unary.h"
@@ -32,11 +33,13 @@
 #include "../core/eval.h"
 #include "../core/hash.h"
 #include "../core/symbols.h"
+#include "../core/fs.h"
 #include "../core/string.h"
 #include "../core/util.h"
 #include "../core/parse.h"
 #include "../core/runtime.h"
 #include "../core/cmp.h"
+#include "../core/atomic.h"
 #include "../core/eval.h"
 
 typedef enum test_status_t { TEST_PASS = 0, TEST_FAIL } test_status_t;
@@ -65,11 +68,45 @@ nil_t setup() {
     // heap_create(0);
 }
 
+// Scratch directory of the running test, empty when it has none
+c8_t test_tmpdir[64] = {0};
+
+static i32_t remove_entry(lit_p path, const struct stat *st, i32_t flag, struct FTW *ftw) {
+    UNUSED(st);
+    UNUSED(flag);
+    UNUSED(ftw);
+    return remove(path);
+}
+
 nil_t teardown() {
+    // executors a test has set up are taken down even if it returned early on a failure
+    if (runtime_get()->pool != NULL) {
+        pool_destroy(runtime_get()->pool);
+        runtime_get()->pool = NULL;
+    }
+
+    // so is the scratch directory, with whatever the test has written there
+    if (test_tmpdir[0] != '\0') {
+        nftw(test_tmpdir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+        test_tmpdir[0] = '\0';
+    }
+
     runtime_destroy();
     // heap_destroy();
 }
 
+// Runs the rest of a test with n executors, teardown takes them down
+nil_t setup_executors(i64_t n) { runtime_get()->pool = pool_create(n); }
+
+// Creates a directory unique to this run for the test to write into, teardown removes it
+lit_p setup_tmpdir() {
+    strcpy(test_tmpdir, "/tmp/rf_test_XXXXXX");
+    if (mkdtemp(test_tmpdir) == NULL)
+        test_tmpdir[0] = '\0';
+
+    return test_tmpdir;
+}
+
 #define PASS() \
     return (test_result_t) { TEST_PASS, NULL }
 #define FAIL(msg) \
@@ -160,6 +197,7 @@ nil_t on_fail(str_p msg) {
 // Include tests files
 #include "heap.c"
 #include "hash.c"
+#include "symbols.c"
 #include "string.c"
 #include "env.c"
 #include "sort.c"
@@ -180,19 +218,34 @@ test_entry_t tests[] = {
     {"test_realloc_same_size", test_realloc_same_size},
     {"test_alloc_dealloc_stress", test_alloc_dealloc_stress},
     {"test_allocate_and_free_obj", test_allocate_and_free_obj},
+    {"test_heap_slab", test_heap_slab},
+    {"test_heap_large", test_heap_large},
+    {"test_heap_cap", test_heap_cap},
+    {"test_heap_remote", test_heap_remote},
+    {"test_heap_merge", test_heap_merge},
     {"test_hash", test_hash},
+    {"test_hash_sw", test_hash_sw},
+    {"test_symbols_rebuild", test_symbols_rebuild},
+    {"test_symbols_bulk", test_symbols_bulk},
+    {"test_symbols_image", test_symbols_image},
+    {"test_symbols_rank", test_symbols_rank},
     {"test_env", test_env},
     {"test_sort_asc", test_sort_asc},
     {"test_sort_desc", test_sort_desc},
     {"test_asc_desc", test_asc_desc},
     {"test_sort_xasc", test_sort_xasc},
     {"test_sort_xdesc", test_sort_xdesc},
+    {"test_sort_xtake", test_sort_xtake},
     {"test_str_match", test_str_match},
     {"test_lang_basic", test_lang_basic},
     {"test_lang_math", test_lang_math},
+    {"test_lang_resolve", test_lang_resolve},
+    {"test_lang_lambda_flow", test_lang_lambda_flow},
+    {"test_lang_pmap", test_lang_pmap},
     {"test_lang_take", test_lang_take},
     {"test_lang_query", test_lang_query},
     {"test_lang_update", test_lang_update},
+    {"test_lang_insert", test_lang_insert},
     {"test_lang_serde", test_lang_serde},
     {"test_lang_literals", test_lang_literals},
     {"test_lang_cmp", test_lang_cmp},
@@ -202,10 +255,18 @@ test_entry_t tests[] = {
     {"test_lang_concat", test_lang_concat},
     {"test_lang_filter", test_lang_filter},
     {"test_lang_in", test_lang_in},
+    {"test_lang_enum", test_lang_enum},
     {"test_lang_except", test_lang_except},
     {"test_lang_or", test_lang_or},
     {"test_lang_and", test_lang_and},
     {"test_lang_bin", test_lang_bin},
+    {"test_lang_advise", test_lang_advise},
+    {"test_lang_select_mapped", test_lang_select_mapped},
+    {"test_lang_moving", test_lang_moving},
+    {"test_lang_scans", test_lang_scans},
+    {"test_lang_group_ranged", test_lang_group_ranged},
+    {"test_lang_join_sides", test_lang_join_sides},
+    {"test_lang_window_sliding", test_lang_window_sliding},
 };
 // ---
 
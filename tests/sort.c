@@ -76,6 +76,10 @@ test_result_t test_sort_asc() {
     TEST_ASSERT_EQ("(iasc [-1.0 2.0 -3.0 4.0 0.0 0Nf])", "[5 2 0 4 1 3]");
     TEST_ASSERT_EQ("(asc [-1.0 2.0 -3.0 4.0 0.0 0Nf])", "[0Nf -3.0 -1.0 0.0 2.0 4.0]");
 
+    // Large vectors take the chunked radix path
+    TEST_ASSERT_EQ("(take 3 (iasc (as 'I64 (as 'F64 (% (til 100000) 1000)))))", "[0 1000 2000]");
+    TEST_ASSERT_EQ("(take 3 (idesc (as 'F64 (% (til 100000) 1000))))", "[999 1999 2999]");
+
     TEST_ASSERT_EQ("(iasc [])", "[]");
     TEST_ASSERT_EQ("(asc [])", "[]");
 
@@ -215,6 +219,12 @@ test_result_t test_sort_xasc() {
         "(table ['sym 'time 'price] (list ['AAPL 'AAPL 'GOOG] [09:30:00.000 10:30:00.000 11:00:00.000] [140.0 150.5 "
         "2800.0]))");
 
+    // Test sorting by packed keys of mixed types
+    TEST_ASSERT_EQ("(xasc (table [s p] (list ['b 'a 'b 'a] [2.5 -1.0 -3.0 0.5])) [s p])",
+                   "(table [s p] (list ['a 'a 'b 'b] [-1.0 0.5 -3.0 2.5]))");
+    TEST_ASSERT_EQ("(take 3 (at (xasc (table [a b] (list (% (til 100000) 7) (neg (til 100000)))) [a b]) 'b))",
+                   "[-99995 -99988 -99981]");
+
     // Test sorting by empty vector of symbols [] - should return original table
     TEST_ASSERT_EQ(
         "(xasc (table ['sym 'time 'price] (list ['AAPL 'GOOG 'MSFT] [10:30:00.000 09:30:00.000 11:00:00.000] [150.5 "
@@ -270,6 +280,18 @@ test_result_t test_sort_xdesc() {
         "(table ['sym 'time 'price] (list ['GOOG 'AAPL 'AAPL] [11:00:00.000 10:30:00.000 09:30:00.000] [2800.0 150.5 "
         "140.0]))");
 
+    // Test sorting by packed keys of mixed types in descending order
+    TEST_ASSERT_EQ("(xdesc (table [s p] (list ['b 'a 'b 'a] [2.5 -1.0 -3.0 0.5])) [s p])",
+                   "(table [s p] (list ['b 'b 'a 'a] [2.5 -3.0 0.5 -1.0]))");
+    TEST_ASSERT_EQ("(take 3 (at (xdesc (table [a b] (list (% (til 100000) 7) (neg (til 100000)))) [a b]) 'b))",
+                   "[-6 -13 -20]");
+
+    // Test sorting by a key column spanning all the 64 bits next to a constant one
+    TEST_ASSERT_EQ("(xasc (table [a b] (list [9223372036854775807 -9223372036854775807 0 5] [1 1 1 1])) [b a])",
+                   "(table [a b] (list [-9223372036854775807 0 5 9223372036854775807] [1 1 1 1]))");
+    TEST_ASSERT_EQ("(xdesc (table [a b] (list [9223372036854775807 -9223372036854775807 0 5] [1 1 1 1])) [b a])",
+                   "(table [a b] (list [9223372036854775807 5 0 -9223372036854775807] [1 1 1 1]))");
+
     // Test sorting by empty vector of symbols [] - should return original table
     TEST_ASSERT_EQ(
         "(xdesc (table ['sym 'time 'price] (list ['AAPL 'GOOG 'MSFT] [10:30:00.000 09:30:00.000 11:00:00.000] [150.5 "
@@ -280,6 +302,28 @@ test_result_t test_sort_xdesc() {
     PASS();
 }
 
+test_result_t test_sort_xtake() {
+    TEST_ASSERT_EQ("(xasc-take (table [a b] (list [3 1 2 1] [30 10 20 0])) 'a 2)", "(table [a b] (list [1 1] [10 0]))");
+    TEST_ASSERT_EQ("(xdesc-take (table [a b] (list [3 1 2 1] [30 10 20 0])) 'a 2)",
+                   "(table [a b] (list [3 2] [30 20]))");
+    TEST_ASSERT_EQ("(xdesc-take (table [s p] (list ['b 'a 'b 'a] [2.5 -1.0 -3.0 0.5])) [s p] 3)",
+                   "(table [s p] (list ['b 'b 'a] [2.5 -3.0 0.5]))");
+
+    // Counts outside of the table fall back to take of the full sort
+    TEST_ASSERT_EQ("(xasc-take (table [a b] (list [3 1 2] [30 10 20])) 'a -2)", "(table [a b] (list [2 3] [20 30]))");
+    TEST_ASSERT_EQ("(xasc-take (table [a b] (list [3 1 2] [30 10 20])) 'a 4)",
+                   "(table [a b] (list [1 2 3 1] [10 20 30 10]))");
+
+    // Bounded heaps per chunk on a large table
+    TEST_ASSERT_EQ(
+        "(set t (table [a b] (list (as 'I64 (as 'F64 (% (til 100000) 1000))) (til 100000))))"
+        "(== (at (xdesc-take t 'a 50) 'b) (at (take 50 (xdesc t 'a)) 'b))",
+        "(take 50 true)");
+    TEST_ASSERT_ER("(xasc-take (table [a] (list [1 2])) 'a)", "expected 3 arguments");
+
+    PASS();
+}
+
 test_result_t test_sort_timsort_symbols() {
     TEST_ASSERT_EQ("(iasc (list 'zebra 'apple 'banana 'cherry))", "[1 2 3 0]");
     TEST_ASSERT_EQ("(asc (list 'zebra 'apple 'banana 'cherry))", "(list 'apple 'banana 'cherry 'zebra)");
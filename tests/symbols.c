@@ -0,0 +1,163 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+test_result_t test_symbols_rebuild() {
+    i64_t i, n, count, size, ids[1000];
+    c8_t buf[32];
+    symbols_p symbols = runtime_get()->symbols;
+
+    for (i = 0; i < 1000; i++) {
+        n = snprintf(buf, sizeof(buf), "sym%lld", i);
+        ids[i] = symbols_intern(buf, n);
+    }
+
+    count = symbols_count(symbols);
+    size = symbols->table->size;
+
+    symbols_rebuild(symbols);
+    TEST_ASSERT(symbols->table->size == size * 2, "symbols_rebuild: table is not doubled");
+    TEST_ASSERT(symbols->table->next == NULL, "symbols_rebuild: rebuild is not finished");
+    TEST_ASSERT(symbols_count(symbols) == count, "symbols_rebuild: count is changed");
+
+    for (i = 0; i < 1000; i++) {
+        n = snprintf(buf, sizeof(buf), "sym%lld", i);
+        TEST_ASSERT(symbols_intern(buf, n) == ids[i], "symbols_rebuild: symbol is lost");
+    }
+
+    TEST_ASSERT(symbols_intern("fresh", 5) != NULL_I64, "symbols_rebuild: intern after rebuild");
+    TEST_ASSERT(symbols_count(symbols) == count + 1, "symbols_rebuild: count after rebuild");
+
+    PASS();
+}
+
+test_result_t test_symbols_bulk() {
+    i64_t i, lens[3], ids[3];
+    lit_p strs[3] = {"alpha", "beta", "alpha"};
+
+    for (i = 0; i < 3; i++)
+        lens[i] = strlen(strs[i]);
+
+    symbols_intern_bulk(strs, lens, 3, ids);
+    TEST_ASSERT(ids[0] == ids[2], "symbols_intern_bulk: duplicates are not interned once");
+    TEST_ASSERT(ids[1] == symbols_intern("beta", 4), "symbols_intern_bulk: wrong symbol");
+
+    symbols_intern_bulk(strs, NULL, 3, ids);
+    TEST_ASSERT(ids[0] == symbols_intern("alpha", 5), "symbols_intern_bulk: zero terminated");
+
+    TEST_ASSERT_EQ("(set s (as 'Symbol (map (fn [x] (as 'String x)) (til 100000)))) (list (count (distinct s)) (at s 12345))",
+                   "(list 100000 '12345)");
+    TEST_ASSERT_EQ("(as 'Symbol (list \"a\" \"bb\" \"a\"))", "['a 'bb 'a]");
+
+    PASS();
+}
+
+test_result_t test_symbols_image() {
+    i64_t i, n, count;
+    c8_t buf[32];
+    obj_p sym, res;
+    lit_p path = "/tmp/rayforce_test_sym.idx";
+    symbols_p symbols = runtime_get()->symbols;
+
+    sym = SYMBOL(100);
+    for (i = 0; i < 100; i++) {
+        n = snprintf(buf, sizeof(buf), "img%lld", i);
+        AS_SYMBOL(sym)[i] = symbols_intern(buf, n);
+    }
+
+    AS_SYMBOL(sym)[7] = NULL_I64;
+    count = symbols_count(symbols);
+
+    res = symbols_save(path, sym, 42, 0xfeed);
+    TEST_ASSERT(res == NULL_OBJ, "symbols_save: image is not saved");
+    TEST_ASSERT(symbols_load(path, 41, 0xfeed) == NULL_OBJ, "symbols_load: stale image is loaded");
+    // a sym file rewritten with the same size
+    TEST_ASSERT(symbols_load(path, 42, 0xbeef) == NULL_OBJ, "symbols_load: image of other contents is loaded");
+
+    res = symbols_load(path, 42, 0xfeed);
+    fs_fdelete(path);
+
+    TEST_ASSERT(res != NULL_OBJ && res->type == TYPE_SYMBOL && res->len == 100, "symbols_load: image is not loaded");
+    TEST_ASSERT(symbols_count(symbols) == count, "symbols_load: count is changed");
+
+    for (i = 0; i < 100; i++)
+        TEST_ASSERT(AS_SYMBOL(res)[i] == AS_SYMBOL(sym)[i], "symbols_load: symbol id is changed");
+
+    TEST_ASSERT(symbols_intern("img99", 5) == AS_SYMBOL(sym)[99], "symbols_load: intern after load");
+    TEST_ASSERT(symbols_intern("img_fresh", 9) != NULL_I64, "symbols_load: fresh intern after load");
+    TEST_ASSERT(symbols_count(symbols) == count + 1, "symbols_load: count after load");
+
+    drop_obj(sym);
+    drop_obj(res);
+
+    PASS();
+}
+
+test_result_t test_symbols_rank() {
+    i64_t i, a, b, c, d, e;
+    symbols_p symbols = runtime_get()->symbols;
+
+    b = symbols_intern("rank_b", 6);
+    d = symbols_intern("rank_d", 6);
+    symbols_rank(symbols);
+    TEST_ASSERT(SYMBOL_RANK(b) < SYMBOL_RANK(d), "symbols_rank: wrong order");
+
+    // symbols interned since are merged into the order of the previous call
+    c = symbols_intern("rank_c", 6);
+    a = symbols_intern("rank_a", 6);
+    symbols_rank(symbols);
+    TEST_ASSERT(SYMBOL_RANK(a) < SYMBOL_RANK(b) && SYMBOL_RANK(b) < SYMBOL_RANK(c) && SYMBOL_RANK(c) < SYMBOL_RANK(d),
+                "symbols_rank: fresh symbols are out of order");
+    TEST_ASSERT(SYMBOL_RANK(NULL_I64) == 0, "symbols_rank: null is not ranked first");
+
+    for (i = 1; i < symbols->rank_count; i++) {
+        TEST_ASSERT(strcmp((str_p)symbols->rank_order[i - 1], (str_p)symbols->rank_order[i]) <= 0,
+                    "symbols_rank: pool is out of order");
+        TEST_ASSERT(SYMBOL_RANK(symbols->rank_order[i]) == i + 1, "symbols_rank: wrong rank");
+    }
+
+    // the entries keep just their length, ranks live apart
+    TEST_ASSERT(*((u32_t *)(a - sizeof(u32_t))) == 6 && a % 8 == 4, "symbols_rank: entry layout");
+
+    // no ranking in a parallel section: fresh symbols are unranked and compared by their strings
+    rc_sync_set(B8_TRUE);
+    e = symbols_intern("rank_0", 6);
+    symbols_rank(symbols);
+    rc_sync_set(B8_FALSE);
+    TEST_ASSERT(SYMBOL_RANK(e) == 0 && SYMBOL_RANK(a) != 0, "symbols_rank: ranked in a parallel section");
+    TEST_ASSERT(symbols_cmp(symbols, e, a) < 0 && symbols_cmp(symbols, d, e) > 0 &&
+                    symbols_cmp(symbols, NULL_I64, e) < 0,
+                "symbols_rank: unranked symbols are out of order");
+    symbols_rank(symbols);
+    TEST_ASSERT(SYMBOL_RANK(e) != 0 && SYMBOL_RANK(e) < SYMBOL_RANK(a), "symbols_rank: not ranked after");
+
+    TEST_ASSERT_EQ("(< ['pear 'apple 'zoo] 'kiwi)", "[false true false]");
+    TEST_ASSERT_EQ("(>= 'kiwi ['pear 'apple 'kiwi])", "[false true true]");
+    TEST_ASSERT_EQ("(iasc ['pear 'apple 'zoo 'fig 'apple])", "[1 4 3 0 2]");
+    TEST_ASSERT_EQ("(set s (as 'Symbol (map (fn [x] (as 'String x)) (til 1000)))) (count (where (< s '5)))", "445");
+    TEST_ASSERT_EQ("(set s (as 'Symbol (map (fn [x] (as 'String x)) (til 1000)))) (at s (take 3 (iasc s)))",
+                   "['0 '1 '10]");
+    TEST_ASSERT_EQ("(set s (as 'Symbol (map (fn [x] (as 'String x)) (til 1000)))) (at s (take 3 (idesc s)))",
+                   "['999 '998 '997]");
+
+    PASS();
+}